@@ -134,7 +134,14 @@ typedef enum {
     /* Note: if you're hunting for a flag, some day in the future when we
      * have used them all, this one is easy enough to eliminate by having the
      * tiny number of objects marked this way in a remembered set. */
-    MVM_CF_NEVER_REPOSSESS = 2048
+    MVM_CF_NEVER_REPOSSESS = 2048,
+
+    /* Must this object stay where it is in the second generation? Set on
+     * anything allocated there directly (which the code that allocated it
+     * may rely on never moving) and on anything whose memory address has
+     * been handed out as an object ID. Such objects are left in place when
+     * gen2 pages are compacted. */
+    MVM_CF_GEN2_PINNED = 4096
 } MVMCollectableFlags;
 
 #ifdef MVM_USE_OVERFLOW_SERIALIZATION_INDEX
@@ -486,6 +486,16 @@ void MVM_repr_bind_key_o(MVMThreadContext *tc, MVMObject *obj, MVMString *key, M
         (MVMObject *)key, value, MVM_reg_obj);
 }
 
+/* Binds an integer, boxed with the current HLL's int type, under a key given
+ * as a C string. The ops that return hashes of statistics build them with
+ * this, having turned on gen2 allocation by default while they do so, which
+ * is what lets them (and us) not root anything. */
+void MVM_repr_bind_stat(MVMThreadContext *tc, MVMObject *hash, const char *key, MVMint64 val) {
+    MVM_repr_bind_key_o(tc, hash,
+        MVM_string_ascii_decode_nt(tc, tc->instance->VMString, key),
+        MVM_repr_box_int(tc, MVM_hll_current(tc)->int_box_type, val));
+}
+
 MVMint64 MVM_repr_exists_key(MVMThreadContext *tc, MVMObject *obj, MVMString *key) {
     return REPR(obj)->ass_funcs.exists_key(tc, STABLE(obj), obj,
         OBJECT_BODY(obj), (MVMObject *)key);
@@ -144,6 +144,10 @@ struct MVMCompUnitBody {
 
     /* Was a frame in this compilation unit invoked yet? */
     MVMuint8 invoked;
+
+    /* Hash of the bytecode, used to key the persistent specialization cache.
+     * Zero until it has been calculated. */
+    MVMuint64 spesh_cache_hash;
 };
 struct MVMCompUnit {
     MVMObject common;
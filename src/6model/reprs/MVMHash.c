@@ -207,6 +207,18 @@ static void spesh(MVMThreadContext *tc, MVMSTable *st, MVMSpeshGraph *g, MVMSpes
         }
         break;
     }
+    case MVM_OP_atkey_o:
+    case MVM_OP_existskey: {
+        /* Probe the hash directly if we know it's concrete. */
+        MVMSpeshFacts *facts = MVM_spesh_get_facts(tc, g, ins->operands[1]);
+        if (facts->flags & MVM_SPESH_FACT_CONCRETE) {
+            ins->info = MVM_op_get_op(ins->info->opcode == MVM_OP_atkey_o
+                ? MVM_OP_sp_vmhash_atkey_o
+                : MVM_OP_sp_vmhash_existskey);
+            MVM_spesh_use_facts(tc, g, facts);
+        }
+        break;
+    }
     }
 }
 
@@ -53,6 +53,9 @@ static void gc_mark(MVMThreadContext *tc, MVMSTable *st, void *data, MVMGCWorkli
             case MVM_SPESH_LOG_INVOKE:
                 MVM_gc_worklist_add(tc, worklist, &(log->entries[i].invoke.sf));
                 break;
+            case MVM_SPESH_LOG_ALLOC:
+                MVM_gc_worklist_add(tc, worklist, &(log->entries[i].alloc.sf));
+                break;
         }
     }
 }
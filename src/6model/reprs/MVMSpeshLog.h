@@ -19,7 +19,9 @@ typedef enum {
     /* OSR point. */
     MVM_SPESH_LOG_OSR,
     /* Return from a callframe, possibly with a logged type. */
-    MVM_SPESH_LOG_RETURN
+    MVM_SPESH_LOG_RETURN,
+    /* Whether a sampled allocation survived to the second generation. */
+    MVM_SPESH_LOG_ALLOC
 } MVMSpeshLogEntryKind;
 
 /* Flags on types. */
@@ -73,6 +75,15 @@ struct MVMSpeshLogEntry {
         struct {
             MVMint32 bytecode_offset;
         } osr;
+
+        /* Observed allocation survival (ALLOC). Not tied to the frame with
+         * the correlation ID, since it is only known after a GC run. */
+        struct {
+            MVMStaticFrame *sf;
+            MVMint32 bytecode_offset;
+            MVMuint8 survived;
+            MVMuint8 pretenured;
+        } alloc;
     };
 };
 
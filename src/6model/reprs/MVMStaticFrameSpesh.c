@@ -34,6 +34,13 @@ static void gc_mark(MVMThreadContext *tc, MVMSTable *st, void *data, MVMGCWorkli
                 MVM_gc_worklist_add(tc, worklist, &body->spesh_candidates[i]->spesh_slots[j]);
             for (j = 0; j < body->spesh_candidates[i]->num_inlines; j++)
                 MVM_gc_worklist_add(tc, worklist, &body->spesh_candidates[i]->inlines[j].sf);
+            if (body->spesh_candidates[i]->type_tuple) {
+                MVMSpeshStatsType *tt = body->spesh_candidates[i]->type_tuple;
+                for (j = 0; j < body->spesh_candidates[i]->cs->flag_count; j++) {
+                    MVM_gc_worklist_add(tc, worklist, &tt[j].type);
+                    MVM_gc_worklist_add(tc, worklist, &tt[j].decont_type);
+                }
+            }
         }
     }
 }
@@ -27,6 +27,23 @@ struct MVMStaticFrameSpeshBody {
      * specialized. Used to decide whether we'll directly allocate this frame
      * on the heap. */
     MVMuint32 num_heap_promotions;
+
+    /* Set when an allocation site that was pretenured (its objects allocated
+     * straight into the second generation) was found to no longer produce
+     * long-lived objects. Pretenured sites in the frame's existing
+     * specializations then go back to nursery allocation, and no further
+     * pretenuring is done in it. */
+    MVMuint32 pretenure_revoked;
+
+    /* The number of specializations retired for deopting too often, and a
+     * flag set when that happens so that the specialization worker throws
+     * away the frame's statistics and gathers fresh ones. */
+    MVMuint32 num_retirements;
+    MVMuint32 spesh_stats_stale;
+
+    /* Set once all the specializations recorded for the frame in the
+     * persistent specialization cache have been planned. */
+    MVMuint32 spesh_cache_replayed;
 };
 struct MVMStaticFrameSpesh {
     MVMObject common;
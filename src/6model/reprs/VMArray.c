@@ -58,6 +58,7 @@ static void copy_to(MVMThreadContext *tc, MVMSTable *st, void *src, MVMObject *d
     else {
         dest_body->slots.any = NULL;
     }
+    dest_body->cards = NULL;
 }
 
 /* Adds held objects to the GC worklist. */
@@ -93,6 +94,80 @@ static void gc_mark(MVMThreadContext *tc, MVMSTable *st, void *data, MVMGCWorkli
 static void gc_free(MVMThreadContext *tc, MVMObject *obj) {
     MVMArray *arr = (MVMArray *)obj;
     MVM_free(arr->body.slots.any);
+    MVM_free(arr->body.cards);
+}
+
+/* Throws away an array's card table when its slots are moved or reallocated,
+ * since the cards no longer describe where the nursery references are. If
+ * the array is an inter-generational root, it is then scanned in full by the
+ * next nursery collection, which builds a new card table; if it is not, it
+ * holds no nursery references anyway. */
+static void invalidate_cards(MVMThreadContext *tc, MVMArrayBody *body) {
+    if (body->cards) {
+        MVM_free(body->cards);
+        body->cards = NULL;
+    }
+}
+
+/* Scans an array that is an inter-generational root during a nursery
+ * collection, returning non-zero if it still references nursery objects and
+ * so should stay in the inter-generational root set. Large arrays of objects
+ * or strings are given a card table the first time they are scanned like
+ * this, built by scanning all of their slots. After that, only the cards
+ * dirtied by stores of nursery references are scanned, and cards that turn
+ * out to no longer reference the nursery are cleaned. */
+MVMint32 MVM_vmarray_mark_gen2_root(MVMThreadContext *tc, MVMObject *arr, MVMGCWorklist *worklist) {
+    MVMArrayREPRData  *repr_data    = (MVMArrayREPRData *)STABLE(arr)->REPR_data;
+    MVMArrayBody      *body         = &((MVMArray *)arr)->body;
+    MVMuint32          items_before = worklist->items;
+    MVMCollectable   **slots;
+    MVMuint64          num_cards, card, start, end;
+    MVMuint32          sc_idx;
+    MVMint32           scan_all;
+
+    /* Small arrays and those of native values are just marked as usual. */
+    if (body->ssize < MVM_ARRAY_CARD_MIN_SLOTS ||
+            (repr_data->slot_type != MVM_ARRAY_OBJ && repr_data->slot_type != MVM_ARRAY_STR)) {
+        MVM_gc_mark_collectable(tc, worklist, (MVMCollectable *)arr);
+        return worklist->items != items_before;
+    }
+
+    /* The header is always scanned; it is cheap, and writes to it are not
+     * tracked by the cards. */
+    sc_idx = MVM_sc_get_idx_of_sc(&(arr->header));
+    if (sc_idx > 0)
+        MVM_gc_worklist_add(tc, worklist, &(tc->instance->all_scs[sc_idx]->sc));
+    MVM_gc_worklist_add(tc, worklist, &(arr->st));
+
+    /* Create the card table if needed, in which case we scan everything. */
+    num_cards = (body->ssize + MVM_ARRAY_CARD_SIZE - 1) >> MVM_ARRAY_CARD_BITS;
+    scan_all  = body->cards == NULL;
+    if (scan_all)
+        body->cards = MVM_calloc(num_cards, sizeof(MVMuint8));
+
+    /* Scan the (dirty) cards that cover elements, and clean those that did
+     * not lead to any nursery objects. */
+    slots = (MVMCollectable **)body->slots.any;
+    start = body->start;
+    end   = body->start + body->elems;
+    for (card = 0; card < num_cards; card++) {
+        if (scan_all || body->cards[card]) {
+            MVMuint64 from  = card << MVM_ARRAY_CARD_BITS;
+            MVMuint64 to    = from + MVM_ARRAY_CARD_SIZE;
+            MVMuint32 items = worklist->items;
+            if (from < start)
+                from = start;
+            if (to > end)
+                to = end;
+            while (from < to) {
+                MVM_gc_worklist_add(tc, worklist, &slots[from]);
+                from++;
+            }
+            body->cards[card] = worklist->items != items;
+        }
+    }
+
+    return worklist->items != items_before;
 }
 
 /* Marks the representation data in an STable.*/
@@ -298,7 +373,7 @@ static MVMuint64 zero_slots(MVMThreadContext *tc, MVMArrayBody *body,
     return elems;
 }
 
-static void set_size_internal(MVMThreadContext *tc, MVMArrayBody *body, MVMuint64 n, MVMArrayREPRData *repr_data) {
+static void set_size_internal(MVMThreadContext *tc, MVMObject *root, MVMArrayBody *body, MVMuint64 n, MVMArrayREPRData *repr_data) {
     MVMuint64   elems = body->elems;
     MVMuint64   start = body->start;
     MVMuint64   ssize = body->ssize;
@@ -315,6 +390,7 @@ static void set_size_internal(MVMThreadContext *tc, MVMArrayBody *body, MVMuint6
                 (char *)slots + start * repr_data->elem_size,
                 elems * repr_data->elem_size);
         body->start = 0;
+        invalidate_cards(tc, body);
         /* fill out any unused slots with NULL pointers or zero values */
         elems = zero_slots(tc, body, elems, ssize, repr_data->slot_type);
     }
@@ -346,6 +422,12 @@ static void set_size_internal(MVMThreadContext *tc, MVMArrayBody *body, MVMuint6
     slots = (slots)
             ? MVM_realloc(slots, ssize * repr_data->elem_size)
             : MVM_malloc(ssize * repr_data->elem_size);
+    invalidate_cards(tc, body);
+
+    /* if the array is already in gen2, the growth is not going to be seen
+     * when it is promoted, so count it towards the next full collection */
+    if (root->header.flags & MVM_CF_SECOND_GEN)
+        tc->gc_gen2_unmanaged_bytes += (ssize - body->ssize) * repr_data->elem_size;
 
     /* fill out any unused slots with NULL pointers or zero values */
     body->slots.any = slots;
@@ -366,18 +448,20 @@ static void bind_pos(MVMThreadContext *tc, MVMSTable *st, MVMObject *root, void
             MVM_exception_throw_adhoc(tc, "MVMArray: Index out of bounds");
     }
     else if (index >= body->elems)
-        set_size_internal(tc, body, index + 1, repr_data);
+        set_size_internal(tc, root, body, index + 1, repr_data);
 
     /* Go by type. */
     switch (repr_data->slot_type) {
         case MVM_ARRAY_OBJ:
             if (kind != MVM_reg_obj)
                 MVM_exception_throw_adhoc(tc, "MVMArray: bindpos expected object register");
+            MVM_vmarray_mark_card(body, body->start + index, value.o);
             MVM_ASSIGN_REF(tc, &(root->header), body->slots.o[body->start + index], value.o);
             break;
         case MVM_ARRAY_STR:
             if (kind != MVM_reg_str)
                 MVM_exception_throw_adhoc(tc, "MVMArray: bindpos expected string register");
+            MVM_vmarray_mark_card(body, body->start + index, value.s);
             MVM_ASSIGN_REF(tc, &(root->header), body->slots.s[body->start + index], value.s);
             break;
         case MVM_ARRAY_I64:
@@ -445,7 +529,7 @@ static void set_elems(MVMThreadContext *tc, MVMSTable *st, MVMObject *root, void
     MVMArrayREPRData *repr_data = (MVMArrayREPRData *)st->REPR_data;
     MVMArrayBody     *body      = (MVMArrayBody *)data;
     enter_single_user(tc, body);
-    set_size_internal(tc, body, count, repr_data);
+    set_size_internal(tc, root, body, count, repr_data);
     exit_single_user(tc, body);
 }
 
@@ -453,16 +537,18 @@ static void push(MVMThreadContext *tc, MVMSTable *st, MVMObject *root, void *dat
     MVMArrayBody     *body      = (MVMArrayBody *)data;
     MVMArrayREPRData *repr_data = (MVMArrayREPRData *)st->REPR_data;
     enter_single_user(tc, body);
-    set_size_internal(tc, body, body->elems + 1, repr_data);
+    set_size_internal(tc, root, body, body->elems + 1, repr_data);
     switch (repr_data->slot_type) {
         case MVM_ARRAY_OBJ:
             if (kind != MVM_reg_obj)
                 MVM_exception_throw_adhoc(tc, "MVMArray: push expected object register");
+            MVM_vmarray_mark_card(body, body->start + body->elems - 1, value.o);
             MVM_ASSIGN_REF(tc, &(root->header), body->slots.o[body->start + body->elems - 1], value.o);
             break;
         case MVM_ARRAY_STR:
             if (kind != MVM_reg_str)
                 MVM_exception_throw_adhoc(tc, "MVMArray: push expected string register");
+            MVM_vmarray_mark_card(body, body->start + body->elems - 1, value.s);
             MVM_ASSIGN_REF(tc, &(root->header), body->slots.s[body->start + body->elems - 1], value.s);
             break;
         case MVM_ARRAY_I64:
@@ -612,7 +698,7 @@ static void unshift(MVMThreadContext *tc, MVMSTable *st, MVMObject *root, void *
         MVMuint64 elems = body->elems;
 
         /* grow the array */
-        set_size_internal(tc, body, elems + n, repr_data);
+        set_size_internal(tc, root, body, elems + n, repr_data);
 
         /* move elements and set start */
         memmove(
@@ -621,6 +707,7 @@ static void unshift(MVMThreadContext *tc, MVMSTable *st, MVMObject *root, void *
             elems * repr_data->elem_size);
         body->start = n;
         body->elems = elems;
+        invalidate_cards(tc, body);
 
         /* clear out beginning elements */
         zero_slots(tc, body, 0, n, repr_data->slot_type);
@@ -632,11 +719,13 @@ static void unshift(MVMThreadContext *tc, MVMSTable *st, MVMObject *root, void *
         case MVM_ARRAY_OBJ:
             if (kind != MVM_reg_obj)
                 MVM_exception_throw_adhoc(tc, "MVMArray: unshift expected object register");
+            MVM_vmarray_mark_card(body, body->start, value.o);
             MVM_ASSIGN_REF(tc, &(root->header), body->slots.o[body->start], value.o);
             break;
         case MVM_ARRAY_STR:
             if (kind != MVM_reg_str)
                 MVM_exception_throw_adhoc(tc, "MVMArray: unshift expected string register");
+            MVM_vmarray_mark_card(body, body->start, value.s);
             MVM_ASSIGN_REF(tc, &(root->header), body->slots.s[body->start], value.s);
             break;
         case MVM_ARRAY_I64:
@@ -839,10 +928,11 @@ static void asplice(MVMThreadContext *tc, MVMSTable *st, MVMObject *root, void *
             (char *)body->slots.any + (start + offset + elems1) * repr_data->elem_size,
             (char *)body->slots.any + (start + offset + count) * repr_data->elem_size,
             tail * repr_data->elem_size);
+        invalidate_cards(tc, body);
     }
 
     /* now resize the array */
-    set_size_internal(tc, body, offset + elems1 + tail, repr_data);
+    set_size_internal(tc, root, body, offset + elems1 + tail, repr_data);
 
     start = body->start;
     if (tail > 0 && count < elems1) {
@@ -851,6 +941,7 @@ static void asplice(MVMThreadContext *tc, MVMSTable *st, MVMObject *root, void *
             (char *)body->slots.any + (start + offset + elems1) * repr_data->elem_size,
             (char *)body->slots.any + (start + offset + count) * repr_data->elem_size,
             tail * repr_data->elem_size);
+        invalidate_cards(tc, body);
     }
     exit_single_user(tc, body);
 
@@ -1138,6 +1229,10 @@ static void deserialize(MVMThreadContext *tc, MVMSTable *st, MVMObject *root, vo
     MVMArrayBody     *body      = (MVMArrayBody *)data;
     MVMint64 i;
 
+    /* We may be deserializing into an existing array (on repossession), so
+     * any card table it has no longer describes its slots. */
+    invalidate_cards(tc, body);
+
     body->elems = MVM_serialization_read_int(tc, reader);
     body->ssize = body->elems;
     if (body->ssize)
@@ -1253,6 +1348,37 @@ static void spesh(MVMThreadContext *tc, MVMSTable *st, MVMSpeshGraph *g, MVMSpes
         }
         break;
     }
+    case MVM_OP_atpos_i:
+    case MVM_OP_atpos_n:
+    case MVM_OP_atpos_o:
+    case MVM_OP_bindpos_i:
+    case MVM_OP_bindpos_n:
+    case MVM_OP_bindpos_o: {
+        /* If the array is known concrete and its slots are of the kind the
+         * op reads or writes, access them directly. */
+        MVMArrayREPRData *repr_data = (MVMArrayREPRData *)st->REPR_data;
+        MVMuint16 opcode  = ins->info->opcode;
+        MVMint32  is_bind = opcode == MVM_OP_bindpos_i || opcode == MVM_OP_bindpos_n
+                         || opcode == MVM_OP_bindpos_o;
+        MVMSpeshFacts *facts = MVM_spesh_get_facts(tc, g, ins->operands[is_bind ? 0 : 1]);
+        MVMuint16 sp_op;
+        MVMuint8  slot_type;
+        if (!repr_data || !(facts->flags & MVM_SPESH_FACT_CONCRETE))
+            break;
+        switch (opcode) {
+            case MVM_OP_atpos_i:   sp_op = MVM_OP_sp_vmarray_atpos_i;   slot_type = MVM_ARRAY_I64; break;
+            case MVM_OP_atpos_n:   sp_op = MVM_OP_sp_vmarray_atpos_n;   slot_type = MVM_ARRAY_N64; break;
+            case MVM_OP_atpos_o:   sp_op = MVM_OP_sp_vmarray_atpos_o;   slot_type = MVM_ARRAY_OBJ; break;
+            case MVM_OP_bindpos_i: sp_op = MVM_OP_sp_vmarray_bindpos_i; slot_type = MVM_ARRAY_I64; break;
+            case MVM_OP_bindpos_n: sp_op = MVM_OP_sp_vmarray_bindpos_n; slot_type = MVM_ARRAY_N64; break;
+            default:               sp_op = MVM_OP_sp_vmarray_bindpos_o; slot_type = MVM_ARRAY_OBJ; break;
+        }
+        if (repr_data->slot_type == slot_type) {
+            ins->info = MVM_op_get_op(sp_op);
+            MVM_spesh_use_facts(tc, g, facts);
+        }
+        break;
+    }
     }
 }
 
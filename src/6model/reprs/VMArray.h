@@ -32,6 +32,12 @@ struct MVMArrayBody {
         void       *any;
     } slots;
 
+    /* Card table for a large array of objects or strings that lives in the
+     * second generation; one byte per MVM_ARRAY_CARD_SIZE slots, set when a
+     * nursery reference is stored into the slots it covers. NULL if the array
+     * has no cards, or they were invalidated by moving the slots around. */
+    MVMuint8   *cards;
+
 #if MVM_ARRAY_CONC_DEBUG
     AO_t in_use;
 #endif 
@@ -61,9 +67,27 @@ struct MVMArray {
 #define MVM_ARRAY_I2    16
 #define MVM_ARRAY_I1    17
 
+/* Card marking. Arrays of objects or strings with at least this many slots
+ * get a card table once they are inter-generational roots, so that nursery
+ * collections need only scan the dirty parts of them. */
+#define MVM_ARRAY_CARD_BITS      7
+#define MVM_ARRAY_CARD_SIZE      (1 << MVM_ARRAY_CARD_BITS)
+#define MVM_ARRAY_CARD_MIN_SLOTS 1024
+
 /* Function for REPR setup. */
 const MVMREPROps * MVMArray_initialize(MVMThreadContext *tc);
 
+/* Scans an array that is an inter-generational root. */
+MVMint32 MVM_vmarray_mark_gen2_root(MVMThreadContext *tc, MVMObject *arr, MVMGCWorklist *worklist);
+
+/* Dirties the card covering a slot, if the array has cards and the reference
+ * being stored into it is to a nursery object. Must be done alongside the
+ * usual write barrier on any store of a reference into an array slot. */
+MVM_STATIC_INLINE void MVM_vmarray_mark_card(MVMArrayBody *body, MVMuint64 slot, const void *referenced) {
+    if (body->cards && referenced && !(((MVMCollectable *)referenced)->flags & MVM_CF_SECOND_GEN))
+        body->cards[slot >> MVM_ARRAY_CARD_BITS] = 1;
+}
+
 /* Array REPR data specifies the type of array elements we have. */
 struct MVMArrayREPRData {
     /* The size of each element. */
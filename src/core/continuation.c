@@ -25,7 +25,7 @@ void MVM_continuation_reset(MVMThreadContext *tc, MVMObject *tag,
     /* Were we passed code or a continuation? */
     if (REPR(code)->ID == MVM_REPR_ID_MVMContinuation) {
         /* Continuation; invoke it. */
-        MVM_continuation_invoke(tc, (MVMContinuation *)code, NULL, res_reg);
+        MVM_continuation_invoke(tc, code, NULL, res_reg);
     }
     else {
         /* Run the passed code. */
@@ -136,8 +136,13 @@ void MVM_continuation_control(MVMThreadContext *tc, MVMint64 protect,
     STABLE(code)->invoke(tc, code, inv_arg_callsite, tc->cur_frame->args);
 }
 
-void MVM_continuation_invoke(MVMThreadContext *tc, MVMContinuation *cont,
+void MVM_continuation_invoke(MVMThreadContext *tc, MVMObject *cont_obj,
                              MVMObject *code, MVMRegister *res_reg) {
+    MVMContinuation *cont;
+    if (REPR(cont_obj)->ID != MVM_REPR_ID_MVMContinuation)
+        MVM_exception_throw_adhoc(tc, "continuationinvoke expects an MVMContinuation");
+    cont = (MVMContinuation *)cont_obj;
+
     /* Ensure we are the only invoker of the continuation. */
     if (!MVM_trycas(&(cont->body.invoked), 0, 1))
         MVM_exception_throw_adhoc(tc, "This continuation has already been invoked");
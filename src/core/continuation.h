@@ -3,6 +3,6 @@ void MVM_continuation_reset(MVMThreadContext *tc, MVMObject *tag,
 void MVM_continuation_control(MVMThreadContext *tc, MVMint64 protect,
                               MVMObject *tag, MVMObject *code,
                               MVMRegister *res_reg);
-void MVM_continuation_invoke(MVMThreadContext *tc, MVMContinuation *cont,
+void MVM_continuation_invoke(MVMThreadContext *tc, MVMObject *cont,
                              MVMObject *code, MVMRegister *res_reg);
 void MVM_continuation_free_tags(MVMThreadContext *tc, MVMFrame *f);
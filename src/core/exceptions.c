@@ -814,6 +814,39 @@ void MVM_exception_throw_adhoc_free_va(MVMThreadContext *tc, char **waste, const
     longjmp(tc->interp_jump, 1);
 }
 
+/* Accessors for the parts of an exception object, shared by the interpreter
+ * and the JIT. */
+static MVMException * check_exception(MVMThreadContext *tc, MVMObject *ex, const char *op) {
+    if (!IS_CONCRETE(ex) || REPR(ex)->ID != MVM_REPR_ID_MVMException)
+        MVM_exception_throw_adhoc(tc, "%s needs a VMException, got %s (%s)",
+            op, REPR(ex)->name, STABLE(ex)->debug_name);
+    return (MVMException *)ex;
+}
+void MVM_bind_exception_message(MVMThreadContext *tc, MVMObject *ex, MVMString *message) {
+    MVMException *exc = check_exception(tc, ex, "bindexmessage");
+    MVM_ASSIGN_REF(tc, &(ex->header), exc->body.message, message);
+}
+void MVM_bind_exception_payload(MVMThreadContext *tc, MVMObject *ex, MVMObject *payload) {
+    MVMException *exc = check_exception(tc, ex, "bindexpayload");
+    MVM_ASSIGN_REF(tc, &(ex->header), exc->body.payload, payload);
+}
+void MVM_bind_exception_category(MVMThreadContext *tc, MVMObject *ex, MVMint64 category) {
+    check_exception(tc, ex, "bindexcategory")->body.category = category;
+}
+MVMString * MVM_get_exception_message(MVMThreadContext *tc, MVMObject *ex) {
+    return check_exception(tc, ex, "getexmessage")->body.message;
+}
+MVMObject * MVM_get_exception_payload(MVMThreadContext *tc, MVMObject *ex) {
+    MVMObject *payload = check_exception(tc, ex, "getexpayload")->body.payload;
+    return payload ? payload : tc->instance->VMNull;
+}
+MVMint64 MVM_get_exception_category(MVMThreadContext *tc, MVMObject *ex) {
+    return check_exception(tc, ex, "getexcategory")->body.category;
+}
+void MVM_exception_returnafterunwind(MVMThreadContext *tc, MVMObject *ex) {
+    check_exception(tc, ex, "exreturnafterunwind")->body.return_after_unwind = 1;
+}
+
 void MVM_crash_on_error(void) {
     crash_on_error = 1;
 }
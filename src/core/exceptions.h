@@ -84,6 +84,13 @@ void MVM_exception_die(MVMThreadContext *tc, MVMString *str, MVMRegister *rr);
 void MVM_exception_throwobj(MVMThreadContext *tc, MVMuint8 mode, MVMObject *exObj, MVMRegister *resume_result);
 void MVM_exception_throwpayload(MVMThreadContext *tc, MVMuint8 mode, MVMuint32 cat, MVMObject *payload, MVMRegister *resume_result);
 void MVM_exception_resume(MVMThreadContext *tc, MVMObject *exObj);
+void MVM_bind_exception_message(MVMThreadContext *tc, MVMObject *ex, MVMString *message);
+void MVM_bind_exception_payload(MVMThreadContext *tc, MVMObject *ex, MVMObject *payload);
+void MVM_bind_exception_category(MVMThreadContext *tc, MVMObject *ex, MVMint64 category);
+MVMString * MVM_get_exception_message(MVMThreadContext *tc, MVMObject *ex);
+MVMObject * MVM_get_exception_payload(MVMThreadContext *tc, MVMObject *ex);
+MVMint64 MVM_get_exception_category(MVMThreadContext *tc, MVMObject *ex);
+void MVM_exception_returnafterunwind(MVMThreadContext *tc, MVMObject *ex);
 MVM_PUBLIC MVM_NO_RETURN void MVM_panic_allocation_failed(size_t len) MVM_NO_RETURN_GCC;
 MVM_PUBLIC MVM_NO_RETURN void MVM_panic(MVMint32 exitCode, const char *messageFormat, ...) MVM_NO_RETURN_GCC MVM_FORMAT(printf, 2, 3);
 MVM_PUBLIC MVM_NO_RETURN void MVM_oops(MVMThreadContext *tc, const char *messageFormat, ...) MVM_NO_RETURN_GCC MVM_FORMAT(printf, 2, 3);
@@ -82,10 +82,15 @@ static MVMuint32 bin_for(size_t bytes) {
     return bin;
 }
 
+/* Works out the size of a page for a bin. */
+static MVMuint32 page_size_for(MVMuint32 bin) {
+    return MVM_FSA_PAGE_ITEMS * ((bin + 1) << MVM_FSA_BIN_BITS) + MVM_FSA_REDZONE_BYTES * 2 * MVM_FSA_PAGE_ITEMS;
+}
+
 /* Sets up a size class bin in the second generation. */
 static void setup_bin(MVMFixedSizeAlloc *al, MVMuint32 bin) {
     /* Work out page size we want. */
-    MVMuint32 page_size = MVM_FSA_PAGE_ITEMS * ((bin + 1) << MVM_FSA_BIN_BITS) + MVM_FSA_REDZONE_BYTES * 2 * MVM_FSA_PAGE_ITEMS;
+    MVMuint32 page_size = page_size_for(bin);
 
     /* We'll just allocate a single page to start off with. */
     al->size_classes[bin].num_pages = 1;
@@ -100,7 +105,7 @@ static void setup_bin(MVMFixedSizeAlloc *al, MVMuint32 bin) {
 /* Adds a new page to a size class bin. */
 static void add_page(MVMFixedSizeAlloc *al, MVMuint32 bin) {
     /* Work out page size. */
-    MVMuint32 page_size = MVM_FSA_PAGE_ITEMS * ((bin + 1) << MVM_FSA_BIN_BITS) + MVM_FSA_REDZONE_BYTES * 2 * MVM_FSA_PAGE_ITEMS;
+    MVMuint32 page_size = page_size_for(bin);
 
     /* Add the extra page. */
     MVMuint32 cur_page = al->size_classes[bin].num_pages;
@@ -115,6 +120,9 @@ static void add_page(MVMFixedSizeAlloc *al, MVMuint32 bin) {
 
     /* set the cur_page to a proper value */
     al->size_classes[bin].cur_page = cur_page;
+
+    /* The size class is in demand, so it's not the time to release pages. */
+    al->size_classes[bin].idle_collections = 0;
 }
 
 /* Allocates a piece of memory of the specified size, using the FSA. */
@@ -324,6 +332,146 @@ void MVM_fixed_size_safepoint(MVMThreadContext *tc, MVMFixedSizeAlloc *al) {
     al->free_at_next_safepoint_overflows = NULL;
 }
 
+/* Used to find which page a free list entry is in. */
+typedef struct {
+    char      *start;
+    MVMuint32  page;
+} PageStart;
+static int compare_page_start(const void *a, const void *b) {
+    char *start_a = ((const PageStart *)a)->start;
+    char *start_b = ((const PageStart *)b)->start;
+    return start_a < start_b ? -1 : start_a > start_b ? 1 : 0;
+}
+static PageStart * find_page(PageStart *starts, MVMuint32 num_starts, MVMuint32 page_size, void *addr) {
+    MVMuint32 lo = 0, hi = num_starts;
+    while (lo < hi) {
+        MVMuint32 mid = lo + (hi - lo) / 2;
+        if ((char *)addr < starts[mid].start)
+            hi = mid;
+        else if ((char *)addr >= starts[mid].start + page_size)
+            lo = mid + 1;
+        else
+            return &starts[mid];
+    }
+    return NULL;
+}
+
+/* Counts the entries on a free list in each of the pages being considered. */
+static void count_free(PageStart *starts, MVMuint32 num_starts, MVMuint32 page_size,
+                       MVMuint32 *free_items, MVMFixedSizeAllocFreeListEntry *fle) {
+    while (fle) {
+        PageStart *ps = find_page(starts, num_starts, page_size, fle);
+        if (ps)
+            free_items[ps->page]++;
+        fle = fle->next;
+    }
+}
+
+/* Removes the entries in pages that are to be released from a free list,
+ * returning the new list head and adding the number removed to *removed. */
+static MVMFixedSizeAllocFreeListEntry * remove_released(PageStart *starts, MVMuint32 num_starts,
+        MVMuint32 page_size, MVMuint32 *free_items, MVMFixedSizeAllocFreeListEntry *fle,
+        MVMuint32 *removed) {
+    MVMFixedSizeAllocFreeListEntry  *head = fle;
+    MVMFixedSizeAllocFreeListEntry **insert_pos = &head;
+    while (fle) {
+        MVMFixedSizeAllocFreeListEntry *next = fle->next;
+        PageStart *ps = find_page(starts, num_starts, page_size, fle);
+        if (ps && free_items[ps->page] == MVM_FSA_PAGE_ITEMS) {
+            (*removed)++;
+        }
+        else {
+            *insert_pos = fle;
+            insert_pos = (MVMFixedSizeAllocFreeListEntry **)&(fle->next);
+        }
+        fle = next;
+    }
+    *insert_pos = NULL;
+    return head;
+}
+
+/* Releases the pages of a bin whose every item is on either the global or
+ * a per-thread free list. The page currently being allocated from is kept. */
+static void release_bin_pages(MVMThreadContext *tc, MVMFixedSizeAlloc *al, MVMuint32 bin) {
+    MVMFixedSizeAllocSizeClass *bin_ptr    = &(al->size_classes[bin]);
+    MVMuint32                   page_size  = page_size_for(bin);
+    MVMuint32                   num_starts = bin_ptr->num_pages - 1;
+    PageStart                  *starts     = MVM_malloc(num_starts * sizeof(PageStart));
+    MVMuint32                  *free_items = MVM_calloc(num_starts, sizeof(MVMuint32));
+    MVMuint32                   released   = 0;
+    MVMuint32                   page, kept;
+    MVMThread                  *cur_thread;
+
+    /* Count how many free items each page has. */
+    for (page = 0; page < num_starts; page++) {
+        starts[page].start = bin_ptr->pages[page];
+        starts[page].page  = page;
+    }
+    qsort(starts, num_starts, sizeof(PageStart), compare_page_start);
+    count_free(starts, num_starts, page_size, free_items, bin_ptr->free_list);
+    cur_thread = (MVMThread *)MVM_load(&tc->instance->threads);
+    while (cur_thread) {
+        if (cur_thread->body.tc)
+            count_free(starts, num_starts, page_size, free_items,
+                cur_thread->body.tc->thread_fsa->size_classes[bin].free_list);
+        cur_thread = cur_thread->body.next;
+    }
+    for (page = 0; page < num_starts; page++)
+        if (free_items[page] == MVM_FSA_PAGE_ITEMS)
+            released++;
+
+    /* If any can be released, take their items off the free lists, then
+     * free them. */
+    if (released) {
+        MVMuint32 removed = 0;
+        bin_ptr->free_list = remove_released(starts, num_starts, page_size, free_items,
+            bin_ptr->free_list, &removed);
+        cur_thread = (MVMThread *)MVM_load(&tc->instance->threads);
+        while (cur_thread) {
+            if (cur_thread->body.tc) {
+                MVMFixedSizeAllocThreadSizeClass *thread_bin =
+                    &(cur_thread->body.tc->thread_fsa->size_classes[bin]);
+                removed = 0;
+                thread_bin->free_list = remove_released(starts, num_starts, page_size,
+                    free_items, thread_bin->free_list, &removed);
+                thread_bin->items -= removed;
+            }
+            cur_thread = cur_thread->body.next;
+        }
+        kept = 0;
+        for (page = 0; page < bin_ptr->num_pages; page++) {
+            if (page < num_starts && free_items[page] == MVM_FSA_PAGE_ITEMS)
+                MVM_free(bin_ptr->pages[page]);
+            else
+                bin_ptr->pages[kept++] = bin_ptr->pages[page];
+        }
+        bin_ptr->num_pages = kept;
+        bin_ptr->cur_page  = kept - 1;
+        MVM_add(&tc->instance->gc_fsa_pages_released, released);
+        MVM_add(&tc->instance->gc_fsa_bytes_released, released * page_size);
+    }
+
+    MVM_free(starts);
+    MVM_free(free_items);
+}
+
+/* Called by the GC co-ordinator at the end of a full collection, while the
+ * world is stopped, to give back pages that are entirely free in size classes
+ * that have not needed a new page for a while. */
+void MVM_fixed_size_release_pages(MVMThreadContext *tc, MVMFixedSizeAlloc *al) {
+    MVMuint32 release_idle = tc->instance->gc_page_release_idle;
+    MVMuint32 bin;
+    if (!release_idle)
+        return;
+    for (bin = 0; bin < MVM_FSA_BINS; bin++) {
+        MVMFixedSizeAllocSizeClass *bin_ptr = &(al->size_classes[bin]);
+        if (bin_ptr->num_pages < 2)
+            continue;
+        if (++bin_ptr->idle_collections >= release_idle)
+            release_bin_pages(tc, al, bin);
+    }
+}
+
 /* Destroys per-thread fixed size allocator state. All freelists will be
  * contributed back to the global freelists for the bin size. */
 void MVM_fixed_size_destroy_thread(MVMThreadContext *tc) {
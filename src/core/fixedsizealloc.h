@@ -52,6 +52,11 @@ struct MVMFixedSizeAllocSizeClass {
 
     /* Head of the "free at next safepoint" list. */
     MVMFixedSizeAllocSafepointFreeListEntry *free_at_next_safepoint_list;
+
+    /* The number of full collections since this size class last needed a
+     * new page; used to decide when to release pages that are entirely
+     * free. */
+    MVMuint32 idle_collections;
 };
 
 /* The per-thread data structure for the fixed size allocator, hung off the
@@ -104,3 +109,4 @@ void MVM_fixed_size_destroy_thread(MVMThreadContext *tc);
 void MVM_fixed_size_free(MVMThreadContext *tc, MVMFixedSizeAlloc *fsa, size_t bytes, void *free);
 void MVM_fixed_size_free_at_safepoint(MVMThreadContext *tc, MVMFixedSizeAlloc *fsa, size_t bytes, void *free);
 void MVM_fixed_size_safepoint(MVMThreadContext *tc, MVMFixedSizeAlloc *al);
+void MVM_fixed_size_release_pages(MVMThreadContext *tc, MVMFixedSizeAlloc *al);
@@ -461,7 +461,7 @@ void MVM_frame_invoke(MVMThreadContext *tc, MVMStaticFrame *static_frame,
 
     /* See if any specializations apply. */
     spesh = static_frame->body.spesh;
-    if (spesh_cand < 0)
+    if (spesh_cand < 0 || spesh->body.spesh_candidates[spesh_cand]->retired)
         spesh_cand = MVM_spesh_arg_guard_run(tc, spesh->body.spesh_arg_guard,
             callsite, args, NULL);
 #if MVM_SPESH_CHECK_PRESELECTION
@@ -502,6 +502,7 @@ void MVM_frame_invoke(MVMThreadContext *tc, MVMStaticFrame *static_frame,
         }
         frame->effective_spesh_slots = chosen_cand->spesh_slots;
         frame->spesh_cand = chosen_cand;
+        chosen_cand->entry_count++;
     }
     else {
         if (static_frame->body.allocate_on_heap) {
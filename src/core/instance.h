@@ -170,16 +170,64 @@ struct MVMInstance {
     /* The number of threads that have yet to acknowledge the finish. */
     AO_t gc_ack;
 
+    /* Pool of gen2 marking work shared during a full collection by threads
+     * with a lot of it, so threads that ran out of their own can steal it,
+     * along with the number of chunks in it and a mutex protecting it. Also
+     * the number of threads taking part in this GC run, and how many of them
+     * are currently idle and looking for work to steal. */
+    MVMGCPassedWork *gc_steal_pool;
+    AO_t             gc_steal_pool_chunks;
+    uv_mutex_t       mutex_gc_steal_pool;
+    AO_t             gc_steal_participants;
+    AO_t             gc_steal_idle;
+
+    /* The number of threads that have finished any gen2 sweeping left over
+     * from the last full collection, which must happen before marking. */
+    AO_t             gc_sweep_finished;
+
     /* Linked list (via forwarder) of STables to free. */
     MVMSTable *stables_to_free;
 
     /* Whether the current GC run is a full collection. */
     MVMuint32 gc_full_collect;
 
+    /* The bounds within which the nursery size of each thread adapts. */
+    MVMuint32 nursery_size_min;
+    MVMuint32 nursery_size_max;
+
+    /* Whether gen2 marking should be done incrementally, as a slice of work
+     * in each nursery collection, leaving a short final full collection to
+     * finish the marking and sweep. If so, also whether a marking cycle is
+     * in progress, the number of GC runs it has been going for, and the
+     * number of objects that were left to scan after the last slice. */
+    MVMuint32 gc_incremental;
+    MVMuint32 gc_marking;
+    MVMuint32 gc_marking_runs;
+    MVMuint64 gc_marking_pending;
+
+    /* Whether sparsely populated gen2 pages should be evacuated and freed at
+     * the end of full collections. */
+    MVMuint32 gc_compact;
+
+    /* The number of full collections a gen2 or fixed size allocator size
+     * class must go without needing a new page before pages found to be
+     * entirely free are released (zero to never release them). Also counts
+     * of the pages released, and the memory they held. */
+    MVMuint32 gc_page_release_idle;
+    AO_t      gc_gen2_pages_released;
+    AO_t      gc_gen2_bytes_released;
+    AO_t      gc_fsa_pages_released;
+    AO_t      gc_fsa_bytes_released;
+
     /* How many bytes of data have we promoted from the nursery to gen2
      * since we last did a full collection? */
     AO_t gc_promoted_bytes_since_last_full;
 
+    /* GC statistics for the instance, and how many GC runs apart they
+     * should be dumped (zero to never dump them). */
+    MVMGCStats gc_stats;
+    MVMuint32  gc_stats_interval;
+
     /* Persistent object ID hash, used to give nursery objects a lifetime
      * unique ID. Plus a lock to protect it. */
     MVMObjectId *object_ids;
@@ -233,9 +281,22 @@ struct MVMInstance {
     MVMint8 spesh_nodelay;
     MVMint8 spesh_blocking;
 
+    /* Percentage to scale the hit thresholds for specialization by, the
+     * number of OSR hits needed before that, and the percentage of the hits
+     * at a callsite a type tuple needs to get its own specialization. */
+    MVMuint32 spesh_threshold_scale;
+    MVMuint32 spesh_osr_threshold;
+    MVMuint32 spesh_type_tuple_percent;
+
+    /* If adaptive thresholds are enabled, the percentage the thresholds are
+     * further scaled by, which the worker adjusts according to how much work
+     * is waiting for it. Read and updated atomically. */
+    MVMint8 spesh_threshold_adaptive;
+    AO_t spesh_threshold_adapt;
+
     /* Number of specializations produced, and limit on number of
      * specializations (zero if no limit). */
-    MVMint32 spesh_produced;
+    AO_t spesh_produced;
     MVMint32 spesh_limit;
 
     /* Mutex taken when install specializations. */
@@ -245,6 +306,23 @@ struct MVMInstance {
      * is enabled. */
     MVMObject *spesh_queue;
 
+    /* The persistent specialization cache, if one is in use. */
+    MVMSpeshCache *spesh_cache;
+
+    /* Memory budget for specialization statistics in bytes (zero if there is
+     * no limit), the size of the statistics and number of frames they are for
+     * as of the worker last cleaning them up, and the number of frames whose
+     * statistics were thrown out early to stay within the budget. */
+    size_t spesh_stats_budget;
+    size_t spesh_stats_bytes;
+    MVMuint32 spesh_stats_frames;
+    MVMuint64 spesh_stats_evicted;
+
+    /* Memory held in region allocator blocks (used for spesh graphs), and the
+     * number of blocks that were reused rather than allocated afresh. */
+    AO_t region_bytes;
+    AO_t region_blocks_reused;
+
     /* The current specialization plan; hung off here so we can mark it. */
     MVMSpeshPlan *spesh_plan;
 
@@ -260,6 +338,22 @@ struct MVMInstance {
     uv_cond_t cond_spesh_sync;
     MVMuint32 spesh_working;
 
+    /* The number of specialization workers. The first of them forms plans;
+     * each plan is implemented in waves of entries with the same call depth,
+     * deepest first, so callees are installed before their callers are
+     * specialized. The entries of a wave, up to spesh_plan_wave_end, are
+     * shared out between all workers by taking the next one to do from
+     * spesh_plan_next. The others wait for spesh_plan_seq to change, and
+     * count down spesh_plan_helpers_busy when they have run out of work, all
+     * under the plan mutex. */
+    MVMuint32 spesh_workers;
+    AO_t spesh_plan_next;
+    MVMuint32 spesh_plan_wave_end;
+    MVMuint32 spesh_plan_seq;
+    MVMuint32 spesh_plan_helpers_busy;
+    uv_mutex_t mutex_spesh_plan;
+    uv_cond_t cond_spesh_plan;
+
     /************************************************************************
      * JIT compilation
      ************************************************************************/
@@ -267,6 +361,9 @@ struct MVMInstance {
     /* Flag for if jit is enabled */
     MVMint32 jit_enabled;
 
+    /* Flag for if runs of simple ops are compiled in machine registers */
+    MVMint32 jit_expr_enabled;
+
     /* File for JIT logging */
     FILE *jit_log_fh;
 
@@ -276,9 +373,19 @@ struct MVMInstance {
     /* File for map of frame information for bytecode dumps */
     FILE *jit_bytecode_map;
 
+    /* perf map file that compiled frames are recorded in for profilers */
+    FILE *jit_perf_map;
+
     /* sequence number for JIT compiled frames */
     AO_t  jit_seq_nr;
 
+    /* Number of frames the JIT refused to compile, indexed by the opcode
+     * it bailed on; all extension ops share the slot at MVM_OP_EXT_BASE. */
+    AO_t *jit_bail_counts;
+
+    /* Executable memory that JIT compiled code lives in. */
+    MVMJitHeap *jit_heap;
+
     /************************************************************************
      * I/O and process state
      ************************************************************************/
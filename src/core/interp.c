@@ -398,8 +398,11 @@ void MVM_interp_run(MVMThreadContext *tc, void (*initial_invoke)(MVMThreadContex
             OP(bindlex_ng):
                 MVM_exception_throw_adhoc(tc, "get/bindlex_ng NYI");
             OP(getdynlex): {
-                GET_REG(cur_op, 0).o = MVM_frame_getdynlex(tc, GET_REG(cur_op, 2).s,
+                MVMObject *value = MVM_frame_getdynlex(tc, GET_REG(cur_op, 2).s,
                         tc->cur_frame->caller);
+                GET_REG(cur_op, 0).o = value;
+                if (value && MVM_spesh_log_is_logging(tc))
+                    MVM_spesh_log_type(tc, value);
                 cur_op += 4;
                 goto NEXT;
             }
@@ -1183,68 +1186,30 @@ void MVM_interp_run(MVMThreadContext *tc, void (*initial_invoke)(MVMThreadContex
                     : tc->instance->VMNull;
                 cur_op += 2;
                 goto NEXT;
-            OP(bindexmessage): {
-                MVMObject *ex = GET_REG(cur_op, 0).o;
-                if (IS_CONCRETE(ex) && REPR(ex)->ID == MVM_REPR_ID_MVMException) {
-                    MVM_ASSIGN_REF(tc, &(ex->header), ((MVMException *)ex)->body.message,
-                        GET_REG(cur_op, 2).s);
-                }
-                else {
-                    MVM_exception_throw_adhoc(tc, "bindexmessage needs a VMException, got %s (%s)", REPR(ex)->name, STABLE(ex)->debug_name);
-                }
+            OP(bindexmessage):
+                MVM_bind_exception_message(tc, GET_REG(cur_op, 0).o, GET_REG(cur_op, 2).s);
                 cur_op += 4;
                 goto NEXT;
-            }
-            OP(bindexpayload): {
-                MVMObject *ex = GET_REG(cur_op, 0).o;
-                if (IS_CONCRETE(ex) && REPR(ex)->ID == MVM_REPR_ID_MVMException) {
-                    MVM_ASSIGN_REF(tc, &(ex->header), ((MVMException *)ex)->body.payload,
-                        GET_REG(cur_op, 2).o);
-                }
-                else {
-                    MVM_exception_throw_adhoc(tc, "bindexpayload needs a VMException, got %s (%s)", REPR(ex)->name, STABLE(ex)->debug_name);
-                }
+            OP(bindexpayload):
+                MVM_bind_exception_payload(tc, GET_REG(cur_op, 0).o, GET_REG(cur_op, 2).o);
                 cur_op += 4;
                 goto NEXT;
-            }
-            OP(bindexcategory): {
-                MVMObject *ex = GET_REG(cur_op, 0).o;
-                if (IS_CONCRETE(ex) && REPR(ex)->ID == MVM_REPR_ID_MVMException)
-                    ((MVMException *)ex)->body.category = GET_REG(cur_op, 2).i64;
-                else
-                    MVM_exception_throw_adhoc(tc, "bindexcategory needs a VMException, got %s (%s)", REPR(ex)->name, STABLE(ex)->debug_name);
+            OP(bindexcategory):
+                MVM_bind_exception_category(tc, GET_REG(cur_op, 0).o, GET_REG(cur_op, 2).i64);
                 cur_op += 4;
                 goto NEXT;
-            }
-            OP(getexmessage): {
-                MVMObject *ex = GET_REG(cur_op, 2).o;
-                if (IS_CONCRETE(ex) && REPR(ex)->ID == MVM_REPR_ID_MVMException)
-                    GET_REG(cur_op, 0).s = ((MVMException *)ex)->body.message;
-                else
-                    MVM_exception_throw_adhoc(tc, "getexmessage needs a VMException, got %s (%s)", REPR(ex)->name, STABLE(ex)->debug_name);
+            OP(getexmessage):
+                GET_REG(cur_op, 0).s = MVM_get_exception_message(tc, GET_REG(cur_op, 2).o);
                 cur_op += 4;
                 goto NEXT;
-            }
-            OP(getexpayload): {
-                MVMObject *ex = GET_REG(cur_op, 2).o;
-                if (IS_CONCRETE(ex) && REPR(ex)->ID == MVM_REPR_ID_MVMException)
-                    GET_REG(cur_op, 0).o = ((MVMException *)ex)->body.payload;
-                else
-                    MVM_exception_throw_adhoc(tc, "getexpayload needs a VMException, got %s (%s)", REPR(ex)->name, STABLE(ex)->debug_name);
-                if (!GET_REG(cur_op, 0).o)
-                    GET_REG(cur_op, 0).o = tc->instance->VMNull;
+            OP(getexpayload):
+                GET_REG(cur_op, 0).o = MVM_get_exception_payload(tc, GET_REG(cur_op, 2).o);
                 cur_op += 4;
                 goto NEXT;
-            }
-            OP(getexcategory): {
-                MVMObject *ex = GET_REG(cur_op, 2).o;
-                if (IS_CONCRETE(ex) && REPR(ex)->ID == MVM_REPR_ID_MVMException)
-                    GET_REG(cur_op, 0).i64 = ((MVMException *)ex)->body.category;
-                else
-                    MVM_exception_throw_adhoc(tc, "getexcategory needs a VMException, got %s (%s)", REPR(ex)->name, STABLE(ex)->debug_name);
+            OP(getexcategory):
+                GET_REG(cur_op, 0).i64 = MVM_get_exception_category(tc, GET_REG(cur_op, 2).o);
                 cur_op += 4;
                 goto NEXT;
-            }
             OP(throwdyn): {
                 MVMRegister *rr     = &GET_REG(cur_op, 0);
                 MVMObject   *ex_obj = GET_REG(cur_op, 2).o;
@@ -1853,6 +1818,8 @@ void MVM_interp_run(MVMThreadContext *tc, void (*initial_invoke)(MVMThreadContex
                 GET_REG(cur_op, 0).o = obj;
                 if (REPR(obj)->initialize)
                     REPR(obj)->initialize(tc, STABLE(obj), obj, OBJECT_BODY(obj));
+                if (MVM_spesh_log_is_logging(tc))
+                    MVM_spesh_log_allocation(tc, GET_REG(cur_op, 0).o);
                 cur_op += 4;
                 goto NEXT;
             }
@@ -3797,8 +3764,11 @@ void MVM_interp_run(MVMThreadContext *tc, void (*initial_invoke)(MVMThreadContex
                 cur_op += 2;
                 goto NEXT;
             OP(getlexouter): {
-                GET_REG(cur_op, 0).o = MVM_frame_find_lexical_by_name_outer(tc,
+                MVMObject *value = MVM_frame_find_lexical_by_name_outer(tc,
                     GET_REG(cur_op, 2).s);
+                GET_REG(cur_op, 0).o = value;
+                if (value && MVM_spesh_log_is_logging(tc))
+                    MVM_spesh_log_type(tc, value);
                 cur_op += 4;
                 goto NEXT;
             }
@@ -3939,15 +3909,10 @@ void MVM_interp_run(MVMThreadContext *tc, void (*initial_invoke)(MVMThreadContex
                 GET_REG(cur_op, 0).s = MVM_io_get_hostname(tc);
                 cur_op += 2;
                 goto NEXT;
-            OP(exreturnafterunwind): {
-                MVMObject *ex = GET_REG(cur_op, 0).o;
-                if (IS_CONCRETE(ex) && REPR(ex)->ID == MVM_REPR_ID_MVMException)
-                    ((MVMException *)ex)->body.return_after_unwind = 1;
-                else
-                    MVM_exception_throw_adhoc(tc, "exreturnafterunwind needs a VMException, got %s (%s)", REPR(ex)->name, STABLE(ex)->debug_name);
+            OP(exreturnafterunwind):
+                MVM_exception_returnafterunwind(tc, GET_REG(cur_op, 0).o);
                 cur_op += 2;
                 goto NEXT;
-            }
             OP(continuationreset): {
                 MVMRegister *res  = &GET_REG(cur_op, 0);
                 MVMObject   *tag  = GET_REG(cur_op, 2).o;
@@ -3970,10 +3935,7 @@ void MVM_interp_run(MVMThreadContext *tc, void (*initial_invoke)(MVMThreadContex
                 MVMObject   *cont = GET_REG(cur_op, 2).o;
                 MVMObject   *code = GET_REG(cur_op, 4).o;
                 cur_op += 6;
-                if (REPR(cont)->ID == MVM_REPR_ID_MVMContinuation)
-                    MVM_continuation_invoke(tc, (MVMContinuation *)cont, code, res);
-                else
-                    MVM_exception_throw_adhoc(tc, "continuationinvoke expects an MVMContinuation");
+                MVM_continuation_invoke(tc, cont, code, res);
                 goto NEXT;
             }
             OP(randscale_n):
@@ -5452,6 +5414,31 @@ void MVM_interp_run(MVMThreadContext *tc, void (*initial_invoke)(MVMThreadContex
                 }
                 goto NEXT;
             }
+            OP(sp_findmeth_poly): {
+                /* Check the pairs filled from the types seen at the callsite,
+                 * and the cache pair after them. */
+                MVMObject  *obj       = GET_REG(cur_op, 2).o;
+                MVMuint16   idx       = GET_UI16(cur_op, 8);
+                MVMuint16   num_pairs = GET_UI16(cur_op, 10);
+                MVMSTable  *st        = STABLE(obj);
+                MVMuint16   i;
+                for (i = 0; i <= num_pairs; i++) {
+                    if ((MVMSTable *)tc->cur_frame->effective_spesh_slots[idx + 2 * i] == st) {
+                        GET_REG(cur_op, 0).o = (MVMObject *)tc->cur_frame
+                            ->effective_spesh_slots[idx + 2 * i + 1];
+                        cur_op += 12;
+                        break;
+                    }
+                }
+                if (i > num_pairs) {
+                    /* May invoke, so pre-increment op counter */
+                    MVMString *name = MVM_cu_string(tc, cu, GET_UI32(cur_op, 4));
+                    MVMRegister *res = &GET_REG(cur_op, 0);
+                    cur_op += 12;
+                    MVM_6model_find_method_spesh(tc, obj, name, idx + 2 * num_pairs, res);
+                }
+                goto NEXT;
+            }
             OP(sp_fastcreate): {
                 /* Assume we're in normal code, so doing a nursery allocation.
                  * Also, that there is no initialize. */
@@ -5464,6 +5451,15 @@ void MVM_interp_run(MVMThreadContext *tc, void (*initial_invoke)(MVMThreadContex
                 cur_op += 6;
                 goto NEXT;
             }
+            OP(sp_fastcreate_gen2): {
+                MVMCollectable **spesh_slots = tc->cur_frame->effective_spesh_slots;
+                GET_REG(cur_op, 0).o = MVM_gc_allocate_pretenured(tc, GET_UI16(cur_op, 2),
+                    (MVMSTable *)spesh_slots[GET_UI16(cur_op, 4)],
+                    (MVMStaticFrame *)spesh_slots[GET_UI16(cur_op, 6)],
+                    GET_I32(cur_op, 8));
+                cur_op += 12;
+                goto NEXT;
+            }
             OP(sp_get_o): {
                 MVMObject *val = ((MVMObject *)((char *)GET_REG(cur_op, 2).o + GET_UI16(cur_op, 4)));
                 GET_REG(cur_op, 0).o = val ? val : tc->instance->VMNull;
@@ -5738,6 +5734,110 @@ void MVM_interp_run(MVMThreadContext *tc, void (*initial_invoke)(MVMThreadContex
                 target->st->container_spec->atomic_store(tc, target, value);
                 goto NEXT;
             }
+            OP(sp_vmarray_atpos_i): {
+                MVMObject    *obj  = GET_REG(cur_op, 2).o;
+                MVMArrayBody *body = &((MVMArray *)obj)->body;
+                MVMint64      idx  = GET_REG(cur_op, 4).i64;
+                GET_REG(cur_op, 0).i64 = (MVMuint64)idx < body->elems
+                    ? body->slots.i64[body->start + idx]
+                    : MVM_repr_at_pos_i(tc, obj, idx);
+                cur_op += 6;
+                goto NEXT;
+            }
+            OP(sp_vmarray_atpos_n): {
+                MVMObject    *obj  = GET_REG(cur_op, 2).o;
+                MVMArrayBody *body = &((MVMArray *)obj)->body;
+                MVMint64      idx  = GET_REG(cur_op, 4).i64;
+                GET_REG(cur_op, 0).n64 = (MVMuint64)idx < body->elems
+                    ? body->slots.n64[body->start + idx]
+                    : MVM_repr_at_pos_n(tc, obj, idx);
+                cur_op += 6;
+                goto NEXT;
+            }
+            OP(sp_vmarray_atpos_o): {
+                MVMObject    *obj  = GET_REG(cur_op, 2).o;
+                MVMArrayBody *body = &((MVMArray *)obj)->body;
+                MVMint64      idx  = GET_REG(cur_op, 4).i64;
+                MVMObject    *value;
+                if ((MVMuint64)idx < body->elems) {
+                    value = body->slots.o[body->start + idx];
+                    if (!value)
+                        value = tc->instance->VMNull;
+                }
+                else {
+                    value = MVM_repr_at_pos_o(tc, obj, idx);
+                }
+                GET_REG(cur_op, 0).o = value;
+                cur_op += 6;
+                goto NEXT;
+            }
+            OP(sp_vmarray_bindpos_i): {
+                MVMObject    *obj  = GET_REG(cur_op, 0).o;
+                MVMArrayBody *body = &((MVMArray *)obj)->body;
+                MVMint64      idx  = GET_REG(cur_op, 2).i64;
+                if ((MVMuint64)idx < body->elems)
+                    body->slots.i64[body->start + idx] = GET_REG(cur_op, 4).i64;
+                else
+                    MVM_repr_bind_pos_i(tc, obj, idx, GET_REG(cur_op, 4).i64);
+                cur_op += 6;
+                goto NEXT;
+            }
+            OP(sp_vmarray_bindpos_n): {
+                MVMObject    *obj  = GET_REG(cur_op, 0).o;
+                MVMArrayBody *body = &((MVMArray *)obj)->body;
+                MVMint64      idx  = GET_REG(cur_op, 2).i64;
+                if ((MVMuint64)idx < body->elems)
+                    body->slots.n64[body->start + idx] = GET_REG(cur_op, 4).n64;
+                else
+                    MVM_repr_bind_pos_n(tc, obj, idx, GET_REG(cur_op, 4).n64);
+                cur_op += 6;
+                goto NEXT;
+            }
+            OP(sp_vmarray_bindpos_o): {
+                MVMObject    *obj   = GET_REG(cur_op, 0).o;
+                MVMArrayBody *body  = &((MVMArray *)obj)->body;
+                MVMint64      idx   = GET_REG(cur_op, 2).i64;
+                MVMObject    *value = GET_REG(cur_op, 4).o;
+                if ((MVMuint64)idx < body->elems) {
+                    MVMuint64 slot = body->start + idx;
+                    MVM_vmarray_mark_card(body, slot, value);
+                    MVM_ASSIGN_REF(tc, &(obj->header), body->slots.o[slot], value);
+                }
+                else {
+                    MVM_repr_bind_pos_o(tc, obj, idx, value);
+                }
+                cur_op += 6;
+                goto NEXT;
+            }
+            OP(sp_vmhash_atkey_o): {
+                MVMObject    *obj = GET_REG(cur_op, 2).o;
+                MVMString    *key = GET_REG(cur_op, 4).s;
+                MVMHashEntry *entry;
+                /* A null key goes via the REPR, so that it can complain. */
+                if (key) {
+                    MVM_HASH_GET(tc, ((MVMHash *)obj)->body.hash_head, key, entry);
+                    GET_REG(cur_op, 0).o = entry ? entry->value : tc->instance->VMNull;
+                }
+                else {
+                    GET_REG(cur_op, 0).o = MVM_repr_at_key_o(tc, obj, key);
+                }
+                cur_op += 6;
+                goto NEXT;
+            }
+            OP(sp_vmhash_existskey): {
+                MVMObject    *obj = GET_REG(cur_op, 2).o;
+                MVMString    *key = GET_REG(cur_op, 4).s;
+                MVMHashEntry *entry;
+                if (key) {
+                    MVM_HASH_GET(tc, ((MVMHash *)obj)->body.hash_head, key, entry);
+                    GET_REG(cur_op, 0).i64 = entry != NULL;
+                }
+                else {
+                    GET_REG(cur_op, 0).i64 = MVM_repr_exists_key(tc, obj, key);
+                }
+                cur_op += 6;
+                goto NEXT;
+            }
             OP(prof_enter):
                 MVM_profile_log_enter(tc, tc->cur_frame->static_info,
                     MVM_PROFILE_ENTER_NORMAL);
@@ -5842,6 +5942,22 @@ void MVM_interp_run(MVMThreadContext *tc, void (*initial_invoke)(MVMThreadContex
                 cur_op += 2;
                 goto NEXT;
             }
+            OP(gcstats):
+                GET_REG(cur_op, 0).o = MVM_gc_stats_get(tc);
+                cur_op += 2;
+                goto NEXT;
+            OP(speshmemstats):
+                GET_REG(cur_op, 0).o = MVM_spesh_stats_memory(tc);
+                cur_op += 2;
+                goto NEXT;
+            OP(jitbailstats):
+                GET_REG(cur_op, 0).o = MVM_jit_bail_census(tc);
+                cur_op += 2;
+                goto NEXT;
+            OP(jitmemstats):
+                GET_REG(cur_op, 0).o = MVM_jit_heap_stats(tc);
+                cur_op += 2;
+                goto NEXT;
 #if MVM_CGOTO
             OP_CALL_EXTOP: {
                 /* Bounds checking? Never heard of that. */
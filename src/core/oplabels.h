@@ -779,6 +779,10 @@ static const void * const LABELS[] = {
     &&OP_atomicstore_i,
     &&OP_barrierfull,
     &&OP_coveragecontrol,
+    &&OP_gcstats,
+    &&OP_speshmemstats,
+    &&OP_jitbailstats,
+    &&OP_jitmemstats,
     &&OP_sp_guard,
     &&OP_sp_guardconc,
     &&OP_sp_guardtype,
@@ -802,7 +806,9 @@ static const void * const LABELS[] = {
     &&OP_sp_paramnamesused,
     &&OP_sp_getspeshslot,
     &&OP_sp_findmeth,
+    &&OP_sp_findmeth_poly,
     &&OP_sp_fastcreate,
+    &&OP_sp_fastcreate_gen2,
     &&OP_sp_get_o,
     &&OP_sp_get_i64,
     &&OP_sp_get_i32,
@@ -840,6 +846,14 @@ static const void * const LABELS[] = {
     &&OP_sp_cas_o,
     &&OP_sp_atomicload_o,
     &&OP_sp_atomicstore_o,
+    &&OP_sp_vmarray_atpos_i,
+    &&OP_sp_vmarray_atpos_n,
+    &&OP_sp_vmarray_atpos_o,
+    &&OP_sp_vmarray_bindpos_i,
+    &&OP_sp_vmarray_bindpos_n,
+    &&OP_sp_vmarray_bindpos_o,
+    &&OP_sp_vmhash_atkey_o,
+    &&OP_sp_vmhash_existskey,
     &&OP_prof_enter,
     &&OP_prof_enterspesh,
     &&OP_prof_enterinline,
@@ -1011,20 +1025,6 @@ static const void * const LABELS[] = {
     NULL,
     NULL,
     NULL,
-    NULL,
-    NULL,
-    NULL,
-    NULL,
-    NULL,
-    NULL,
-    NULL,
-    NULL,
-    NULL,
-    NULL,
-    NULL,
-    NULL,
-    NULL,
-    NULL,
     &&OP_CALL_EXTOP,
     &&OP_CALL_EXTOP,
     &&OP_CALL_EXTOP,
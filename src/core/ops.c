@@ -570,8 +570,8 @@ static const MVMOpInfo MVM_op_infos[] = {
         "  ",
         2,
         1,
-        0,
-        0,
+        1,
+        1,
         1,
         0,
         { MVM_operand_write_reg | MVM_operand_obj, MVM_operand_read_reg | MVM_operand_str }
@@ -3054,7 +3054,7 @@ static const MVMOpInfo MVM_op_infos[] = {
         2,
         1,
         0,
-        0,
+        1,
         0,
         0,
         { MVM_operand_write_reg | MVM_operand_obj, MVM_operand_read_reg | MVM_operand_obj }
@@ -6255,8 +6255,8 @@ static const MVMOpInfo MVM_op_infos[] = {
         "  ",
         2,
         1,
-        0,
-        0,
+        1,
+        1,
         1,
         0,
         { MVM_operand_write_reg | MVM_operand_obj, MVM_operand_read_reg | MVM_operand_str }
@@ -9328,6 +9328,54 @@ static const MVMOpInfo MVM_op_infos[] = {
         0,
         { MVM_operand_read_reg | MVM_operand_int64 }
     },
+    {
+        MVM_OP_gcstats,
+        "gcstats",
+        "  ",
+        1,
+        0,
+        0,
+        0,
+        0,
+        0,
+        { MVM_operand_write_reg | MVM_operand_obj }
+    },
+    {
+        MVM_OP_speshmemstats,
+        "speshmemstats",
+        "  ",
+        1,
+        0,
+        0,
+        0,
+        0,
+        0,
+        { MVM_operand_write_reg | MVM_operand_obj }
+    },
+    {
+        MVM_OP_jitbailstats,
+        "jitbailstats",
+        "  ",
+        1,
+        0,
+        0,
+        0,
+        0,
+        0,
+        { MVM_operand_write_reg | MVM_operand_obj }
+    },
+    {
+        MVM_OP_jitmemstats,
+        "jitmemstats",
+        "  ",
+        1,
+        0,
+        0,
+        0,
+        0,
+        0,
+        { MVM_operand_write_reg | MVM_operand_obj }
+    },
     {
         MVM_OP_sp_guard,
         "sp_guard",
@@ -9604,6 +9652,18 @@ static const MVMOpInfo MVM_op_infos[] = {
         0,
         { MVM_operand_write_reg | MVM_operand_obj, MVM_operand_read_reg | MVM_operand_obj, MVM_operand_str, MVM_operand_spesh_slot }
     },
+    {
+        MVM_OP_sp_findmeth_poly,
+        "sp_findmeth_poly",
+        ".s",
+        5,
+        1,
+        0,
+        0,
+        0,
+        0,
+        { MVM_operand_write_reg | MVM_operand_obj, MVM_operand_read_reg | MVM_operand_obj, MVM_operand_str, MVM_operand_spesh_slot, MVM_operand_int16 }
+    },
     {
         MVM_OP_sp_fastcreate,
         "sp_fastcreate",
@@ -9616,6 +9676,18 @@ static const MVMOpInfo MVM_op_infos[] = {
         0,
         { MVM_operand_write_reg | MVM_operand_obj, MVM_operand_int16, MVM_operand_spesh_slot }
     },
+    {
+        MVM_OP_sp_fastcreate_gen2,
+        "sp_fastcreate_gen2",
+        ".s",
+        5,
+        1,
+        0,
+        0,
+        0,
+        0,
+        { MVM_operand_write_reg | MVM_operand_obj, MVM_operand_int16, MVM_operand_spesh_slot, MVM_operand_spesh_slot, MVM_operand_int32 }
+    },
     {
         MVM_OP_sp_get_o,
         "sp_get_o",
@@ -10060,6 +10132,102 @@ static const MVMOpInfo MVM_op_infos[] = {
         1,
         { MVM_operand_read_reg | MVM_operand_obj, MVM_operand_read_reg | MVM_operand_obj }
     },
+    {
+        MVM_OP_sp_vmarray_atpos_i,
+        "sp_vmarray_atpos_i",
+        ".s",
+        3,
+        0,
+        0,
+        0,
+        0,
+        0,
+        { MVM_operand_write_reg | MVM_operand_int64, MVM_operand_read_reg | MVM_operand_obj, MVM_operand_read_reg | MVM_operand_int64 }
+    },
+    {
+        MVM_OP_sp_vmarray_atpos_n,
+        "sp_vmarray_atpos_n",
+        ".s",
+        3,
+        0,
+        0,
+        0,
+        0,
+        0,
+        { MVM_operand_write_reg | MVM_operand_num64, MVM_operand_read_reg | MVM_operand_obj, MVM_operand_read_reg | MVM_operand_int64 }
+    },
+    {
+        MVM_OP_sp_vmarray_atpos_o,
+        "sp_vmarray_atpos_o",
+        ".s",
+        3,
+        0,
+        0,
+        0,
+        0,
+        0,
+        { MVM_operand_write_reg | MVM_operand_obj, MVM_operand_read_reg | MVM_operand_obj, MVM_operand_read_reg | MVM_operand_int64 }
+    },
+    {
+        MVM_OP_sp_vmarray_bindpos_i,
+        "sp_vmarray_bindpos_i",
+        ".s",
+        3,
+        0,
+        0,
+        0,
+        0,
+        0,
+        { MVM_operand_read_reg | MVM_operand_obj, MVM_operand_read_reg | MVM_operand_int64, MVM_operand_read_reg | MVM_operand_int64 }
+    },
+    {
+        MVM_OP_sp_vmarray_bindpos_n,
+        "sp_vmarray_bindpos_n",
+        ".s",
+        3,
+        0,
+        0,
+        0,
+        0,
+        0,
+        { MVM_operand_read_reg | MVM_operand_obj, MVM_operand_read_reg | MVM_operand_int64, MVM_operand_read_reg | MVM_operand_num64 }
+    },
+    {
+        MVM_OP_sp_vmarray_bindpos_o,
+        "sp_vmarray_bindpos_o",
+        ".s",
+        3,
+        0,
+        0,
+        0,
+        0,
+        0,
+        { MVM_operand_read_reg | MVM_operand_obj, MVM_operand_read_reg | MVM_operand_int64, MVM_operand_read_reg | MVM_operand_obj }
+    },
+    {
+        MVM_OP_sp_vmhash_atkey_o,
+        "sp_vmhash_atkey_o",
+        ".s",
+        3,
+        0,
+        0,
+        0,
+        0,
+        0,
+        { MVM_operand_write_reg | MVM_operand_obj, MVM_operand_read_reg | MVM_operand_obj, MVM_operand_read_reg | MVM_operand_str }
+    },
+    {
+        MVM_OP_sp_vmhash_existskey,
+        "sp_vmhash_existskey",
+        ".s",
+        3,
+        0,
+        0,
+        0,
+        0,
+        0,
+        { MVM_operand_write_reg | MVM_operand_int64, MVM_operand_read_reg | MVM_operand_obj, MVM_operand_read_reg | MVM_operand_str }
+    },
     {
         MVM_OP_prof_enter,
         "prof_enter",
@@ -10155,7 +10323,7 @@ static const MVMOpInfo MVM_op_infos[] = {
     },
 };
 
-static const unsigned short MVM_op_counts = 847;
+static const unsigned short MVM_op_counts = 861;
 
 MVM_PUBLIC const MVMOpInfo * MVM_op_get_op(unsigned short op) {
     if (op >= MVM_op_counts)
@@ -779,75 +779,89 @@
 #define MVM_OP_atomicstore_i 775
 #define MVM_OP_barrierfull 776
 #define MVM_OP_coveragecontrol 777
-#define MVM_OP_sp_guard 778
-#define MVM_OP_sp_guardconc 779
-#define MVM_OP_sp_guardtype 780
-#define MVM_OP_sp_guardsf 781
-#define MVM_OP_sp_guardsfouter 782
-#define MVM_OP_sp_rebless 783
-#define MVM_OP_sp_resolvecode 784
-#define MVM_OP_sp_decont 785
-#define MVM_OP_sp_getlex_o 786
-#define MVM_OP_sp_getlex_ins 787
-#define MVM_OP_sp_getlex_no 788
-#define MVM_OP_sp_getarg_o 789
-#define MVM_OP_sp_getarg_i 790
-#define MVM_OP_sp_getarg_n 791
-#define MVM_OP_sp_getarg_s 792
-#define MVM_OP_sp_fastinvoke_v 793
-#define MVM_OP_sp_fastinvoke_i 794
-#define MVM_OP_sp_fastinvoke_n 795
-#define MVM_OP_sp_fastinvoke_s 796
-#define MVM_OP_sp_fastinvoke_o 797
-#define MVM_OP_sp_paramnamesused 798
-#define MVM_OP_sp_getspeshslot 799
-#define MVM_OP_sp_findmeth 800
-#define MVM_OP_sp_fastcreate 801
-#define MVM_OP_sp_get_o 802
-#define MVM_OP_sp_get_i64 803
-#define MVM_OP_sp_get_i32 804
-#define MVM_OP_sp_get_i16 805
-#define MVM_OP_sp_get_i8 806
-#define MVM_OP_sp_get_n 807
-#define MVM_OP_sp_get_s 808
-#define MVM_OP_sp_bind_o 809
-#define MVM_OP_sp_bind_i64 810
-#define MVM_OP_sp_bind_i32 811
-#define MVM_OP_sp_bind_i16 812
-#define MVM_OP_sp_bind_i8 813
-#define MVM_OP_sp_bind_n 814
-#define MVM_OP_sp_bind_s 815
-#define MVM_OP_sp_p6oget_o 816
-#define MVM_OP_sp_p6ogetvt_o 817
-#define MVM_OP_sp_p6ogetvc_o 818
-#define MVM_OP_sp_p6oget_i 819
-#define MVM_OP_sp_p6oget_n 820
-#define MVM_OP_sp_p6oget_s 821
-#define MVM_OP_sp_p6obind_o 822
-#define MVM_OP_sp_p6obind_i 823
-#define MVM_OP_sp_p6obind_n 824
-#define MVM_OP_sp_p6obind_s 825
-#define MVM_OP_sp_deref_get_i64 826
-#define MVM_OP_sp_deref_get_n 827
-#define MVM_OP_sp_deref_bind_i64 828
-#define MVM_OP_sp_deref_bind_n 829
-#define MVM_OP_sp_getlexvia_o 830
-#define MVM_OP_sp_getlexvia_ins 831
-#define MVM_OP_sp_jit_enter 832
-#define MVM_OP_sp_boolify_iter 833
-#define MVM_OP_sp_boolify_iter_arr 834
-#define MVM_OP_sp_boolify_iter_hash 835
-#define MVM_OP_sp_cas_o 836
-#define MVM_OP_sp_atomicload_o 837
-#define MVM_OP_sp_atomicstore_o 838
-#define MVM_OP_prof_enter 839
-#define MVM_OP_prof_enterspesh 840
-#define MVM_OP_prof_enterinline 841
-#define MVM_OP_prof_enternative 842
-#define MVM_OP_prof_exit 843
-#define MVM_OP_prof_allocated 844
-#define MVM_OP_ctw_check 845
-#define MVM_OP_coverage_log 846
+#define MVM_OP_gcstats 778
+#define MVM_OP_speshmemstats 779
+#define MVM_OP_jitbailstats 780
+#define MVM_OP_jitmemstats 781
+#define MVM_OP_sp_guard 782
+#define MVM_OP_sp_guardconc 783
+#define MVM_OP_sp_guardtype 784
+#define MVM_OP_sp_guardsf 785
+#define MVM_OP_sp_guardsfouter 786
+#define MVM_OP_sp_rebless 787
+#define MVM_OP_sp_resolvecode 788
+#define MVM_OP_sp_decont 789
+#define MVM_OP_sp_getlex_o 790
+#define MVM_OP_sp_getlex_ins 791
+#define MVM_OP_sp_getlex_no 792
+#define MVM_OP_sp_getarg_o 793
+#define MVM_OP_sp_getarg_i 794
+#define MVM_OP_sp_getarg_n 795
+#define MVM_OP_sp_getarg_s 796
+#define MVM_OP_sp_fastinvoke_v 797
+#define MVM_OP_sp_fastinvoke_i 798
+#define MVM_OP_sp_fastinvoke_n 799
+#define MVM_OP_sp_fastinvoke_s 800
+#define MVM_OP_sp_fastinvoke_o 801
+#define MVM_OP_sp_paramnamesused 802
+#define MVM_OP_sp_getspeshslot 803
+#define MVM_OP_sp_findmeth 804
+#define MVM_OP_sp_findmeth_poly 805
+#define MVM_OP_sp_fastcreate 806
+#define MVM_OP_sp_fastcreate_gen2 807
+#define MVM_OP_sp_get_o 808
+#define MVM_OP_sp_get_i64 809
+#define MVM_OP_sp_get_i32 810
+#define MVM_OP_sp_get_i16 811
+#define MVM_OP_sp_get_i8 812
+#define MVM_OP_sp_get_n 813
+#define MVM_OP_sp_get_s 814
+#define MVM_OP_sp_bind_o 815
+#define MVM_OP_sp_bind_i64 816
+#define MVM_OP_sp_bind_i32 817
+#define MVM_OP_sp_bind_i16 818
+#define MVM_OP_sp_bind_i8 819
+#define MVM_OP_sp_bind_n 820
+#define MVM_OP_sp_bind_s 821
+#define MVM_OP_sp_p6oget_o 822
+#define MVM_OP_sp_p6ogetvt_o 823
+#define MVM_OP_sp_p6ogetvc_o 824
+#define MVM_OP_sp_p6oget_i 825
+#define MVM_OP_sp_p6oget_n 826
+#define MVM_OP_sp_p6oget_s 827
+#define MVM_OP_sp_p6obind_o 828
+#define MVM_OP_sp_p6obind_i 829
+#define MVM_OP_sp_p6obind_n 830
+#define MVM_OP_sp_p6obind_s 831
+#define MVM_OP_sp_deref_get_i64 832
+#define MVM_OP_sp_deref_get_n 833
+#define MVM_OP_sp_deref_bind_i64 834
+#define MVM_OP_sp_deref_bind_n 835
+#define MVM_OP_sp_getlexvia_o 836
+#define MVM_OP_sp_getlexvia_ins 837
+#define MVM_OP_sp_jit_enter 838
+#define MVM_OP_sp_boolify_iter 839
+#define MVM_OP_sp_boolify_iter_arr 840
+#define MVM_OP_sp_boolify_iter_hash 841
+#define MVM_OP_sp_cas_o 842
+#define MVM_OP_sp_atomicload_o 843
+#define MVM_OP_sp_atomicstore_o 844
+#define MVM_OP_sp_vmarray_atpos_i 845
+#define MVM_OP_sp_vmarray_atpos_n 846
+#define MVM_OP_sp_vmarray_atpos_o 847
+#define MVM_OP_sp_vmarray_bindpos_i 848
+#define MVM_OP_sp_vmarray_bindpos_n 849
+#define MVM_OP_sp_vmarray_bindpos_o 850
+#define MVM_OP_sp_vmhash_atkey_o 851
+#define MVM_OP_sp_vmhash_existskey 852
+#define MVM_OP_prof_enter 853
+#define MVM_OP_prof_enterspesh 854
+#define MVM_OP_prof_enterinline 855
+#define MVM_OP_prof_enternative 856
+#define MVM_OP_prof_exit 857
+#define MVM_OP_prof_allocated 858
+#define MVM_OP_ctw_check 859
+#define MVM_OP_coverage_log 860
 
 #define MVM_OP_EXT_BASE 1024
 #define MVM_OP_EXT_CU_LIMIT 1024
@@ -1,5 +1,22 @@
 #include "moar.h"
 
+/* Takes a spare block of the wanted size from the thread's list of them, if
+ * there is one. Spare blocks have had the memory used in them zeroed. */
+static MVMRegionBlock * take_spare_block(MVMThreadContext *tc, size_t buffer_size) {
+    MVMRegionBlock **link = &(tc->region_spare_blocks);
+    while (*link) {
+        MVMRegionBlock *block = *link;
+        if ((size_t)(block->limit - block->buffer) == buffer_size) {
+            *link = block->prev;
+            tc->num_region_spare_blocks--;
+            MVM_incr(&(tc->instance->region_blocks_reused));
+            return block;
+        }
+        link = &(block->prev);
+    }
+    return NULL;
+}
+
 void * MVM_region_alloc(MVMThreadContext *tc, MVMRegionAlloc *al, size_t bytes) {
     char *result = NULL;
 
@@ -12,16 +29,22 @@ void * MVM_region_alloc(MVMThreadContext *tc, MVMRegionAlloc *al, size_t bytes)
         result = al->block->alloc;
         al->block->alloc += bytes;
     } else {
-        /* No block, or block was full. Add another. */
-        MVMRegionBlock *block = MVM_malloc(sizeof(MVMRegionBlock));
+        /* No block, or block was full. Add another, reusing a spare one if
+         * we can. */
         size_t buffer_size = al->block == NULL
             ? MVM_REGIONALLOC_FIRST_MEMBLOCK_SIZE
             : MVM_REGIONALLOC_MEMBLOCK_SIZE;
+        MVMRegionBlock *block;
         if (buffer_size < bytes)
             buffer_size = bytes;
-        block->buffer = MVM_calloc(1, buffer_size);
+        block = take_spare_block(tc, buffer_size);
+        if (!block) {
+            block = MVM_malloc(sizeof(MVMRegionBlock));
+            block->buffer = MVM_calloc(1, buffer_size);
+            block->limit  = block->buffer + buffer_size;
+            MVM_add(&(tc->instance->region_bytes), buffer_size);
+        }
         block->alloc  = block->buffer;
-        block->limit  = block->buffer + buffer_size;
         block->prev   = al->block;
         al->block     = block;
 
@@ -32,14 +55,44 @@ void * MVM_region_alloc(MVMThreadContext *tc, MVMRegionAlloc *al, size_t bytes)
     return result;
 }
 
+/* Frees a block, updating the count of memory held in them. */
+static void free_block(MVMThreadContext *tc, MVMRegionBlock *block) {
+    MVM_add(&(tc->instance->region_bytes), -(AO_t)(block->limit - block->buffer));
+    MVM_free(block->buffer);
+    MVM_free(block);
+}
+
 void MVM_region_destroy(MVMThreadContext *tc, MVMRegionAlloc *alloc) {
     MVMRegionBlock *block = alloc->block;
-    /* Free all of the allocated memory. */
+    /* Free all of the allocated memory, keeping blocks of the default sizes
+     * (zeroed again) for reuse by later regions, up to a limit. */
     while (block) {
         MVMRegionBlock *prev = block->prev;
-        MVM_free(block->buffer);
-        MVM_free(block);
+        size_t buffer_size = block->limit - block->buffer;
+        if ((buffer_size == MVM_REGIONALLOC_FIRST_MEMBLOCK_SIZE ||
+                buffer_size == MVM_REGIONALLOC_MEMBLOCK_SIZE) &&
+                tc->num_region_spare_blocks < MVM_REGIONALLOC_MAX_SPARE_BLOCKS) {
+            memset(block->buffer, 0, block->alloc - block->buffer);
+            block->prev = tc->region_spare_blocks;
+            tc->region_spare_blocks = block;
+            tc->num_region_spare_blocks++;
+        }
+        else {
+            free_block(tc, block);
+        }
         block = prev;
     }
     alloc->block = NULL;
 }
+
+/* Frees the spare blocks a thread is holding on to. */
+void MVM_region_destroy_spare_blocks(MVMThreadContext *tc) {
+    MVMRegionBlock *block = tc->region_spare_blocks;
+    while (block) {
+        MVMRegionBlock *prev = block->prev;
+        free_block(tc, block);
+        block = prev;
+    }
+    tc->region_spare_blocks = NULL;
+    tc->num_region_spare_blocks = 0;
+}
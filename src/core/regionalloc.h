@@ -22,5 +22,10 @@ struct MVMRegionAlloc {
 #define MVM_REGIONALLOC_FIRST_MEMBLOCK_SIZE 32768
 #define MVM_REGIONALLOC_MEMBLOCK_SIZE       8192
 
+/* The most blocks of the default sizes a thread keeps around for reuse when
+ * a region is destroyed, rather than freeing them. */
+#define MVM_REGIONALLOC_MAX_SPARE_BLOCKS    32
+
 void * MVM_region_alloc(MVMThreadContext *tc, MVMRegionAlloc *alloc, size_t s);
 void MVM_region_destroy(MVMThreadContext *tc, MVMRegionAlloc *alloc);
+void MVM_region_destroy_spare_blocks(MVMThreadContext *tc);
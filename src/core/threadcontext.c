@@ -27,9 +27,16 @@ MVMThreadContext * MVM_tc_create(MVMThreadContext *parent, MVMInstance *instance
 
     /* Set up GC nursery. We only allocate tospace initially, and allocate
      * fromspace the first time this thread GCs, provided it ever does. */
-    tc->nursery_tospace     = MVM_calloc(1, MVM_NURSERY_SIZE);
-    tc->nursery_alloc       = tc->nursery_tospace;
-    tc->nursery_alloc_limit = (char *)tc->nursery_alloc + MVM_NURSERY_SIZE;
+    tc->nursery_size = MVM_NURSERY_SIZE;
+    if (tc->nursery_size < instance->nursery_size_min)
+        tc->nursery_size = instance->nursery_size_min;
+    if (tc->nursery_size > instance->nursery_size_max)
+        tc->nursery_size = instance->nursery_size_max;
+    tc->nursery_tospace      = MVM_calloc(1, tc->nursery_size);
+    tc->nursery_tospace_size = tc->nursery_size;
+    tc->nursery_alloc        = tc->nursery_tospace;
+    tc->nursery_alloc_limit  = (char *)tc->nursery_alloc + tc->nursery_size;
+    tc->nursery_last_gc      = MVM_platform_now();
 
     /* Set up temporary root handling. */
     tc->num_temproots   = 0;
@@ -75,6 +82,8 @@ void MVM_tc_destroy(MVMThreadContext *tc) {
 
     /* Free specialization state. */
     MVM_spesh_sim_stack_destroy(tc, tc->spesh_sim_stack);
+    MVM_free(tc->spesh_alloc_samples);
+    MVM_region_destroy_spare_blocks(tc);
 
     /* Free the nursery and finalization queue. */
     MVM_free(tc->nursery_fromspace);
@@ -94,6 +103,7 @@ void MVM_tc_destroy(MVMThreadContext *tc) {
     MVM_free(tc->gc_work);
     MVM_free(tc->temproots);
     MVM_free(tc->gen2roots);
+    MVM_free(tc->gc_mark_log);
     MVM_free(tc->finalize);
 
     /* Free any memory allocated for NFAs and multi-dim indices. */
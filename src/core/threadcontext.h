@@ -60,6 +60,17 @@ struct MVMThreadContext {
     /* The end of the space we're allowed to allocate to. */
     void *nursery_alloc_limit;
 
+    /* The sizes of fromspace and tospace. These may differ, since we decide
+     * on a new nursery size after each GC run, which is only applied to the
+     * semi-space that becomes tospace the next time they are swapped. */
+    MVMuint32 nursery_fromspace_size;
+    MVMuint32 nursery_tospace_size;
+
+    /* The nursery size we decided on after the last GC run, and when that
+     * GC run took place. */
+    MVMuint32 nursery_size;
+    MVMuint64 nursery_last_gc;
+
     /* This thread's GC status. */
     AO_t gc_status;
 
@@ -73,6 +84,18 @@ struct MVMThreadContext {
     /* Number of bytes promoted to gen2 in current GC run. */
     MVMuint32 gc_promoted_bytes;
 
+    /* Number of bytes allocated straight into gen2 at pretenured allocation
+     * sites since the last GC run; counted along with promoted bytes. */
+    MVMuint32 gc_pretenured_bytes;
+
+    /* Number of bytes of memory outside of the GC heap taken on since the
+     * last GC run by objects already in gen2, such as when the storage of a
+     * big array grows; also counted along with promoted bytes. */
+    MVMuint64 gc_gen2_unmanaged_bytes;
+
+    /* GC statistics for this thread. */
+    MVMGCStats gc_stats;
+
     /* Temporarily rooted objects. This is generally used by code written in
      * C that wants to keep references to objects. Since those may change
      * if the code in question also allocates, there is a need to register
@@ -90,6 +113,13 @@ struct MVMThreadContext {
     MVMuint32             alloc_gen2roots;
     MVMCollectable      **gen2roots;
 
+    /* Generation 2 collectables that are yet to be marked and scanned by
+     * the current incremental marking cycle, if any. Appended to by the
+     * write barrier and the GC, and worked through by the GC. */
+    MVMuint32             num_gc_mark_log;
+    MVMuint32             alloc_gc_mark_log;
+    MVMCollectable      **gc_mark_log;
+
     /* Finalize queue objects, which need to have a finalizer invoked once
      * they are no longer referenced from anywhere except this queue. */
     MVMuint32             num_finalize;
@@ -180,6 +210,11 @@ struct MVMThreadContext {
      * change to produce some specializations. */
     AO_t spesh_log_quota;
 
+    /* Region allocator blocks kept for reuse once the region (typically a
+     * spesh graph) they were in was destroyed, and how many there are. */
+    MVMRegionBlock *region_spare_blocks;
+    MVMuint32 num_region_spare_blocks;
+
     /* The spesh stack simulation, perserved between processing logs. */
     MVMSpeshSimStack *spesh_sim_stack;
 
@@ -191,6 +226,15 @@ struct MVMThreadContext {
     /* The current specialization correlation ID, used in logging. */
     MVMuint32 spesh_cid;
 
+    /* Sampled allocations whose survival we are waiting to learn of, so it
+     * can be logged for the specializer's pretenuring decisions. The GC
+     * resolves these after each collection. */
+    MVMSpeshAllocSample *spesh_alloc_samples;
+    MVMuint32 num_spesh_alloc_samples;
+
+    /* Countdown to sampling the next allocation made at a pretenured site. */
+    MVMuint32 spesh_pretenure_countdown;
+
 #if MVM_GC_DEBUG
     /* Whether we are currently in the specializer. Used to catch GC runs that
      * take place at times they never should. */
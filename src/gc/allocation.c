@@ -27,8 +27,15 @@ void * MVM_gc_allocate_nursery(MVMThreadContext *tc, size_t size) {
          * second generation. Note that this circumstance is exceptionally
          * unlikely in any non-contrived situation. */
         while ((char *)tc->nursery_alloc + size >= (char *)tc->nursery_alloc_limit) {
-            if (size > MVM_NURSERY_SIZE)
-                MVM_panic(MVM_exitcode_gcalloc, "Attempt to allocate more than the maximum nursery size");
+            /* The nursery is sized to the thread's allocation rate, and may
+             * be too small to ever hold this; put it straight in gen2. As
+             * its creator may not expect that and initialize it without
+             * write barriers, add it to the gen2 roots right away. */
+            if (size >= tc->nursery_tospace_size) {
+                allocated = MVM_gc_allocate_gen2(tc, size);
+                MVM_gc_write_barrier_hit(tc, (MVMCollectable *)allocated);
+                return allocated;
+            }
             MVM_gc_enter_from_allocator(tc);
         }
 
@@ -43,6 +50,19 @@ void * MVM_gc_allocate_nursery(MVMThreadContext *tc, size_t size) {
     return allocated;
 }
 
+/* Allocate the specified amount of memory directly in the second generation,
+ * zeroed. If an incremental marking cycle is in progress, the new object is
+ * logged so that it will be marked (and scanned once it has been set up).
+ * Code allocating directly in gen2 commonly relies on the object not moving,
+ * so it is pinned in place should gen2 be compacted. */
+void * MVM_gc_allocate_gen2(MVMThreadContext *tc, size_t size) {
+    void *allocated = MVM_gc_gen2_allocate_zeroed(tc->gen2, size);
+    ((MVMCollectable *)allocated)->flags |= MVM_CF_GEN2_PINNED;
+    if (tc->instance->gc_marking)
+        MVM_gc_write_barrier_log(tc, (MVMCollectable *)allocated);
+    return allocated;
+}
+
 /* Same as MVM_gc_allocate, but promises that the memory will be zeroed. */
 void * MVM_gc_allocate_zeroed(MVMThreadContext *tc, size_t size) {
     /* At present, MVM_gc_allocate always returns zeroed memory. */
@@ -94,6 +114,53 @@ MVMObject * MVM_gc_allocate_object(MVMThreadContext *tc, MVMSTable *st) {
     return obj;
 }
 
+/* Allocates an object at a pretenured allocation site; that is, one where the
+ * specializer saw the objects nearly always survive to the second generation,
+ * so we allocate them there right away and save copying them twice. One in
+ * every so many is still allocated in the nursery and sampled, so we notice
+ * if the site stops producing long-lived objects; pretenuring in the frame
+ * is then revoked, and we go back to allocating in the nursery. As with the
+ * sp_fastcreate op, there is no initialize. */
+MVMObject * MVM_gc_allocate_pretenured(MVMThreadContext *tc, MVMuint16 size, MVMSTable *st,
+                                       MVMStaticFrame *sf, MVMint32 bytecode_offset) {
+    MVMObject *obj;
+    MVMint32   sample = 0;
+    if (!sf->body.spesh->body.pretenure_revoked) {
+        if (tc->spesh_pretenure_countdown == 0) {
+            tc->spesh_pretenure_countdown = MVM_SPESH_PRETENURE_SAMPLE_INTERVAL;
+            sample = 1;
+        }
+        else {
+            tc->spesh_pretenure_countdown--;
+        }
+    }
+    MVMROOT(tc, st, {
+    MVMROOT(tc, sf, {
+        if (sample || sf->body.spesh->body.pretenure_revoked) {
+            obj = MVM_gc_allocate_zeroed(tc, size);
+        }
+        else {
+            /* Not going via the nursery, so check for GC interrupts here. */
+            if (tc->gc_status)
+                MVM_gc_enter_from_interrupt(tc);
+            obj = MVM_gc_allocate_gen2(tc, size);
+            obj->header.flags &= ~MVM_CF_GEN2_PINNED;
+            tc->gc_pretenured_bytes += size;
+        }
+        obj->header.size  = size;
+        obj->header.owner = tc->thread_id;
+        MVM_ASSIGN_REF(tc, &(obj->header), obj->st, st);
+        /* Logging the sample may allocate, and so move the object. */
+        if (sample) {
+            MVMROOT(tc, obj, {
+                MVM_spesh_log_pretenured_allocation(tc, obj, sf, bytecode_offset);
+            });
+        }
+    });
+    });
+    return obj;
+}
+
 /* Allocates a new heap frame. */
 MVMFrame * MVM_gc_allocate_frame(MVMThreadContext *tc) {
     MVMFrame *f = MVM_gc_allocate_zeroed(tc, sizeof(MVMFrame));
@@ -1,4 +1,5 @@
 #include "moar.h"
+#include "platform/time.h"
 
 /* Combines a piece of work that will be passed to another thread with the
  * ID of the target thread to pass it to. */
@@ -18,6 +19,9 @@ static void process_worklist(MVMThreadContext *tc, MVMGCWorklist *worklist, Work
 static void pass_work_item(MVMThreadContext *tc, WorkToPass *wtp, MVMCollectable **item_ptr);
 static void pass_leftover_work(MVMThreadContext *tc, WorkToPass *wtp);
 static void add_in_tray_to_worklist(MVMThreadContext *tc, MVMGCWorklist *worklist);
+static void share_gen2_work(MVMThreadContext *tc, MVMGCWorklist *worklist);
+static void add_stolen_work_to_worklist(MVMThreadContext *tc, MVMGCWorklist *worklist);
+static void finish_incremental_marking(MVMThreadContext *tc, MVMGCWorklist *worklist, WorkToPass *wtp);
 
 /* Does a garbage collection run. Exactly what it does is configured by the
  * couple of arguments that it takes.
@@ -40,8 +44,11 @@ static void add_in_tray_to_worklist(MVMThreadContext *tc, MVMGCWorklist *worklis
  * Note that it adds the roots and processes them in phases, to try to avoid
  * building up a huge worklist. */
 void MVM_gc_collect(MVMThreadContext *tc, MVMuint8 what_to_do, MVMuint8 gen) {
-    /* Create a GC worklist. */
-    MVMGCWorklist *worklist = MVM_gc_worklist_create(tc, gen != MVMGCGenerations_Nursery);
+    /* Create a GC worklist. If we're in an incremental marking cycle, we need
+     * to see gen2 objects even in a nursery collection, so we can log them to
+     * be marked. */
+    MVMuint8 include_gen2 = gen != MVMGCGenerations_Nursery || tc->instance->gc_marking;
+    MVMGCWorklist *worklist = MVM_gc_worklist_create(tc, include_gen2);
 
     /* Initialize work passing data structure. */
     WorkToPass wtp;
@@ -55,6 +62,12 @@ void MVM_gc_collect(MVMThreadContext *tc, MVMuint8 what_to_do, MVMuint8 gen) {
         GCDEBUG_LOG(tc, MVM_GC_DEBUG_COLLECT, "Thread %d run %d : processing %d items from in tray \n", worklist->items);
         process_worklist(tc, worklist, &wtp, gen);
     }
+    else if (what_to_do == MVMGCWhatToDo_Stolen) {
+        /* We just need to process a chunk of work from the steal pool. */
+        add_stolen_work_to_worklist(tc, worklist);
+        GCDEBUG_LOG(tc, MVM_GC_DEBUG_COLLECT, "Thread %d run %d : processing %d items stolen from steal pool \n", worklist->items);
+        process_worklist(tc, worklist, &wtp, gen);
+    }
     else if (what_to_do == MVMGCWhatToDo_Finalizing) {
         /* Need to process the finalizing queue. */
         MVMuint32 i;
@@ -69,14 +82,27 @@ void MVM_gc_collect(MVMThreadContext *tc, MVMuint8 what_to_do, MVMuint8 gen) {
          * startup, to cut memory use for threads that quit before a GC). */
         void *fromspace = tc->nursery_tospace;
         void *tospace   = tc->nursery_fromspace;
-        if (!tospace)
-            tospace = MVM_calloc(1, MVM_NURSERY_SIZE);
-        tc->nursery_fromspace = fromspace;
-        tc->nursery_tospace   = tospace;
+        MVMuint32 fromspace_size = tc->nursery_tospace_size;
+        MVMuint32 tospace_size   = tc->nursery_size;
+
+        /* This is also the point where the nursery size we decided on last
+         * time is applied, by re-allocating the new tospace if needed. It
+         * must never be smaller than what is allocated in the fromspace, as
+         * that is how much could survive and be copied into it. */
+        if (tospace_size < (MVMuint32)((char *)tc->nursery_alloc - (char *)fromspace))
+            tospace_size = fromspace_size;
+        if (!tospace || tc->nursery_fromspace_size != tospace_size) {
+            MVM_free(tospace);
+            tospace = MVM_calloc(1, tospace_size);
+        }
+        tc->nursery_fromspace      = fromspace;
+        tc->nursery_fromspace_size = fromspace_size;
+        tc->nursery_tospace        = tospace;
+        tc->nursery_tospace_size   = tospace_size;
 
         /* Reset nursery allocation pointers to the new tospace. */
         tc->nursery_alloc       = tospace;
-        tc->nursery_alloc_limit = (char *)tc->nursery_alloc + MVM_NURSERY_SIZE;
+        tc->nursery_alloc_limit = (char *)tc->nursery_alloc + tospace_size;
 
         /* Add permanent roots and process them; only one thread will do
         * this, since they are instance-wide. */
@@ -124,11 +150,19 @@ void MVM_gc_collect(MVMThreadContext *tc, MVMuint8 what_to_do, MVMuint8 gen) {
         * collection anyway (in fact, we must not for correctness, otherwise
         * the gen2 rooting keeps them alive forever). */
         if (gen == MVMGCGenerations_Nursery) {
+            worklist->include_gen2 = 0;
             MVM_gc_root_add_gen2s_to_worklist(tc, worklist);
+            worklist->include_gen2 = include_gen2;
             GCDEBUG_LOG(tc, MVM_GC_DEBUG_COLLECT, "Thread %d run %d : processing %d items from gen2 \n", worklist->items);
             process_worklist(tc, worklist, &wtp, gen);
         }
 
+        /* If this full collection finishes an incremental marking cycle, deal
+         * with the objects logged for marking and anything else that was not
+         * covered by the write barrier. */
+        if (gen == MVMGCGenerations_Both && tc->instance->gc_marking)
+            finish_incremental_marking(tc, worklist, &wtp);
+
         /* Process anything in the in-tray. */
         add_in_tray_to_worklist(tc, worklist);
         GCDEBUG_LOG(tc, MVM_GC_DEBUG_COLLECT, "Thread %d run %d : processing %d items from in tray \n", worklist->items);
@@ -173,12 +207,25 @@ static void process_worklist(MVMThreadContext *tc, MVMGCWorklist *worklist, Work
         if (item == NULL)
             continue;
 
+        /* If we've built up a lot of work in a full collection and some other
+         * thread is idle, share some of it. */
+        if (gen == MVMGCGenerations_Both && worklist->items >= MVM_GC_STEAL_SHARE_THRESHOLD
+                && MVM_load(&tc->instance->gc_steal_idle)
+                && !MVM_load(&tc->instance->gc_steal_pool_chunks))
+            share_gen2_work(tc, worklist);
+
         /* If it's in the second generation and we're only doing a nursery,
          * collection, we have nothing to do. */
         item_gen2 = item->flags & MVM_CF_SECOND_GEN;
         if (item_gen2) {
-            if (gen == MVMGCGenerations_Nursery)
+            if (gen == MVMGCGenerations_Nursery) {
+                /* If we're in an incremental marking cycle, this may be a
+                 * gen2 object referenced only from a root or the nursery;
+                 * log it to be marked. */
+                if (tc->instance->gc_marking && !(item->flags & MVM_CF_GEN2_LIVE))
+                    MVM_gc_write_barrier_log(tc, item);
                 continue;
+            }
             if (item->flags & MVM_CF_GEN2_LIVE) {
                 /* gen2 and marked as live. */
                 continue;
@@ -207,8 +254,12 @@ static void process_worklist(MVMThreadContext *tc, MVMGCWorklist *worklist, Work
         }
 
         /* If it's owned by a different thread, we need to pass it over to
-         * the owning thread. */
-        if (item->owner != tc->thread_id) {
+         * the owning thread. Gen2 objects are only marked, not moved, so any
+         * thread may mark them; this is what makes it worth stealing gen2
+         * marking work. (Two threads may race to mark the same object, but
+         * the worst that happens is that it is scanned twice. The mark itself
+         * is set atomically, see MVM_gc_set_flags.) */
+        if (!item_gen2 && item->owner != tc->thread_id) {
             GCDEBUG_LOG(tc, MVM_GC_DEBUG_COLLECT, "Thread %d run %d : sending a handle %p to object %p to thread %d\n", item_ptr, item, item->owner);
             pass_work_item(tc, wtp, item_ptr);
             continue;
@@ -228,7 +279,7 @@ static void process_worklist(MVMThreadContext *tc, MVMGCWorklist *worklist, Work
             if (MVM_GC_DEBUG_ENABLED(MVM_GC_DEBUG_COLLECT)) {
                 GCDEBUG_LOG(tc, MVM_GC_DEBUG_COLLECT, "Thread %d run %d : handle %p was already %p\n", item_ptr, new_addr);
             }
-            item->flags |= MVM_CF_GEN2_LIVE;
+            MVM_gc_set_flags(item, MVM_CF_GEN2_LIVE);
             assert(*item_ptr == new_addr);
         } else {
             /* Catch NULL stable (always sign of trouble) in debug mode. */
@@ -242,8 +293,9 @@ static void process_worklist(MVMThreadContext *tc, MVMGCWorklist *worklist, Work
             if (item->flags & (MVM_CF_NURSERY_SEEN | MVM_CF_HAS_OBJECT_ID)) {
                 /* Yes; we should move it to the second generation. Allocate
                  * space in the second generation. */
+                MVMuint16 has_object_id = item->flags & MVM_CF_HAS_OBJECT_ID;
                 to_gen2 = 1;
-                new_addr = item->flags & MVM_CF_HAS_OBJECT_ID
+                new_addr = has_object_id
                     ? MVM_gc_object_id_use_allocation(tc, item)
                     : MVM_gc_gen2_allocate(gen2, item->size);
 
@@ -261,6 +313,11 @@ static void process_worklist(MVMThreadContext *tc, MVMGCWorklist *worklist, Work
                     new_addr->flags ^= MVM_CF_NURSERY_SEEN;
                 new_addr->flags |= MVM_CF_SECOND_GEN;
 
+                /* Its object ID is the address it now lives at, so it must
+                 * never move from there. */
+                if (has_object_id)
+                    new_addr->flags |= MVM_CF_GEN2_PINNED;
+
                 /* If it's a frame with an active work area, we need to keep
                  * on visiting it. Also add on object's unmanaged size. */
                 if (new_addr->flags & MVM_CF_FRAME) {
@@ -275,8 +332,10 @@ static void process_worklist(MVMThreadContext *tc, MVMGCWorklist *worklist, Work
                 }
 
                 /* If we're going to sweep the second generation, also need
-                 * to mark it as live. */
-                if (gen == MVMGCGenerations_Both)
+                 * to mark it as live. The same goes if we're in the midst of
+                 * an incremental marking cycle; in that case, any gen2 objects
+                 * it references will be logged as we process the worklist. */
+                if (gen == MVMGCGenerations_Both || tc->instance->gc_marking)
                     new_addr->flags |= MVM_CF_GEN2_LIVE;
             }
             else {
@@ -514,6 +573,159 @@ static void add_in_tray_to_worklist(MVMThreadContext *tc, MVMGCWorklist *worklis
     }
 }
 
+/* Moves gen2 marking work from the bottom of the worklist (the items that
+ * have been waiting longest) into the shared steal pool, so that threads
+ * which have run out of work of their own can take it. Anything that is not
+ * an unmarked gen2 object stays on our own worklist, since nursery objects
+ * must be handled by their owning thread. */
+static void share_gen2_work(MVMThreadContext *tc, MVMGCWorklist *worklist) {
+    MVMGCPassedWork *shared = NULL, *last = NULL, *chunk = NULL;
+    MVMuint32 to_consider = worklist->items / 2;
+    MVMuint32 kept = 0, num_chunks = 0, k;
+
+    for (k = 0; k < to_consider; k++) {
+        MVMCollectable **item_ptr = worklist->list[k];
+        MVMCollectable  *item     = *item_ptr;
+        if (!item || (item->flags & MVM_CF_GEN2_LIVE)) {
+            /* Nothing to do for this one; just drop it. */
+            continue;
+        }
+        else if (item->flags & MVM_CF_SECOND_GEN) {
+            if (!chunk) {
+                chunk = MVM_calloc(1, sizeof(MVMGCPassedWork));
+                if (last)
+                    last->next = chunk;
+                else
+                    shared = chunk;
+                last = chunk;
+                num_chunks++;
+            }
+            chunk->items[chunk->num_items++] = item_ptr;
+            if (chunk->num_items == MVM_GC_PASS_WORK_SIZE)
+                chunk = NULL;
+        }
+        else {
+            worklist->list[kept++] = item_ptr;
+        }
+    }
+
+    /* Slide down what remains of the worklist over the gap. */
+    memmove(worklist->list + kept, worklist->list + to_consider,
+        (worklist->items - to_consider) * sizeof(MVMCollectable **));
+    worklist->items -= to_consider - kept;
+
+    /* Put the chunks into the steal pool. */
+    if (shared) {
+        GCDEBUG_LOG(tc, MVM_GC_DEBUG_COLLECT, "Thread %d run %d : sharing %d chunks of gen2 work\n", num_chunks);
+        uv_mutex_lock(&tc->instance->mutex_gc_steal_pool);
+        last->next = tc->instance->gc_steal_pool;
+        tc->instance->gc_steal_pool = shared;
+        MVM_add(&tc->instance->gc_steal_pool_chunks, num_chunks);
+        uv_mutex_unlock(&tc->instance->mutex_gc_steal_pool);
+    }
+}
+
+/* Takes a chunk of work from the steal pool, if there is any, and adds it to
+ * the worklist. */
+static void add_stolen_work_to_worklist(MVMThreadContext *tc, MVMGCWorklist *worklist) {
+    MVMGCPassedWork *chunk;
+    MVMuint32 i;
+
+    uv_mutex_lock(&tc->instance->mutex_gc_steal_pool);
+    chunk = tc->instance->gc_steal_pool;
+    if (chunk) {
+        tc->instance->gc_steal_pool = chunk->next;
+        MVM_decr(&tc->instance->gc_steal_pool_chunks);
+    }
+    uv_mutex_unlock(&tc->instance->mutex_gc_steal_pool);
+
+    if (chunk) {
+        for (i = 0; i < chunk->num_items; i++)
+            MVM_gc_worklist_add(tc, worklist, chunk->items[i]);
+        MVM_free(chunk);
+    }
+}
+
+/* Called in the full collection that completes an incremental marking cycle.
+ * Objects marked during the cycle are already flagged as live, so will not be
+ * visited again. Thus we need to mark anything logged since the last slice of
+ * marking work, and also rescan the inter-generational roots. They cover both
+ * the nursery objects referenced by already-marked gen2 objects and the gen2
+ * frames with an active work area, whose registers are written without a
+ * write barrier. */
+static void finish_incremental_marking(MVMThreadContext *tc, MVMGCWorklist *worklist, WorkToPass *wtp) {
+    MVMuint32 i;
+
+    /* Note that the log and the gen2 roots may grow as we go, so we must not
+     * cache the list pointers. */
+    while (tc->num_gc_mark_log) {
+        MVMCollectable *item = tc->gc_mark_log[--tc->num_gc_mark_log];
+        if (!(item->flags & MVM_CF_GEN2_LIVE)) {
+            MVM_gc_set_flags(item, MVM_CF_GEN2_LIVE);
+            MVM_gc_mark_collectable(tc, worklist, item);
+            process_worklist(tc, worklist, wtp, MVMGCGenerations_Both);
+        }
+    }
+    GCDEBUG_LOG(tc, MVM_GC_DEBUG_COLLECT, "Thread %d run %d : processed incremental mark log\n");
+
+    for (i = 0; i < tc->num_gen2roots; i++) {
+        MVM_gc_mark_collectable(tc, worklist, tc->gen2roots[i]);
+        process_worklist(tc, worklist, wtp, MVMGCGenerations_Both);
+    }
+    GCDEBUG_LOG(tc, MVM_GC_DEBUG_COLLECT, "Thread %d run %d : rescanned inter-generational roots\n");
+}
+
+/* Does a slice of incremental gen2 marking. Objects in each thread's mark
+ * log are marked live and scanned, logging any unmarked gen2 objects they
+ * reference in turn, until we have scanned budget objects. Nursery objects
+ * found along the way are ignored, since the nursery is traced again in each
+ * collection. This must only be called by the co-ordinator at a point where
+ * no other thread can be touching the heap, since it sets the mark on objects
+ * that may be owned by any thread. Returns the number of logged objects that
+ * are still waiting to be processed. */
+MVMuint64 MVM_gc_collect_incremental_mark(MVMThreadContext *tc, MVMuint32 budget) {
+    MVMGCWorklist *worklist = MVM_gc_worklist_create(tc, 1);
+    MVMThread     *cur_thread = (MVMThread *)MVM_load(&tc->instance->threads);
+    MVMuint64      pending = 0;
+    while (cur_thread) {
+        MVMThreadContext *other = cur_thread->body.tc;
+        if (other) {
+            while (other->num_gc_mark_log && budget) {
+                MVMCollectable  *item = other->gc_mark_log[--other->num_gc_mark_log];
+                MVMCollectable **child_ptr;
+                if (item->flags & MVM_CF_GEN2_LIVE)
+                    continue;
+                MVM_gc_set_flags(item, MVM_CF_GEN2_LIVE);
+                MVM_gc_mark_collectable(tc, worklist, item);
+                while ((child_ptr = MVM_gc_worklist_get(tc, worklist))) {
+                    MVMCollectable *child = *child_ptr;
+                    if (child && (child->flags & MVM_CF_SECOND_GEN) && !(child->flags & MVM_CF_GEN2_LIVE))
+                        MVM_gc_write_barrier_log(other, child);
+                }
+                budget--;
+            }
+            pending += other->num_gc_mark_log;
+        }
+        cur_thread = cur_thread->body.next;
+    }
+    MVM_gc_worklist_destroy(tc, worklist);
+    return pending;
+}
+
+/* Ends an incremental marking cycle. Called by the co-ordinator once the
+ * final full collection has completed marking, and before any thread goes
+ * back to running code. Anything still in the mark logs was added during the
+ * full collection itself, so it was marked anyway. */
+void MVM_gc_collect_incremental_finish(MVMThreadContext *tc) {
+    MVMThread *cur_thread = (MVMThread *)MVM_load(&tc->instance->threads);
+    while (cur_thread) {
+        if (cur_thread->body.tc)
+            cur_thread->body.tc->num_gc_mark_log = 0;
+        cur_thread = cur_thread->body.next;
+    }
+    tc->instance->gc_marking = 0;
+}
+
 /* Save dead STable pointers to delete later.. */
 static void MVM_gc_collect_enqueue_stable_for_deletion(MVMThreadContext *tc, MVMSTable *st) {
     MVMSTable *old_head;
@@ -592,6 +804,44 @@ void MVM_gc_collect_free_nursery_uncopied(MVMThreadContext *tc, void *limit) {
     }
 }
 
+/* Decides on the size of a thread's nursery after a GC run, given the point
+ * that allocation had reached in fromspace. A thread that filled its nursery
+ * quickly, or that has many of its objects surviving, gets a bigger nursery,
+ * so it will GC less often and give objects longer to die before promotion.
+ * A thread that hardly allocated anything gets a smaller one, so an idle thread
+ * does not hold on to lots of memory. The new size is applied the next time
+ * the semi-spaces are swapped. */
+void MVM_gc_collect_adapt_nursery_size(MVMThreadContext *tc, void *limit) {
+    MVMInstance *i        = tc->instance;
+    MVMuint64    now      = MVM_platform_now();
+    MVMuint64    interval = now - tc->nursery_last_gc;
+    MVMuint64    size     = tc->nursery_fromspace_size;
+    MVMuint64    used     = (char *)limit - (char *)tc->nursery_fromspace;
+    MVMuint64    survived = ((char *)tc->nursery_alloc - (char *)tc->nursery_tospace)
+                          + tc->gc_promoted_bytes;
+    MVMuint64    new_size = tc->nursery_size;
+    tc->nursery_last_gc = now;
+
+    if (100 * used >= MVM_NURSERY_GROW_USED_PERCENT * size) {
+        if (interval < MVM_NURSERY_GROW_INTERVAL ||
+                100 * survived >= MVM_NURSERY_GROW_SURVIVAL_PERCENT * used)
+            new_size *= 2;
+    }
+    else if (100 * used < MVM_NURSERY_SHRINK_USED_PERCENT * size) {
+        new_size /= 2;
+    }
+
+    if (new_size < i->nursery_size_min)
+        new_size = i->nursery_size_min;
+    if (new_size > i->nursery_size_max)
+        new_size = i->nursery_size_max;
+    if (new_size != tc->nursery_size) {
+        GCDEBUG_LOG(tc, MVM_GC_DEBUG_COLLECT, "Thread %d run %d : nursery size changed to %d\n",
+            (int)new_size);
+        tc->nursery_size = (MVMuint32)new_size;
+    }
+}
+
 /* Free STables (in any thread/generation!) queued to be freed. */
 void MVM_gc_collect_free_stables(MVMThreadContext *tc) {
     MVMSTable *st = tc->instance->stables_to_free;
@@ -604,152 +854,269 @@ void MVM_gc_collect_free_stables(MVMThreadContext *tc) {
     tc->instance->stables_to_free = NULL;
 }
 
-/* Goes through the unmarked objects in the second generation heap and builds
- * free lists out of them. Also does any required finalization. */
-void MVM_gc_collect_free_gen2_unmarked(MVMThreadContext *tc, MVMint32 global_destruction) {
-    /* Visit each of the size class bins. */
-    MVMGen2Allocator *gen2 = tc->gen2;
-    MVMuint32 bin, obj_size, page, i;
-    char ***freelist_insert_pos;
-    for (bin = 0; bin < MVM_GEN2_BINS; bin++) {
-        /* If we've nothing allocated in this size class, skip it. */
-        if (gen2->size_classes[bin].pages == NULL)
-            continue;
-
-        /* Calculate object size for this bin. */
-        obj_size = (bin + 1) << MVM_GEN2_BIN_BITS;
-
-        /* freelist_insert_pos is a pointer to a memory location that
-         * stores the address of the last traversed free list node (char **). */
-        /* Initialize freelist insertion position to free list head. */
-        freelist_insert_pos = &gen2->size_classes[bin].free_list;
-
-        /* Visit each page. */
-        for (page = 0; page < gen2->size_classes[bin].num_pages; page++) {
-            /* Visit all the objects, looking for dead ones and reset the
-             * mark for each of them. */
-            char *cur_ptr = gen2->size_classes[bin].pages[page];
-            char *end_ptr = page + 1 == gen2->size_classes[bin].num_pages
-                ? gen2->size_classes[bin].alloc_pos
-                : cur_ptr + obj_size * MVM_GEN2_PAGE_ITEMS;
-            while (cur_ptr < end_ptr) {
-                MVMCollectable *col = (MVMCollectable *)cur_ptr;
-
-                /* Is this already a free list slot? If so, it becomes the
-                 * new free list insert position. */
-                if (*freelist_insert_pos == (char **)cur_ptr) {
-                    freelist_insert_pos = (char ***)cur_ptr;
-                }
-
-                /* Otherwise, it must be a collectable of some kind. Is it
-                 * live? */
-                else if (col->flags & MVM_CF_GEN2_LIVE) {
-                    /* Yes; clear the mark. */
-                    col->flags &= ~MVM_CF_GEN2_LIVE;
-                }
-                else {
-                    GCDEBUG_LOG(tc, MVM_GC_DEBUG_COLLECT, "Thread %d run %d : collecting an object %p in the gen2\n", col);
-                    /* No, it's dead. Do any cleanup. */
-                    if (col->flags & MVM_CF_TYPE_OBJECT) {
+/* Does the cleanup needed for a dead gen2 type object, frame, or object
+ * instance before its memory can be reused. (STables are handled separately,
+ * since they must only be freed in the GC run after they were found dead.) */
+void MVM_gc_collect_free_gen2_dead(MVMThreadContext *tc, MVMCollectable *col) {
+    if (col->flags & MVM_CF_TYPE_OBJECT) {
 #ifdef MVM_USE_OVERFLOW_SERIALIZATION_INDEX
-                        if (col->flags & MVM_CF_SERIALZATION_INDEX_ALLOCATED)
-                            MVM_free(col->sc_forward_u.sci);
+        if (col->flags & MVM_CF_SERIALZATION_INDEX_ALLOCATED)
+            MVM_free(col->sc_forward_u.sci);
 #endif
-                    }
-                    else if (col->flags & MVM_CF_STABLE) {
-                        if (
+    }
+    else if (col->flags & MVM_CF_FRAME) {
+        MVM_frame_destroy(tc, (MVMFrame *)col);
+    }
+    else {
+        /* Object instance; call gc_free if needed. */
+        MVMObject *obj = (MVMObject *)col;
+        if (STABLE(obj) && REPR(obj)->gc_free)
+            REPR(obj)->gc_free(tc, obj);
 #ifdef MVM_USE_OVERFLOW_SERIALIZATION_INDEX
-                            !(col->flags & MVM_CF_SERIALZATION_INDEX_ALLOCATED) &&
+        if (col->flags & MVM_CF_SERIALZATION_INDEX_ALLOCATED)
+            MVM_free(col->sc_forward_u.sci);
 #endif
-                            col->sc_forward_u.sc.sc_idx == 0
-                            && col->sc_forward_u.sc.idx == MVM_DIRECT_SC_IDX_SENTINEL) {
-                            /* We marked it dead last time, kill it. */
-                            MVM_6model_stable_gc_free(tc, (MVMSTable *)col);
-                        }
-                        else {
+    }
+}
+
+/* Goes through the unmarked objects in the first num_pages pages of a gen2
+ * size class, up to alloc_pos in the last of them, and builds free lists out
+ * of them. Also does any required finalization. If the size class has not
+ * needed a new page for long enough, pages that turn out to be entirely free
+ * are given back. */
+static void sweep_gen2_size_class(MVMThreadContext *tc, MVMuint32 bin, MVMuint32 num_pages,
+                                  char *alloc_pos, MVMint32 global_destruction) {
+    MVMGen2SizeClass *szc = &(tc->gen2->size_classes[bin]);
+    MVMuint32 release_idle = tc->instance->gc_page_release_idle;
+    MVMuint32 obj_size, page, released = 0;
+    MVMint32 release;
+    char ***freelist_insert_pos;
+
+    /* Calculate object size for this bin. */
+    obj_size = (bin + 1) << MVM_GEN2_BIN_BITS;
+
+    /* See if we should look out for free pages to release. */
+    szc->idle_sweeps++;
+    release = !global_destruction && release_idle && szc->idle_sweeps >= release_idle;
+
+    /* freelist_insert_pos is a pointer to a memory location that
+     * stores the address of the last traversed free list node (char **). */
+    /* Initialize freelist insertion position to free list head. */
+    freelist_insert_pos = &szc->free_list;
+
+    /* Visit each page. */
+    for (page = 0; page < num_pages; page++) {
+        /* Visit all the objects, looking for dead ones and reset the
+         * mark for each of them. Since the free list is in page order, the
+         * free slots of the page will be a run in it, starting after the
+         * insert position we have at the start of the page. */
+        char *cur_ptr = szc->pages[page];
+        char *end_ptr = page + 1 == num_pages
+            ? alloc_pos
+            : cur_ptr + obj_size * MVM_GEN2_PAGE_ITEMS;
+        char ***page_insert_pos = freelist_insert_pos;
+        MVMuint32 free_slots = 0;
+        while (cur_ptr < end_ptr) {
+            MVMCollectable *col = (MVMCollectable *)cur_ptr;
+
+            /* Is this already a free list slot? If so, it becomes the
+             * new free list insert position. */
+            if (*freelist_insert_pos == (char **)cur_ptr) {
+                freelist_insert_pos = (char ***)cur_ptr;
+                free_slots++;
+            }
+
+            /* Otherwise, it must be a collectable of some kind. Is it
+             * live? */
+            else if (col->flags & MVM_CF_GEN2_LIVE) {
+                /* Yes; clear the mark. */
+                MVM_gc_clear_flags(col, MVM_CF_GEN2_LIVE);
+            }
+            else {
+                GCDEBUG_LOG(tc, MVM_GC_DEBUG_COLLECT, "Thread %d run %d : collecting an object %p in the gen2\n", col);
+                /* No, it's dead. Do any cleanup. */
+                if (col->flags & MVM_CF_STABLE) {
+                    if (
 #ifdef MVM_USE_OVERFLOW_SERIALIZATION_INDEX
-                            if (col->flags & MVM_CF_SERIALZATION_INDEX_ALLOCATED) {
-                                /* Whatever happens next, we can free this
-                                   memory immediately, because no-one will be
-                                   serializing a dead STable. */
-                                assert(!(col->sc_forward_u.sci->sc_idx == 0
-                                         && col->sc_forward_u.sci->idx
-                                         == MVM_DIRECT_SC_IDX_SENTINEL));
-                                MVM_free(col->sc_forward_u.sci);
-                                col->flags &= ~MVM_CF_SERIALZATION_INDEX_ALLOCATED;
-                            }
+                        !(col->flags & MVM_CF_SERIALZATION_INDEX_ALLOCATED) &&
 #endif
-                            if (global_destruction) {
-                                /* We're in global destruction, so enqueue to the end
-                                 * like we do in the nursery */
-                                MVM_gc_collect_enqueue_stable_for_deletion(tc, (MVMSTable *)col);
-                            } else {
-                                /* There will definitely be another gc run, so mark it as "died last time". */
-                                col->sc_forward_u.sc.sc_idx = 0;
-                                col->sc_forward_u.sc.idx = MVM_DIRECT_SC_IDX_SENTINEL;
-                            }
-                            /* Skip the freelist updating. */
-                            cur_ptr += obj_size;
-                            continue;
-                        }
-                    }
-                    else if (col->flags & MVM_CF_FRAME) {
-                        MVM_frame_destroy(tc, (MVMFrame *)col);
+                        col->sc_forward_u.sc.sc_idx == 0
+                        && col->sc_forward_u.sc.idx == MVM_DIRECT_SC_IDX_SENTINEL) {
+                        /* We marked it dead last time, kill it. */
+                        MVM_6model_stable_gc_free(tc, (MVMSTable *)col);
                     }
                     else {
-                        /* Object instance; call gc_free if needed. */
-                        MVMObject *obj = (MVMObject *)col;
-                        if (STABLE(obj) && REPR(obj)->gc_free)
-                            REPR(obj)->gc_free(tc, obj);
 #ifdef MVM_USE_OVERFLOW_SERIALIZATION_INDEX
-                        if (col->flags & MVM_CF_SERIALZATION_INDEX_ALLOCATED)
+                        if (col->flags & MVM_CF_SERIALZATION_INDEX_ALLOCATED) {
+                            /* Whatever happens next, we can free this
+                               memory immediately, because no-one will be
+                               serializing a dead STable. */
+                            assert(!(col->sc_forward_u.sci->sc_idx == 0
+                                     && col->sc_forward_u.sci->idx
+                                     == MVM_DIRECT_SC_IDX_SENTINEL));
                             MVM_free(col->sc_forward_u.sci);
+                            col->flags &= ~MVM_CF_SERIALZATION_INDEX_ALLOCATED;
+                        }
 #endif
+                        if (global_destruction) {
+                            /* We're in global destruction, so enqueue to the end
+                             * like we do in the nursery */
+                            MVM_gc_collect_enqueue_stable_for_deletion(tc, (MVMSTable *)col);
+                        } else {
+                            /* There will definitely be another gc run, so mark it as "died last time". */
+                            col->sc_forward_u.sc.sc_idx = 0;
+                            col->sc_forward_u.sc.idx = MVM_DIRECT_SC_IDX_SENTINEL;
+                        }
+                        /* Skip the freelist updating. */
+                        cur_ptr += obj_size;
+                        continue;
                     }
-
-                    /* Chain in to the free list. */
-                    *((char **)cur_ptr) = (char *)*freelist_insert_pos;
-                    *freelist_insert_pos = (char **)cur_ptr;
-
-                    /* Update the pointer to the insert position to point to us */
-                    freelist_insert_pos = (char ***)cur_ptr;
                 }
+                else {
+                    MVM_gc_collect_free_gen2_dead(tc, col);
+                }
+
+                /* Chain in to the free list. */
+                *((char **)cur_ptr) = (char *)*freelist_insert_pos;
+                *freelist_insert_pos = (char **)cur_ptr;
 
-                /* Move to the next object. */
-                cur_ptr += obj_size;
+                /* Update the pointer to the insert position to point to us */
+                freelist_insert_pos = (char ***)cur_ptr;
+                free_slots++;
             }
+
+            /* Move to the next object. */
+            cur_ptr += obj_size;
+        }
+
+        /* If the page is entirely free, and it's not the one we may still
+         * be allocating from, unlink its slots from the free list and free
+         * it. */
+        if (release && free_slots == MVM_GEN2_PAGE_ITEMS && page + 1 < szc->num_pages) {
+            *page_insert_pos = *freelist_insert_pos;
+            freelist_insert_pos = page_insert_pos;
+            MVM_free(szc->pages[page]);
+            szc->pages[page] = NULL;
+            released++;
         }
     }
-    
-    /* Also need to consider overflows. */
-    for (i = 0; i < gen2->num_overflows; i++) {
-        if (gen2->overflows[i]) {
-            MVMCollectable *col = gen2->overflows[i];
-            if (col->flags & MVM_CF_GEN2_LIVE) {
-                /* A living over-sized object; just clear the mark. */
-                col->flags &= ~MVM_CF_GEN2_LIVE;
-            }
-            else {
-                /* Dead over-sized object. We know if it's this big it cannot
-                 * be a type object or STable, so only need handle the simple
-                 * object case. */
-                if (!(col->flags & (MVM_CF_TYPE_OBJECT | MVM_CF_STABLE | MVM_CF_FRAME))) {
-                    MVMObject *obj = (MVMObject *)col;
-                    if (REPR(obj)->gc_free)
-                        REPR(obj)->gc_free(tc, obj);
-#ifdef MVM_USE_OVERFLOW_SERIALIZATION_INDEX
-                    if (col->flags & MVM_CF_SERIALZATION_INDEX_ALLOCATED)
-                        MVM_free(col->sc_forward_u.sci);
-#endif
-                }
-                else {
-                    MVM_panic(MVM_exitcode_gcnursery, "Internal error: gen2 overflow contains non-object");
-                }
-                MVM_free(col);
-                gen2->overflows[i] = NULL;
-            }
+
+    /* Close up any gaps left in the pages array by released pages. */
+    if (released) {
+        MVMuint32 kept = 0;
+        for (page = 0; page < szc->num_pages; page++)
+            if (szc->pages[page])
+                szc->pages[kept++] = szc->pages[page];
+        szc->num_pages = kept;
+        szc->cur_page  = kept - 1;
+        MVM_add(&tc->instance->gc_gen2_pages_released, released);
+        MVM_add(&tc->instance->gc_gen2_bytes_released, released * obj_size * MVM_GEN2_PAGE_ITEMS);
+        GCDEBUG_LOG(tc, MVM_GC_DEBUG_COLLECT, "Thread %d run %d : released %d free pages of gen2 bin %d\n",
+            released, bin);
+    }
+}
+
+/* Goes through the objects in the large object space of the second generation
+ * and frees the unmarked ones. */
+static void sweep_gen2_large_objects(MVMThreadContext *tc) {
+    MVMGen2Allocator *gen2 = tc->gen2;
+    MVMLargeObject   *lo   = gen2->large_objects;
+    while (lo) {
+        MVMLargeObject *next = lo->next;
+        MVMCollectable *col  = MVM_GC_LOS_OBJECT(lo);
+        if (col->flags & MVM_CF_GEN2_LIVE) {
+            /* A living large object; just clear the mark. */
+            MVM_gc_clear_flags(col, MVM_CF_GEN2_LIVE);
+        }
+        else {
+            /* Dead large object. We know if it's this big it cannot be a
+             * type object or STable, so only need handle the simple object
+             * case. */
+            if (col->flags & (MVM_CF_TYPE_OBJECT | MVM_CF_STABLE | MVM_CF_FRAME))
+                MVM_panic(MVM_exitcode_gcnursery, "Internal error: gen2 large object space contains non-object");
+            MVM_gc_collect_free_gen2_dead(tc, col);
+            MVM_gc_los_free(gen2, col);
+        }
+        lo = next;
+    }
+}
+
+/* Goes through the unmarked objects in the second generation heap and builds
+ * free lists out of them. Also does any required finalization. Any sweeping
+ * left pending by an earlier full collection must have been done first. */
+void MVM_gc_collect_free_gen2_unmarked(MVMThreadContext *tc, MVMint32 global_destruction) {
+    MVMGen2Allocator *gen2 = tc->gen2;
+    MVMuint32 bin;
+    for (bin = 0; bin < MVM_GEN2_BINS; bin++) {
+        /* If we've nothing allocated in this size class, skip it. */
+        if (gen2->size_classes[bin].pages == NULL)
+            continue;
+        sweep_gen2_size_class(tc, bin, gen2->size_classes[bin].num_pages,
+            gen2->size_classes[bin].alloc_pos, global_destruction);
+    }
+    sweep_gen2_large_objects(tc);
+}
+
+/* Called at the end of a full collection in place of sweeping the whole of
+ * the second generation. The large objects are swept right away, but for
+ * each size class we just note how far it extended at the point it was marked,
+ * and leave the sweeping to later GC runs. Until a size class is swept, its
+ * free list is not used, and anything allocated in it goes past the noted
+ * extent, so will not be swept. */
+void MVM_gc_collect_defer_gen2_sweep(MVMThreadContext *tc) {
+    MVMGen2Allocator *gen2 = tc->gen2;
+    MVMuint32 bin;
+    for (bin = 0; bin < MVM_GEN2_BINS; bin++) {
+        MVMGen2SizeClass *szc = &(gen2->size_classes[bin]);
+        if (szc->pages == NULL)
+            continue;
+        szc->sweep_num_pages = szc->num_pages;
+        szc->sweep_alloc_pos = szc->alloc_pos;
+        gen2->num_sweep_pending++;
+    }
+    gen2->sweep_wanted = 0;
+    sweep_gen2_large_objects(tc);
+}
+
+/* Sweeps one size class whose sweeping was deferred, returning the number of
+ * pages that it covered. */
+static MVMuint32 sweep_pending_size_class(MVMThreadContext *tc, MVMuint32 bin) {
+    MVMGen2Allocator *gen2     = tc->gen2;
+    MVMGen2SizeClass *szc      = &(gen2->size_classes[bin]);
+    MVMuint32         num_pages = szc->sweep_num_pages;
+    GCDEBUG_LOG(tc, MVM_GC_DEBUG_COLLECT, "Thread %d run %d : lazily sweeping gen2 bin %d\n", bin);
+    sweep_gen2_size_class(tc, bin, num_pages, szc->sweep_alloc_pos, 0);
+    szc->sweep_num_pages = 0;
+    szc->sweep_alloc_pos = NULL;
+    gen2->sweep_wanted  &= ~((MVMuint64)1 << bin);
+    gen2->num_sweep_pending--;
+    return num_pages;
+}
+
+/* Does some of the second generation sweeping that was deferred by the last
+ * full collection. Size classes that have been allocated from since then are
+ * swept first, since they are the ones that are in need of free slots. We go
+ * on until we have swept at least page_budget pages; a budget of zero means
+ * to finish all of the pending sweeping. Must only be called during a GC run,
+ * since it touches the flags of objects other threads may refer to. */
+void MVM_gc_collect_sweep_gen2_pending(MVMThreadContext *tc, MVMuint32 page_budget) {
+    MVMGen2Allocator *gen2  = tc->gen2;
+    MVMuint32         swept = 0;
+    MVMuint32         bin;
+    if (!gen2->num_sweep_pending)
+        return;
+    for (bin = 0; bin < MVM_GEN2_BINS && gen2->sweep_wanted; bin++) {
+        if (gen2->sweep_wanted & ((MVMuint64)1 << bin)) {
+            swept += sweep_pending_size_class(tc, bin);
+            if (page_budget && swept >= page_budget)
+                return;
+        }
+    }
+    for (bin = 0; bin < MVM_GEN2_BINS && gen2->num_sweep_pending; bin++) {
+        if (gen2->size_classes[bin].sweep_num_pages) {
+            swept += sweep_pending_size_class(tc, bin);
+            if (page_budget && swept >= page_budget)
+                return;
         }
     }
-    /* And finally compact the overflow list */
-    MVM_gc_gen2_compact_overflows(gen2);
 }
@@ -1,7 +1,28 @@
 /* How big is the nursery area? Note that since it's semi-space copying, we
- * actually have double this amount allocated. Also it is per thread. (In
- * the future, we'll make this adaptive rather than a constant.) */
-#define MVM_NURSERY_SIZE 4194304
+ * actually have double this amount allocated. Also it is per thread. This is
+ * the size a thread starts out with; after each GC run, it is adapted to how
+ * heavily the thread allocates, within the minimum and maximum sizes (which
+ * can be changed with MVM_GC_NURSERY_MIN and MVM_GC_NURSERY_MAX). */
+#define MVM_NURSERY_SIZE        4194304
+#define MVM_NURSERY_SIZE_MIN    262144
+#define MVM_NURSERY_SIZE_MAX    67108864
+
+/* The smallest the minimum nursery size may be set to, which has to leave
+ * room for the biggest object that can be allocated in the nursery. */
+#define MVM_NURSERY_SIZE_LOWEST 65536
+
+/* The largest the maximum nursery size may be set to. Sizes are kept in an
+ * MVMuint32, and this leaves room to double one without overflowing. */
+#define MVM_NURSERY_SIZE_HIGHEST 1073741824
+
+/* If a thread filled at least this percentage of its nursery since the last
+ * GC run, and did so within the grow interval (in nanoseconds) or saw at least
+ * the survival percentage of what it allocated survive, its nursery is doubled.
+ * If it used less than the shrink percentage, its nursery is halved. */
+#define MVM_NURSERY_GROW_USED_PERCENT       75
+#define MVM_NURSERY_GROW_INTERVAL           10000000
+#define MVM_NURSERY_GROW_SURVIVAL_PERCENT   30
+#define MVM_NURSERY_SHRINK_USED_PERCENT     25
 
 /* How many bytes should have been promoted into gen2 before we decide to
  * do a full GC run? This defaults to a percentage of the resident set, with
@@ -9,6 +30,22 @@
 #define MVM_GC_GEN2_THRESHOLD_PERCENT   20
 #define MVM_GC_GEN2_THRESHOLD_MINIMUM   (20 * 1024 * 1024)
 
+/* When marking gen2 incrementally, the number of objects to scan in the slice
+ * of marking work done during each nursery collection, and the maximum number
+ * of nursery collections a marking cycle may span before we force the final
+ * full collection. */
+#define MVM_GC_INCREMENTAL_SLICE        16384
+#define MVM_GC_INCREMENTAL_MAX_RUNS     64
+
+/* The number of gen2 pages each thread sweeps in a nursery collection, while
+ * there is still sweeping left over from the last full collection. */
+#define MVM_GC_SWEEP_PAGE_BUDGET        128
+
+/* The default number of full collections that a gen2 or fixed size allocator
+ * size class must go without needing a new page before we give back pages of
+ * it that are entirely free. */
+#define MVM_GC_PAGE_RELEASE_IDLE        4
+
 /* What things should be processed in this GC run? */
 typedef enum {
     /* Everything, including the instance-wide roots. If we have many
@@ -22,7 +59,10 @@ typedef enum {
     MVMGCWhatToDo_InTray = 2,
 
     /* Only process the finalizing list. */
-    MVMGCWhatToDo_Finalizing = 4
+    MVMGCWhatToDo_Finalizing = 4,
+
+    /* Only process gen2 marking work taken from the shared steal pool. */
+    MVMGCWhatToDo_Stolen = 8
 } MVMGCWhatToDo;
 
 /* What generation(s) to collect? */
@@ -38,6 +78,11 @@ typedef enum {
  * off to the next thread. (Power of 2, minus 2, is a decent choice.) */
 #define MVM_GC_PASS_WORK_SIZE   62
 
+/* During a full collection, once a thread's worklist grows to this many
+ * items and another thread is idle, it shares some of its gen2 marking work
+ * via the instance-wide steal pool. */
+#define MVM_GC_STEAL_SHARE_THRESHOLD    1024
+
 /* Represents a piece of work (some addresses to visit) that have been passed
  * from one thread doing GC to another thread doing GC. */
 struct MVMGCPassedWork {
@@ -46,9 +91,33 @@ struct MVMGCPassedWork {
     MVMint32         num_items;
 };
 
+/* Set and clear flags on a gen2 object. During a collection, several threads
+ * may update different flags of the same gen2 object at once: one marking it
+ * live, another taking it off its inter-generational root list, and the owner
+ * clearing the mark as it sweeps. So these must be atomic, lest an update to
+ * one flag be lost to an update of another. */
+MVM_STATIC_INLINE void MVM_gc_set_flags(MVMCollectable *col, MVMuint16 set) {
+    unsigned short old;
+    do {
+        old = AO_short_load(&(col->flags));
+    } while (AO_short_fetch_compare_and_swap_full(&(col->flags), old, old | set) != old);
+}
+MVM_STATIC_INLINE void MVM_gc_clear_flags(MVMCollectable *col, MVMuint16 clear) {
+    unsigned short old;
+    do {
+        old = AO_short_load(&(col->flags));
+    } while (AO_short_fetch_compare_and_swap_full(&(col->flags), old, old & ~clear) != old);
+}
+
 /* Functions. */
 void MVM_gc_collect(MVMThreadContext *tc, MVMuint8 what_to_do, MVMuint8 gen);
 void MVM_gc_collect_free_nursery_uncopied(MVMThreadContext *tc, void *limit);
+void MVM_gc_collect_adapt_nursery_size(MVMThreadContext *tc, void *limit);
+void MVM_gc_collect_free_gen2_dead(MVMThreadContext *tc, MVMCollectable *col);
 void MVM_gc_collect_free_gen2_unmarked(MVMThreadContext *tc, MVMint32 global_destruction);
+void MVM_gc_collect_defer_gen2_sweep(MVMThreadContext *tc);
+void MVM_gc_collect_sweep_gen2_pending(MVMThreadContext *tc, MVMuint32 page_budget);
 void MVM_gc_mark_collectable(MVMThreadContext *tc, MVMGCWorklist *worklist, MVMCollectable *item);
 void MVM_gc_collect_free_stables(MVMThreadContext *tc);
+MVMuint64 MVM_gc_collect_incremental_mark(MVMThreadContext *tc, MVMuint32 budget);
+void MVM_gc_collect_incremental_finish(MVMThreadContext *tc);
@@ -0,0 +1,361 @@
+#include "moar.h"
+
+/* Compaction of the second generation. Objects in gen2 normally never move,
+ * and the pages of its size classes are kept forever, so after a spike in
+ * memory use we may be left with many pages that hold just a few live objects
+ * each. When compaction is enabled, then at the end of a full collection we
+ * look for such sparsely populated pages, evacuate the live objects in them
+ * into free slots elsewhere in the same size class, update all references to
+ * the moved objects, and then free the pages.
+ *
+ * This is done by the co-ordinator alone, while all other threads are waiting
+ * for it, and before the sweep of gen2 is set up. At that point, every live
+ * gen2 object has the GEN2_LIVE flag, and everything else in the pages is
+ * either on a free list or dead. Pages holding anything that must not move
+ * are left alone; see page_evacuable. */
+
+/* The pages of a size class, per thread, that we plan to evacuate. */
+typedef struct {
+    /* For each page, whether it will be evacuated. NULL if none will be. */
+    MVMuint8  *evacuate;
+
+    /* The number of pages we planned for (those added later, as objects are
+     * evacuated, are never evacuated themselves). */
+    MVMuint32  num_pages;
+} SizeClassPlan;
+
+typedef struct {
+    MVMThreadContext *tc;
+    SizeClassPlan     bins[MVM_GEN2_BINS];
+} ThreadPlan;
+
+/* Works out the object size for a bin. */
+#define bin_obj_size(bin) (((bin) + 1) << MVM_GEN2_BIN_BITS)
+
+/* Clears the flags of every slot on the free list of a size class, so that
+ * we can tell free slots apart from dead objects as we walk the pages (every
+ * gen2 allocation has the SECOND_GEN flag set). The free list pointer is at
+ * the start of the slot, so doesn't overlap the flags; this is why the first
+ * bin, whose slots are smaller than a collectable header, is skipped. */
+static void clear_free_slot_flags(MVMGen2SizeClass *szc) {
+    char **free_slot = szc->free_list;
+    while (free_slot) {
+        ((MVMCollectable *)free_slot)->flags = 0;
+        free_slot = (char **)*free_slot;
+    }
+}
+
+/* Looks through a full page, counting the live objects in it. Returns zero
+ * if the page cannot be evacuated, because it holds something that must stay
+ * where it is: pinned objects (including space reserved for an object ID),
+ * and STables, type objects and frames, which C code widely assumes to stay
+ * put. Dead STables also keep their page, since they are only freed in the
+ * GC run after they were found dead. */
+static MVMint32 page_evacuable(char *page, MVMuint32 obj_size, MVMuint32 *live) {
+    char *cur_ptr = page;
+    char *end_ptr = page + obj_size * MVM_GEN2_PAGE_ITEMS;
+    *live = 0;
+    while (cur_ptr < end_ptr) {
+        MVMCollectable *col = (MVMCollectable *)cur_ptr;
+        if (col->flags & MVM_CF_SECOND_GEN) {
+            if (col->flags & (MVM_CF_GEN2_PINNED | MVM_CF_STABLE))
+                return 0;
+            if (col->flags & MVM_CF_GEN2_LIVE) {
+                if (col->flags & (MVM_CF_TYPE_OBJECT | MVM_CF_FRAME))
+                    return 0;
+                (*live)++;
+            }
+        }
+        cur_ptr += obj_size;
+    }
+    return 1;
+}
+
+/* Decides which pages of a size class to evacuate, returning how many. The
+ * last page is never evacuated, since it is the one being allocated from. */
+static MVMuint32 plan_size_class(MVMThreadContext *tc, MVMGen2SizeClass *szc, MVMuint32 bin,
+                                 SizeClassPlan *plan) {
+    MVMuint32 obj_size = bin_obj_size(bin);
+    MVMuint32 chosen   = 0;
+    MVMuint32 page, live;
+    plan->num_pages = szc->num_pages;
+    plan->evacuate  = NULL;
+    for (page = 0; page + 1 < szc->num_pages; page++) {
+        if (page_evacuable(szc->pages[page], obj_size, &live) &&
+                100 * live < MVM_GC_COMPACT_LIVE_PERCENT * MVM_GEN2_PAGE_ITEMS) {
+            if (!plan->evacuate)
+                plan->evacuate = MVM_calloc(szc->num_pages, sizeof(MVMuint8));
+            plan->evacuate[page] = 1;
+            chosen++;
+        }
+    }
+    return chosen;
+}
+
+/* Rebuilds the free list of a size class from the free slots in the pages we
+ * are keeping, so that evacuated objects are never moved into a page that is
+ * about to be freed. As with sweeping, the free list is built in page order. */
+static void rebuild_free_list(MVMGen2SizeClass *szc, MVMuint32 bin, SizeClassPlan *plan) {
+    MVMuint32 obj_size = bin_obj_size(bin);
+    char ***freelist_insert_pos = &szc->free_list;
+    MVMuint32 page;
+    for (page = 0; page < szc->num_pages; page++) {
+        char *cur_ptr, *end_ptr;
+        if (plan->evacuate[page])
+            continue;
+        cur_ptr = szc->pages[page];
+        end_ptr = page + 1 == szc->num_pages
+            ? szc->alloc_pos
+            : cur_ptr + obj_size * MVM_GEN2_PAGE_ITEMS;
+        while (cur_ptr < end_ptr) {
+            if (!(((MVMCollectable *)cur_ptr)->flags & MVM_CF_SECOND_GEN)) {
+                *freelist_insert_pos = (char **)cur_ptr;
+                freelist_insert_pos = (char ***)cur_ptr;
+            }
+            cur_ptr += obj_size;
+        }
+    }
+    *freelist_insert_pos = NULL;
+}
+
+/* Moves the live objects out of the pages of a size class that are to be
+ * evacuated, leaving a forwarding pointer behind, and cleans up the dead
+ * ones. Returns the number of objects moved. */
+static MVMuint32 evacuate_size_class(MVMThreadContext *tc, MVMGen2Allocator *gen2, MVMuint32 bin,
+                                     SizeClassPlan *plan) {
+    MVMGen2SizeClass *szc = &(gen2->size_classes[bin]);
+    MVMuint32 obj_size = bin_obj_size(bin);
+    MVMuint32 moved    = 0;
+    MVMuint32 page;
+    for (page = 0; page < plan->num_pages; page++) {
+        char *cur_ptr, *end_ptr;
+        if (!plan->evacuate[page])
+            continue;
+        cur_ptr = szc->pages[page];
+        end_ptr = cur_ptr + obj_size * MVM_GEN2_PAGE_ITEMS;
+        while (cur_ptr < end_ptr) {
+            MVMCollectable *col = (MVMCollectable *)cur_ptr;
+            if (col->flags & MVM_CF_GEN2_LIVE) {
+                /* Live; copy it, keeping the live mark so the sweep that
+                 * follows keeps it too. */
+                MVMCollectable *new_addr = MVM_gc_gen2_allocate(gen2, obj_size);
+                memcpy(new_addr, col, col->size);
+                col->sc_forward_u.forwarder = new_addr;
+                col->flags |= MVM_CF_FORWARDER_VALID;
+                moved++;
+            }
+            else if (col->flags & MVM_CF_SECOND_GEN) {
+                /* Dead; the page will not be swept, so clean up now. */
+                GCDEBUG_LOG(tc, MVM_GC_DEBUG_COLLECT, "Thread %d run %d : collecting an object %p in an evacuated gen2 page\n", col);
+                MVM_gc_collect_free_gen2_dead(tc, col);
+            }
+            cur_ptr += obj_size;
+        }
+    }
+    return moved;
+}
+
+/* Frees the evacuated pages of a size class, and closes up the gaps they
+ * leave in its pages array. The allocation page stays the last one. */
+static MVMuint32 free_evacuated_pages(MVMThreadContext *tc, MVMGen2SizeClass *szc, MVMuint32 bin,
+                                      SizeClassPlan *plan) {
+    MVMuint32 kept = 0, freed = 0;
+    MVMuint32 page;
+    for (page = 0; page < szc->num_pages; page++) {
+        if (page < plan->num_pages && plan->evacuate[page]) {
+            MVM_free(szc->pages[page]);
+            freed++;
+        }
+        else {
+            szc->pages[kept++] = szc->pages[page];
+        }
+    }
+    szc->num_pages = kept;
+    szc->cur_page  = kept - 1;
+    MVM_add(&tc->instance->gc_gen2_pages_released, freed);
+    MVM_add(&tc->instance->gc_gen2_bytes_released, freed * bin_obj_size(bin) * MVM_GEN2_PAGE_ITEMS);
+    return freed;
+}
+
+/* Updates any of the pointers on the worklist that point to an object that
+ * has been moved. */
+static void update_references(MVMThreadContext *tc, MVMGCWorklist *worklist) {
+    MVMCollectable **item_ptr;
+    while ((item_ptr = MVM_gc_worklist_get(tc, worklist))) {
+        MVMCollectable *item = *item_ptr;
+        if ((item->flags & MVM_CF_SECOND_GEN) && (item->flags & MVM_CF_FORWARDER_VALID))
+            *item_ptr = item->sc_forward_u.forwarder;
+    }
+}
+
+/* Visits the references held by each live object in a thread's second
+ * generation, updating those to moved objects. Old copies of the moved
+ * objects have the forwarder flag, and so are skipped. */
+static void update_gen2_references(MVMThreadContext *tc, MVMThreadContext *owner,
+                                   MVMGCWorklist *worklist) {
+    MVMGen2Allocator *gen2 = owner->gen2;
+    MVMLargeObject   *lo;
+    MVMuint32 bin, page;
+    for (bin = 0; bin < MVM_GEN2_BINS; bin++) {
+        MVMGen2SizeClass *szc = &(gen2->size_classes[bin]);
+        MVMuint32 obj_size = bin_obj_size(bin);
+        for (page = 0; page < szc->num_pages; page++) {
+            char *cur_ptr = szc->pages[page];
+            char *end_ptr = page + 1 == szc->num_pages
+                ? szc->alloc_pos
+                : cur_ptr + obj_size * MVM_GEN2_PAGE_ITEMS;
+            while (cur_ptr < end_ptr) {
+                MVMCollectable *col = (MVMCollectable *)cur_ptr;
+                if ((col->flags & MVM_CF_GEN2_LIVE) && !(col->flags & MVM_CF_FORWARDER_VALID)) {
+                    MVM_gc_mark_collectable(tc, worklist, col);
+                    update_references(tc, worklist);
+                }
+                cur_ptr += obj_size;
+            }
+        }
+    }
+    for (lo = gen2->large_objects; lo; lo = lo->next) {
+        MVMCollectable *col = MVM_GC_LOS_OBJECT(lo);
+        if (col->flags & MVM_CF_GEN2_LIVE) {
+            MVM_gc_mark_collectable(tc, worklist, col);
+            update_references(tc, worklist);
+        }
+    }
+}
+
+/* Visits the references held by a thread itself and by the objects in its
+ * nursery, updating those to moved objects. */
+static void update_thread_references(MVMThreadContext *tc, MVMThreadContext *other,
+                                     MVMGCWorklist *worklist) {
+    char *scan = other->nursery_tospace;
+    MVMuint32 i;
+
+    MVM_gc_root_add_tc_roots_to_worklist(other, worklist, NULL);
+    MVM_gc_root_add_temps_to_worklist(other, worklist, NULL);
+    update_references(tc, worklist);
+
+    if (other->cur_frame && MVM_FRAME_IS_ON_CALLSTACK(other, other->cur_frame)) {
+        MVMFrame *cur_frame = other->cur_frame;
+        while (cur_frame && MVM_FRAME_IS_ON_CALLSTACK(other, cur_frame)) {
+            MVM_gc_root_add_frame_roots_to_worklist(other, worklist, cur_frame);
+            update_references(tc, worklist);
+            cur_frame = cur_frame->caller;
+        }
+    }
+    else {
+        MVM_gc_worklist_add(tc, worklist, &other->cur_frame);
+    }
+
+    for (i = 0; i < other->num_gen2roots; i++)
+        MVM_gc_worklist_add(tc, worklist, &(other->gen2roots[i]));
+    for (i = 0; i < other->num_finalize; i++)
+        MVM_gc_worklist_add(tc, worklist, &(other->finalize[i]));
+    for (i = 0; i < other->num_finalizing; i++)
+        MVM_gc_worklist_add(tc, worklist, &(other->finalizing[i]));
+    update_references(tc, worklist);
+
+    while (scan < (char *)other->nursery_alloc) {
+        MVMCollectable *col = (MVMCollectable *)scan;
+        MVM_gc_mark_collectable(tc, worklist, col);
+        update_references(tc, worklist);
+        scan += col->size;
+    }
+}
+
+/* The serialization context bodies point back to their SC objects without
+ * that counting as a reference for the GC, so update those separately. */
+static void update_sc_references(MVMThreadContext *tc, MVMGCWorklist *worklist) {
+    MVMSerializationContextBody *current, *tmp;
+    unsigned bucket_tmp;
+    MVMuint32 i;
+    for (i = 1; i < tc->instance->all_scs_next_idx; i++)
+        if (tc->instance->all_scs[i])
+            MVM_gc_worklist_add(tc, worklist, &(tc->instance->all_scs[i]->sc));
+    HASH_ITER(hash_handle, tc->instance->sc_weakhash, current, tmp, bucket_tmp) {
+        MVM_gc_worklist_add(tc, worklist, &(current->sc));
+    }
+    update_references(tc, worklist);
+}
+
+/* Looks at how fragmented the second generation is after a full collection
+ * and, if there are enough sparsely populated pages, compacts it. Must only
+ * be called by the co-ordinator, while all other threads are stopped. */
+void MVM_gc_compact_gen2(MVMThreadContext *tc) {
+    MVMThread     *cur_thread;
+    ThreadPlan    *plans;
+    MVMGCWorklist *worklist;
+    MVMuint32      num_threads = 0, total_pages = 0, total_moved = 0, total_freed = 0;
+    MVMuint32      t, bin;
+
+    /* Plan which pages of which size classes to evacuate. */
+    cur_thread = (MVMThread *)MVM_load(&tc->instance->threads);
+    while (cur_thread) {
+        if (cur_thread->body.tc)
+            num_threads++;
+        cur_thread = cur_thread->body.next;
+    }
+    plans = MVM_calloc(num_threads, sizeof(ThreadPlan));
+    cur_thread = (MVMThread *)MVM_load(&tc->instance->threads);
+    t = 0;
+    while (cur_thread && t < num_threads) {
+        MVMThreadContext *other = cur_thread->body.tc;
+        if (other) {
+            plans[t].tc = other;
+            for (bin = 1; bin < MVM_GEN2_BINS; bin++) {
+                MVMGen2SizeClass *szc = &(other->gen2->size_classes[bin]);
+                if (szc->pages == NULL)
+                    continue;
+                clear_free_slot_flags(szc);
+                total_pages += plan_size_class(tc, szc, bin, &(plans[t].bins[bin]));
+            }
+            t++;
+        }
+        cur_thread = cur_thread->body.next;
+    }
+
+    /* Only go ahead if it's worth it, since updating the references means
+     * visiting every live object in the heap. */
+    GCDEBUG_LOG(tc, MVM_GC_DEBUG_COLLECT, "Thread %d run %d : %d gen2 pages could be evacuated\n",
+        total_pages);
+    if (total_pages >= MVM_GC_COMPACT_MIN_PAGES) {
+        /* Evacuate the pages. */
+        for (t = 0; t < num_threads; t++) {
+            MVMGen2Allocator *gen2 = plans[t].tc->gen2;
+            for (bin = 1; bin < MVM_GEN2_BINS; bin++) {
+                SizeClassPlan *plan = &(plans[t].bins[bin]);
+                if (plan->evacuate) {
+                    rebuild_free_list(&(gen2->size_classes[bin]), bin, plan);
+                    total_moved += evacuate_size_class(tc, gen2, bin, plan);
+                }
+            }
+        }
+
+        /* Update references to everything that moved. */
+        worklist = MVM_gc_worklist_create(tc, 1);
+        MVM_gc_root_add_permanents_to_worklist(tc, worklist, NULL);
+        MVM_gc_root_add_instance_roots_to_worklist(tc, worklist, NULL);
+        update_references(tc, worklist);
+        update_sc_references(tc, worklist);
+        for (t = 0; t < num_threads; t++) {
+            update_thread_references(tc, plans[t].tc, worklist);
+            update_gen2_references(tc, plans[t].tc, worklist);
+        }
+        MVM_gc_worklist_destroy(tc, worklist);
+
+        /* Now nothing refers to the evacuated pages, free them. */
+        for (t = 0; t < num_threads; t++) {
+            MVMGen2Allocator *gen2 = plans[t].tc->gen2;
+            for (bin = 1; bin < MVM_GEN2_BINS; bin++)
+                if (plans[t].bins[bin].evacuate)
+                    total_freed += free_evacuated_pages(tc, &(gen2->size_classes[bin]),
+                        bin, &(plans[t].bins[bin]));
+        }
+        GCDEBUG_LOG(tc, MVM_GC_DEBUG_COLLECT, "Thread %d run %d : compacted gen2, moving %d objects and freeing %d pages\n",
+            total_moved, total_freed);
+    }
+
+    for (t = 0; t < num_threads; t++)
+        for (bin = 1; bin < MVM_GEN2_BINS; bin++)
+            MVM_free(plans[t].bins[bin].evacuate);
+    MVM_free(plans);
+}
@@ -0,0 +1,10 @@
+/* When compacting the second generation, pages with fewer than this
+ * percentage of their slots holding live objects are evacuated. */
+#define MVM_GC_COMPACT_LIVE_PERCENT     25
+
+/* Compaction only goes ahead if at least this many pages, over all threads,
+ * could be evacuated; otherwise it's not worth visiting the whole heap to
+ * update references. */
+#define MVM_GC_COMPACT_MIN_PAGES        16
+
+void MVM_gc_compact_gen2(MVMThreadContext *tc);
@@ -2,17 +2,13 @@
 
 /* Creates a new second generation allocator. */
 MVMGen2Allocator * MVM_gc_gen2_create(MVMInstance *i) {
-    /* Create allocator data structure. */
-    MVMGen2Allocator *al = MVM_malloc(sizeof(MVMGen2Allocator));
+    /* Create allocator data structure; the large object list starts out
+     * empty. */
+    MVMGen2Allocator *al = MVM_calloc(1, sizeof(MVMGen2Allocator));
 
     /* Create empty size classes array data structure. */
     al->size_classes = (MVMGen2SizeClass *)MVM_calloc(MVM_GEN2_BINS, sizeof(MVMGen2SizeClass));
 
-    /* Set up overflows area. */
-    al->alloc_overflows = MVM_GEN2_OVERFLOWS;
-    al->num_overflows = 0;
-    al->overflows = MVM_malloc(al->alloc_overflows * sizeof(MVMCollectable *));
-
     return al;
 }
 
@@ -32,6 +28,7 @@ static void setup_bin(MVMGen2Allocator *al, MVMuint32 bin) {
 
     /* Free list is empty until GC run (and we just do page by page allocation). */
     al->size_classes[bin].free_list = NULL;
+    al->size_classes[bin].idle_sweeps = 0;
 }
 
 /* Adds a new page to a size class bin. */
@@ -52,6 +49,9 @@ static void add_page(MVMGen2Allocator *al, MVMuint32 bin) {
 
     /* set the cur_page to a proper value */
     al->size_classes[bin].cur_page = cur_page;
+
+    /* The size class is in demand, so it's not the time to free pages. */
+    al->size_classes[bin].idle_sweeps = 0;
 }
 
 /* Allocates space using the second generation allocator and returns
@@ -73,12 +73,18 @@ void * MVM_gc_gen2_allocate(MVMGen2Allocator *al, MVMuint32 size) {
         if (al->size_classes[bin].pages == NULL)
             setup_bin(al, bin);
 
-        /* If there's a free list entry, use that. */
-        if (al->size_classes[bin].free_list) {
+        /* If there's a free list entry, use that, unless the size class is
+         * still waiting to be swept, in which case the free list must not be
+         * touched until it is. */
+        if (al->size_classes[bin].free_list && !al->size_classes[bin].sweep_num_pages) {
             result = (void *)al->size_classes[bin].free_list;
             al->size_classes[bin].free_list = (char **)*(al->size_classes[bin].free_list);
         }
         else {
+            /* If a sweep is pending, note that we'd like it done soon. */
+            if (al->size_classes[bin].sweep_num_pages)
+                al->sweep_wanted |= (MVMuint64)1 << bin;
+
             /* If we're at the page limit, add a new page. */
             if (al->size_classes[bin].alloc_pos == al->size_classes[bin].alloc_limit)
                 add_page(al, bin);
@@ -89,16 +95,8 @@ void * MVM_gc_gen2_allocate(MVMGen2Allocator *al, MVMuint32 size) {
         }
     }
     else {
-        /* We're beyond the size class bins, so resort to malloc. */
-        result = MVM_malloc(size);
-
-        /* Add to overflows list. */
-        if (al->num_overflows == al->alloc_overflows) {
-            al->alloc_overflows *= 2;
-            al->overflows = MVM_realloc(al->overflows,
-                al->alloc_overflows * sizeof(MVMCollectable *));
-        }
-        al->overflows[al->num_overflows++] = result;
+        /* We're beyond the size class bins, so use the large object space. */
+        result = MVM_gc_los_allocate(al, size);
     }
 
     return result;
@@ -125,16 +123,12 @@ void MVM_gc_gen2_destroy(MVMInstance *i, MVMGen2Allocator *al) {
         MVM_free(al->size_classes[j].pages);
     }
 
-    /* Free any allocated overflows. */
-    for (j = 0; j < al->num_overflows; j++)
-        if (al->overflows[j])
-            MVM_free(al->overflows[j]);
+    /* Free any large objects. */
+    MVM_gc_los_destroy(al);
 
     /* Clean up allocator data structure. */
     MVM_free(al->size_classes);
     al->size_classes = NULL;
-    MVM_free(al->overflows);
-    al->overflows = NULL;
     MVM_free(al);
 }
 
@@ -229,6 +223,7 @@ void MVM_gc_gen2_transfer(MVMThreadContext *src, MVMThreadContext *dest) {
         gen2->size_classes[bin].pages = NULL;
         gen2->size_classes[bin].num_pages = 0;
     }
+    MVM_gc_los_transfer(src, dest);
     { /* copy the roots... */
         MVMuint32 i, n = src->num_gen2roots;
         for ( i = 0; i < n; i++) {
@@ -239,28 +234,15 @@ void MVM_gc_gen2_transfer(MVMThreadContext *src, MVMThreadContext *dest) {
         MVM_free(src->gen2roots);
         src->gen2roots = NULL;
     }
-}
-
-
-void MVM_gc_gen2_compact_overflows(MVMGen2Allocator *al) {
-    /* compact the overflow list to prevent it from growing without bounds */
-    MVMCollectable **overflows     = al->overflows;
-    const MVMuint32  num_overflows = al->num_overflows;
-    MVMuint32        cursor = 0;
-    MVMuint32        live;
-
-    /* Find the first NULL object. */
-    while (cursor < num_overflows && overflows[cursor])
-        cursor++;
-    live = cursor;
-
-    /* Slide others back so the alive ones are at the start of the list. */
-    while (cursor < num_overflows) {
-        if (overflows[cursor]) {
-            overflows[live++] = overflows[cursor];
+    { /* ...and anything logged for incremental marking. */
+        MVMuint32 i, n = src->num_gc_mark_log;
+        for ( i = 0; i < n; i++) {
+            MVM_gc_write_barrier_log(dest, src->gc_mark_log[i]);
         }
-        cursor++;
+        src->num_gc_mark_log = 0;
+        src->alloc_gc_mark_log = 0;
+        MVM_free(src->gc_mark_log);
+        src->gc_mark_log = NULL;
     }
-
-    al->num_overflows = live;
 }
+
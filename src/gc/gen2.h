@@ -20,6 +20,17 @@ struct MVMGen2SizeClass {
 
     /* The number of pages allocated. */
     MVMuint32 num_pages;
+
+    /* If sweeping this size class has been deferred after a full collection,
+     * the number of pages and the allocation position at the time, which is
+     * as far as the sweep should go. Zero pages if there's no sweep pending. */
+    MVMuint32 sweep_num_pages;
+    char *sweep_alloc_pos;
+
+    /* The number of times this size class has been swept since it last
+     * needed a new page. Once this reaches the page release threshold, any
+     * pages a sweep finds to be entirely free are given back. */
+    MVMuint32 idle_sweeps;
 };
 
 /* An "instance" of the fixed size allocator. */
@@ -30,15 +41,18 @@ struct MVMGen2Allocator {
      * past the limit. */
     MVMGen2SizeClass *size_classes;
 
-    /* Array of objects that were malloc'd instead, because they did
-     * not fit in a size class due to being too large. */
-    MVMCollectable **overflows;
+    /* List of the objects that did not fit in a size class due to being
+     * too large, which live in the large object space instead, along with
+     * how many there are and the memory they take up. */
+    MVMLargeObject  *large_objects;
+    MVMuint32        num_large_objects;
+    MVMuint64        large_object_bytes;
 
-    /* The number of objects in the overflow array. */
-    MVMuint32        num_overflows;
-
-    /* The amount of space allocated in the overflow array. */
-    MVMuint32        alloc_overflows;
+    /* The number of size classes with a pending sweep, and a bit field of
+     * those that have been allocated from while pending, which we should
+     * sweep first. */
+    MVMuint32        num_sweep_pending;
+    MVMuint64        sweep_wanted;
 };
 
 /* The number of bits we discard from the requested size when binning
@@ -55,12 +69,9 @@ struct MVMGen2Allocator {
 /* Mask used to know if we hit a size class exactly or have to round up. */
 #define MVM_GEN2_BIN_MASK   ((1 << MVM_GEN2_BIN_BITS) - 1)
 
-/* Number of bins in the FSA. Beyond this, we just degrade to malloc/free. */
+/* Number of bins in the FSA. Beyond this, we use the large object space. */
 #define MVM_GEN2_BINS       40
 
-/* Default overflow list size. */
-#define MVM_GEN2_OVERFLOWS  32
-
 /* The number of items that go into each page. */
 #define MVM_GEN2_PAGE_ITEMS 256
 
@@ -70,4 +81,3 @@ void * MVM_gc_gen2_allocate(MVMGen2Allocator *al, MVMuint32 size);
 void * MVM_gc_gen2_allocate_zeroed(MVMGen2Allocator *al, MVMuint32 size);
 void MVM_gc_gen2_destroy(MVMInstance *i, MVMGen2Allocator *allocator);
 void MVM_gc_gen2_transfer(MVMThreadContext *src, MVMThreadContext *dest);
-void MVM_gc_gen2_compact_overflows(MVMGen2Allocator *allocator);
@@ -0,0 +1,97 @@
+#include "moar.h"
+#include "platform/mmap.h"
+
+/* The large object space holds the gen2 objects that are too big for any of
+ * the gen2 size classes. Each has a header in front of it, linking it into a
+ * list per gen2 allocator, so allocating, freeing and handing the objects of
+ * an exiting thread over to another are all O(1), and sweeping is a single
+ * walk over the list. Big enough objects are given whole pages of their own,
+ * which go straight back to the OS when the object is freed. The number and
+ * total size of large objects are tracked, and counted in the GC stats. */
+
+/* Works out how much memory to actually allocate for an object of the given
+ * size, including its header. */
+static MVMuint64 allocation_size(MVMuint32 size) {
+    MVMuint64 total = sizeof(MVMLargeObject) + size;
+    if (total >= MVM_GC_LOS_PAGED_SIZE)
+        total = (total + MVM_GC_LOS_PAGE_SIZE - 1) & ~(MVMuint64)(MVM_GC_LOS_PAGE_SIZE - 1);
+    return total;
+}
+
+/* Allocates a large object, and adds it to the allocator's list. */
+void * MVM_gc_los_allocate(MVMGen2Allocator *al, MVMuint32 size) {
+    MVMuint64       total = allocation_size(size);
+    MVMLargeObject *lo    = total >= MVM_GC_LOS_PAGED_SIZE
+        ? MVM_platform_alloc_pages(total, MVM_PAGE_READ | MVM_PAGE_WRITE)
+        : MVM_malloc(total);
+    lo->size = total;
+    lo->prev = NULL;
+    lo->next = al->large_objects;
+    if (lo->next)
+        lo->next->prev = lo;
+    al->large_objects = lo;
+    al->num_large_objects++;
+    al->large_object_bytes += total;
+    return MVM_GC_LOS_OBJECT(lo);
+}
+
+/* Releases the memory of a large object. */
+static void release(MVMLargeObject *lo) {
+    if (lo->size >= MVM_GC_LOS_PAGED_SIZE)
+        MVM_platform_free_pages(lo, lo->size);
+    else
+        MVM_free(lo);
+}
+
+/* Unlinks a large object from its allocator's list and frees it. Any clean
+ * up of the object itself must have been done already. */
+void MVM_gc_los_free(MVMGen2Allocator *al, MVMCollectable *col) {
+    MVMLargeObject *lo = MVM_GC_LOS_HEADER(col);
+    if (lo->prev)
+        lo->prev->next = lo->next;
+    else
+        al->large_objects = lo->next;
+    if (lo->next)
+        lo->next->prev = lo->prev;
+    al->num_large_objects--;
+    al->large_object_bytes -= lo->size;
+    release(lo);
+}
+
+/* Hands the large objects of one thread over to another, which takes over
+ * ownership of them. */
+void MVM_gc_los_transfer(MVMThreadContext *src, MVMThreadContext *dest) {
+    MVMGen2Allocator *gen2      = src->gen2;
+    MVMGen2Allocator *dest_gen2 = dest->gen2;
+    MVMLargeObject   *lo        = gen2->large_objects;
+    MVMLargeObject   *last      = NULL;
+    if (!lo)
+        return;
+    while (lo) {
+        MVM_GC_LOS_OBJECT(lo)->owner = dest->thread_id;
+        last = lo;
+        lo   = lo->next;
+    }
+    last->next = dest_gen2->large_objects;
+    if (last->next)
+        last->next->prev = last;
+    dest_gen2->large_objects       = gen2->large_objects;
+    dest_gen2->num_large_objects  += gen2->num_large_objects;
+    dest_gen2->large_object_bytes += gen2->large_object_bytes;
+    gen2->large_objects      = NULL;
+    gen2->num_large_objects  = 0;
+    gen2->large_object_bytes = 0;
+}
+
+/* Frees all of the large objects of an allocator. */
+void MVM_gc_los_destroy(MVMGen2Allocator *al) {
+    MVMLargeObject *lo = al->large_objects;
+    while (lo) {
+        MVMLargeObject *next = lo->next;
+        release(lo);
+        lo = next;
+    }
+    al->large_objects      = NULL;
+    al->num_large_objects  = 0;
+    al->large_object_bytes = 0;
+}
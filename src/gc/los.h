@@ -0,0 +1,28 @@
+/* Header kept in front of each object in the large object space; that is,
+ * each object too big for the gen2 size classes. The objects of a gen2
+ * allocator are kept in a doubly linked list, so that one can be freed
+ * without searching for it. */
+struct MVMLargeObject {
+    MVMLargeObject *prev;
+    MVMLargeObject *next;
+
+    /* The size of the allocation, including this header. */
+    MVMuint64 size;
+};
+
+/* Large objects taking up at least this many bytes (header included) get
+ * whole pages of their own from the OS, rather than coming from malloc, so
+ * their memory is given back as soon as they are freed. */
+#define MVM_GC_LOS_PAGED_SIZE   16384
+
+/* The page size that paged allocations are rounded up to. */
+#define MVM_GC_LOS_PAGE_SIZE    4096
+
+/* Gets the object following a large object header, and the other way. */
+#define MVM_GC_LOS_OBJECT(lo)   ((MVMCollectable *)((char *)(lo) + sizeof(MVMLargeObject)))
+#define MVM_GC_LOS_HEADER(col)  ((MVMLargeObject *)((char *)(col) - sizeof(MVMLargeObject)))
+
+void * MVM_gc_los_allocate(MVMGen2Allocator *al, MVMuint32 size);
+void MVM_gc_los_free(MVMGen2Allocator *al, MVMCollectable *col);
+void MVM_gc_los_transfer(MVMThreadContext *src, MVMThreadContext *dest);
+void MVM_gc_los_destroy(MVMGen2Allocator *al);
@@ -5,9 +5,10 @@
 MVMuint64 MVM_gc_object_id(MVMThreadContext *tc, MVMObject *obj) {
     MVMuint64 id;
 
-    /* If it's already in the old generation, just use memory address, as
-     * gen2 objects never move. */
+    /* If it's already in the old generation, just use memory address, and
+     * pin it so that compacting gen2 will not move it. */
     if (obj->header.flags & MVM_CF_SECOND_GEN) {
+        obj->header.flags |= MVM_CF_GEN2_PINNED;
         id = (MVMuint64)obj;
     }
 
@@ -26,6 +27,7 @@ MVMuint64 MVM_gc_object_id(MVMThreadContext *tc, MVMObject *obj) {
             entry            = MVM_calloc(1, sizeof(MVMObjectId));
             entry->current   = obj;
             entry->gen2_addr = MVM_gc_gen2_allocate_zeroed(tc->gen2, obj->header.size);
+            ((MVMCollectable *)entry->gen2_addr)->flags |= MVM_CF_GEN2_PINNED;
             HASH_ADD_KEYPTR(hash_handle, tc->instance->object_ids, &(entry->current),
                 sizeof(MVMObject *), entry);
             obj->header.flags |= MVM_CF_HAS_OBJECT_ID;
@@ -1,5 +1,6 @@
 #include "moar.h"
 #include <platform/threads.h>
+#include "platform/time.h"
 
 /* If we have the job of doing GC for a thread, we add it to our work
  * list. */
@@ -105,13 +106,63 @@ static int process_in_tray(MVMThreadContext *tc, MVMuint8 gen) {
     return 0;
 }
 
+/* Does a chunk of work from the steal pool, if any. Returns a non-zero value
+ * if work was found and done, and zero otherwise. */
+static int process_steal_pool(MVMThreadContext *tc, MVMuint8 gen) {
+    if (MVM_load(&tc->instance->gc_steal_pool_chunks)) {
+        GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE,
+            "Thread %d run %d : Stealing work from the steal pool\n");
+        MVM_gc_collect(tc, MVMGCWhatToDo_Stolen, gen);
+        return 1;
+    }
+    return 0;
+}
+
+/* Checks if there's any work we could do: either shared work in the steal
+ * pool, or work in the in-tray of a thread we're doing GC for. */
+static int have_work_to_do(MVMThreadContext *tc) {
+    MVMuint32 i;
+    if (MVM_load(&tc->instance->gc_steal_pool_chunks))
+        return 1;
+    for (i = 0; i < tc->gc_work_count; i++)
+        if (MVM_load(&tc->gc_work[i].tc->gc_in_tray))
+            return 1;
+    return 0;
+}
+
+/* Called in a full collection by a thread that has finished its own work.
+ * Rather than just voting to finish, it declares itself idle (which invites
+ * busy threads to share their gen2 marking work) and steals work until all
+ * of the participating threads are idle, at which point nothing more can be
+ * shared. Work passed to an in-tray after that is handled by the
+ * co-ordinator. */
+static void steal_work(MVMThreadContext *tc, MVMuint8 gen) {
+    MVMuint32 participants = MVM_load(&tc->instance->gc_steal_participants);
+    MVM_incr(&tc->instance->gc_steal_idle);
+    while (MVM_load(&tc->instance->gc_steal_idle) < participants) {
+        if (have_work_to_do(tc)) {
+            MVMuint32 i, did_work = 1;
+            MVM_decr(&tc->instance->gc_steal_idle);
+            while (did_work) {
+                did_work = process_steal_pool(tc, gen);
+                for (i = 0; i < tc->gc_work_count; i++)
+                    did_work += process_in_tray(tc->gc_work[i].tc, gen);
+            }
+            MVM_incr(&tc->instance->gc_steal_idle);
+        }
+        else {
+            MVM_platform_thread_yield();
+        }
+    }
+}
+
 /* Called by a thread when it thinks it is done with GC. It may get some more
  * work yet, though. */
 static void clear_intrays(MVMThreadContext *tc, MVMuint8 gen) {
     MVMuint32 did_work = 1;
     while (did_work) {
         MVMThread *cur_thread;
-        did_work = 0;
+        did_work = process_steal_pool(tc, gen);
         cur_thread = (MVMThread *)MVM_load(&tc->instance->threads);
         while (cur_thread) {
             if (cur_thread->body.tc)
@@ -133,6 +184,13 @@ static void finish_gc(MVMThreadContext *tc, MVMuint8 gen, MVMuint8 is_coordinato
             did_work += process_in_tray(tc->gc_work[i].tc, gen);
     }
 
+    /* In a full collection, help threads that are still busy marking. */
+    if (gen == MVMGCGenerations_Both) {
+        GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE,
+            "Thread %d run %d : looking for work to steal\n");
+        steal_work(tc, gen);
+    }
+
     /* Decrement gc_finish to say we're done, and wait for termination. */
     GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE, "Thread %d run %d : Voting to finish\n");
     uv_mutex_lock(&tc->instance->mutex_gc_orchestrate);
@@ -149,9 +207,13 @@ static void finish_gc(MVMThreadContext *tc, MVMuint8 gen, MVMuint8 is_coordinato
      * that needs adding to the finalize queue. It then will make another
      * iteration over in-trays to handle cross-thread references to objects
      * needing finalization. For full collections, collected objects are then
-     * cleaned from all inter-generational sets, and finally any objects to
-     * be freed at the fixed size allocator's next safepoint are freed. */
+     * cleaned from all inter-generational sets, and gen2 is compacted if
+     * that is enabled. Finally, any objects to be freed at the fixed size
+     * allocator's next safepoint are freed, after a full collection any of
+     * its pages that have long been entirely free are released, and the GC
+     * statistics are updated. */
     if (is_coordinator) {
+        MVMThread *cur_thread;
         GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE,
             "Thread %d run %d : Co-ordinator handling in-tray clearing completion\n");
         clear_intrays(tc, gen);
@@ -162,9 +224,9 @@ static void finish_gc(MVMThreadContext *tc, MVMuint8 gen, MVMuint8 is_coordinato
         clear_intrays(tc, gen);
 
         if (gen == MVMGCGenerations_Both) {
-            MVMThread *cur_thread = (MVMThread *)MVM_load(&tc->instance->threads);
             GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE,
                 "Thread %d run %d : Co-ordinator handling inter-gen root cleanup\n");
+            cur_thread = (MVMThread *)MVM_load(&tc->instance->threads);
             while (cur_thread) {
                 if (cur_thread->body.tc)
                     MVM_gc_root_gen2_cleanup(cur_thread->body.tc);
@@ -172,9 +234,46 @@ static void finish_gc(MVMThreadContext *tc, MVMuint8 gen, MVMuint8 is_coordinato
             }
         }
 
+        if (tc->instance->gc_marking) {
+            if (gen == MVMGCGenerations_Both) {
+                GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE,
+                    "Thread %d run %d : Co-ordinator finishing incremental marking\n");
+                MVM_gc_collect_incremental_finish(tc);
+            }
+            else {
+                GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE,
+                    "Thread %d run %d : Co-ordinator doing incremental marking\n");
+                tc->instance->gc_marking_pending = MVM_gc_collect_incremental_mark(tc,
+                    MVM_GC_INCREMENTAL_SLICE);
+            }
+        }
+
+        /* Find out which sampled allocations survived, for the specializer's
+         * pretenuring decisions. This looks at where the samples were copied
+         * to, so must happen before gen2 compaction moves anything. */
+        cur_thread = (MVMThread *)MVM_load(&tc->instance->threads);
+        while (cur_thread) {
+            if (cur_thread->body.tc && cur_thread->body.tc->num_spesh_alloc_samples)
+                MVM_spesh_log_gc_allocations(cur_thread->body.tc);
+            cur_thread = cur_thread->body.next;
+        }
+
+        if (gen == MVMGCGenerations_Both && tc->instance->gc_compact) {
+            GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE,
+                "Thread %d run %d : Co-ordinator considering gen2 compaction\n");
+            MVM_gc_compact_gen2(tc);
+        }
+
         GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE,
             "Thread %d run %d : Co-ordinator handling fixed-size allocator safepoint frees\n");
         MVM_fixed_size_safepoint(tc, tc->instance->fsa);
+        if (gen == MVMGCGenerations_Both) {
+            GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE,
+                "Thread %d run %d : Co-ordinator releasing free fixed-size allocator pages\n");
+            MVM_fixed_size_release_pages(tc, tc->instance->fsa);
+        }
+
+        MVM_gc_stats_run_finished(tc);
 
         MVM_profile_heap_take_snapshot(tc);
 
@@ -204,6 +303,8 @@ static void finish_gc(MVMThreadContext *tc, MVMuint8 gen, MVMuint8 is_coordinato
         if (MVM_load(&thread_obj->body.stage) == MVM_thread_stage_clearing_nursery) {
             GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE,
                 "Thread %d run %d : transferring gen2 of thread %d\n", other->thread_id);
+            MVM_gc_collect_sweep_gen2_pending(other, 0);
+            MVM_gc_collect_sweep_gen2_pending(tc, 0);
             MVM_gc_gen2_transfer(other, tc);
             GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE,
                 "Thread %d run %d : destroying thread %d\n", other->thread_id);
@@ -212,16 +313,30 @@ static void finish_gc(MVMThreadContext *tc, MVMuint8 gen, MVMuint8 is_coordinato
             MVM_store(&thread_obj->body.stage, MVM_thread_stage_destroyed);
         }
         else {
-            /* Free gen2 unmarked if full collection. */
+            /* If it's a full collection, arrange for gen2 unmarked to be
+             * freed. This is done lazily, so the sweeping is spread over
+             * the nursery collections that follow. */
             if (gen == MVMGCGenerations_Both) {
                 GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE,
-                    "Thread %d run %d : freeing gen2 of thread %d\n",
+                    "Thread %d run %d : deferring freeing gen2 of thread %d\n",
                     other->thread_id);
-                MVM_gc_collect_free_gen2_unmarked(other, 0);
+                MVM_gc_collect_defer_gen2_sweep(other);
+            }
+            else {
+                GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE,
+                    "Thread %d run %d : sweeping some gen2 of thread %d\n",
+                    other->thread_id);
+                MVM_gc_collect_sweep_gen2_pending(other, MVM_GC_SWEEP_PAGE_BUDGET);
             }
 
-            /* Contribute this thread's promoted bytes. */
-            MVM_add(&tc->instance->gc_promoted_bytes_since_last_full, other->gc_promoted_bytes);
+            /* Contribute this thread's promoted and pretenured bytes, and
+             * growth of memory held by its gen2 objects. */
+            MVM_add(&tc->instance->gc_promoted_bytes_since_last_full,
+                other->gc_promoted_bytes + other->gc_pretenured_bytes +
+                other->gc_gen2_unmanaged_bytes);
+            other->gc_pretenured_bytes     = 0;
+            other->gc_gen2_unmanaged_bytes = 0;
+            other->gc_stats.promoted_bytes += other->gc_promoted_bytes;
 
             /* Collect nursery. */
             GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE,
@@ -229,6 +344,9 @@ static void finish_gc(MVMThreadContext *tc, MVMuint8 gen, MVMuint8 is_coordinato
                 other->thread_id);
             MVM_gc_collect_free_nursery_uncopied(other, tc->gc_work[i].limit);
 
+            /* Decide how big its nursery should be from now on. */
+            MVM_gc_collect_adapt_nursery_size(other, tc->gc_work[i].limit);
+
             /* Handle exited threads. */
             if (MVM_load(&thread_obj->body.stage) == MVM_thread_stage_exited) {
                 /* Don't bother freeing gen2; we'll do it next time */
@@ -324,7 +442,40 @@ static MVMint32 is_full_collection(MVMThreadContext *tc) {
     return percent_growth >= MVM_GC_GEN2_THRESHOLD_PERCENT;
 }
 
-static void run_gc(MVMThreadContext *tc, MVMuint8 what_to_do) {
+static void finish_pending_sweeps(MVMThreadContext *tc) {
+    MVMuint32 i, n;
+    for (i = 0, n = tc->gc_work_count ; i < n; i++)
+        MVM_gc_collect_sweep_gen2_pending(tc->gc_work[i].tc, 0);
+    MVM_incr(&tc->instance->gc_sweep_finished);
+    while (MVM_load(&tc->instance->gc_sweep_finished) < MVM_load(&tc->instance->gc_steal_participants)) {
+        GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE,
+            "Thread %d run %d : waiting for other threads to finish sweeping\n");
+        MVM_platform_thread_yield();
+    }
+}
+
+static void decide_incremental_marking(MVMThreadContext *tc) {
+    MVMInstance *i = tc->instance;
+    if (i->gc_marking) {
+        i->gc_marking_runs++;
+        i->gc_full_collect = i->gc_marking_pending == 0 ||
+            i->gc_marking_runs >= MVM_GC_INCREMENTAL_MAX_RUNS;
+    }
+    else if (i->gc_full_collect) {
+        GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE,
+            "Thread %d run %d : starting incremental marking cycle\n");
+        i->gc_marking         = 1;
+        i->gc_marking_runs    = 0;
+        i->gc_marking_pending = 0;
+        i->gc_full_collect    = 0;
+    }
+}
+
+/* Does a GC run. The start time is when this thread stopped to take part in
+ * it, and is used for the GC statistics. */
+static void run_gc(MVMThreadContext *tc, MVMuint8 what_to_do, MVMuint64 start) {
+    MVMuint64  run_start = MVM_platform_now();
+    MVMuint64  end;
     MVMuint8   gen;
     MVMuint32  i, n;
 
@@ -344,6 +495,13 @@ static void run_gc(MVMThreadContext *tc, MVMuint8 what_to_do) {
         interval_id = MVM_telemetry_interval_start(tc, "start minor collection");
     }
 
+    /* If we're going to mark gen2, then any sweeping left over from the
+     * last full collection must be finished first, since it would clear the
+     * marks we set. Every thread must be done with this before any of them
+     * starts marking. */
+    if (gen == MVMGCGenerations_Both || tc->instance->gc_marking)
+        finish_pending_sweeps(tc);
+
     /* Do GC work for ourselves and any work threads. */
     for (i = 0, n = tc->gc_work_count ; i < n; i++) {
         MVMThreadContext *other = tc->gc_work[i].tc;
@@ -357,6 +515,13 @@ static void run_gc(MVMThreadContext *tc, MVMuint8 what_to_do) {
     /* Wait for everybody to agree we're done. */
     finish_gc(tc, gen, what_to_do == MVMGCWhatToDo_All);
 
+    /* Record how long we were paused for; the co-ordinator's pause also
+     * counts for the instance. */
+    end = MVM_platform_now();
+    MVM_gc_stats_record_pause(tc, &tc->gc_stats, gen, start, run_start, end);
+    if (what_to_do == MVMGCWhatToDo_All)
+        MVM_gc_stats_record_pause(tc, &tc->instance->gc_stats, gen, start, run_start, end);
+
     MVM_telemetry_interval_stop(tc, interval_id, "finished run_gc");
 }
 
@@ -365,6 +530,8 @@ static void run_gc(MVMThreadContext *tc, MVMuint8 what_to_do) {
  * will need to do that triggering, notifying other running threads that the
  * time has come to GC. */
 void MVM_gc_enter_from_allocator(MVMThreadContext *tc) {
+    MVMuint64 start = MVM_platform_now();
+
     GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE, "Thread %d run %d : Entered from allocate\n");
 
     MVM_telemetry_timestamp(tc, "gc_enter_from_allocator");
@@ -392,6 +559,13 @@ void MVM_gc_enter_from_allocator(MVMThreadContext *tc) {
         /* Decide if it will be a full collection. */
         tc->instance->gc_full_collect = is_full_collection(tc);
 
+        /* If we're doing incremental marking, a full collection is instead
+         * the start of a marking cycle; we mark a slice after each nursery
+         * collection, and do the full collection once there's nothing left
+         * to mark (or we've spent too many runs on it). */
+        if (tc->instance->gc_incremental)
+            decide_incremental_marking(tc);
+
         MVM_telemetry_timestamp(tc, "won the gc starting race");
 
         /* If profiling, record that GC is starting. */
@@ -441,6 +615,11 @@ void MVM_gc_enter_from_allocator(MVMThreadContext *tc) {
         GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE, "Thread %d run %d : finish votes is %d\n",
             (int)MVM_load(&tc->instance->gc_finish));
 
+        /* Set up work stealing state; all participants start out busy. */
+        MVM_store(&tc->instance->gc_steal_participants, num_threads + 1);
+        MVM_store(&tc->instance->gc_steal_idle, 0);
+        MVM_store(&tc->instance->gc_sweep_finished, 0);
+
         /* Now we're ready to start, zero promoted since last full collection
          * counter if this is a full collect. */
         if (tc->instance->gc_full_collect)
@@ -463,7 +642,7 @@ void MVM_gc_enter_from_allocator(MVMThreadContext *tc) {
 
         /* Start collecting. */
         GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE, "Thread %d run %d : coordinator entering run_gc\n");
-        run_gc(tc, MVMGCWhatToDo_All);
+        run_gc(tc, MVMGCWhatToDo_All, start);
 
         /* If profiling, record that GC is over. */
         if (tc->instance->profiling)
@@ -485,6 +664,7 @@ void MVM_gc_enter_from_allocator(MVMThreadContext *tc) {
  * that another thread is already trying to start a GC run, so we don't need to
  * try and do that, just enlist in the run. */
 void MVM_gc_enter_from_interrupt(MVMThreadContext *tc) {
+    MVMuint64 start = MVM_platform_now();
     AO_t curr;
 
     GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE, "Thread %d run %d : Entered from interrupt\n");
@@ -518,7 +698,7 @@ void MVM_gc_enter_from_interrupt(MVMThreadContext *tc) {
     uv_mutex_unlock(&tc->instance->mutex_gc_orchestrate);
 
     GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE, "Thread %d run %d : Entering run_gc\n");
-    run_gc(tc, MVMGCWhatToDo_NoInstance);
+    run_gc(tc, MVMGCWhatToDo_NoInstance, start);
     GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE, "Thread %d run %d : GC complete\n");
 
     /* If profiling, record that GC is over. */
@@ -529,16 +709,21 @@ void MVM_gc_enter_from_interrupt(MVMThreadContext *tc) {
 /* Run the global destruction phase. */
 void MVM_gc_global_destruction(MVMThreadContext *tc) {
     char *nursery_tmp;
+    MVMuint32 size_tmp;
 
     /* Fake a nursery collection run by swapping the semi-
-     * space nurseries. */
+     * space nurseries, which may be of different sizes. */
     nursery_tmp = tc->nursery_fromspace;
     tc->nursery_fromspace = tc->nursery_tospace;
     tc->nursery_tospace = nursery_tmp;
+    size_tmp = tc->nursery_fromspace_size;
+    tc->nursery_fromspace_size = tc->nursery_tospace_size;
+    tc->nursery_tospace_size = size_tmp;
 
     /* Run the objects' finalizers */
     MVM_gc_collect_free_nursery_uncopied(tc, tc->nursery_alloc);
     MVM_gc_root_gen2_cleanup(tc);
+    MVM_gc_collect_sweep_gen2_pending(tc, 0);
     MVM_gc_collect_free_gen2_unmarked(tc, 1);
     MVM_gc_collect_free_stables(tc);
 }
@@ -178,9 +178,10 @@ void MVM_gc_root_add_tc_roots_to_worklist(MVMThreadContext *tc, MVMGCWorklist *w
     add_collectable(tc, worklist, snapshot, tc->serialized_string_heap,
         "Serialized string heap");
 
-    /* Specialization log and stack simulation. */
+    /* Specialization log, stack simulation, and allocation samples. */
     add_collectable(tc, worklist, snapshot, tc->spesh_log, "Specialization log");
     MVM_spesh_sim_stack_gc_mark(tc, tc->spesh_sim_stack, worklist);
+    MVM_spesh_log_gc_mark_allocations(tc, worklist);
 }
 
 /* Pushes a temporary root onto the thread-local roots list. */
@@ -263,7 +264,7 @@ void MVM_gc_root_gen2_add(MVMThreadContext *tc, MVMCollectable *c) {
     tc->num_gen2roots++;
 
     /* Flag it as added, so we don't add it multiple times. */
-    c->flags |= MVM_CF_IN_GEN2_ROOT_LIST;
+    MVM_gc_set_flags(c, MVM_CF_IN_GEN2_ROOT_LIST);
 }
 
 /* Adds the set of thread-local inter-generational roots to a GC worklist. As
@@ -286,16 +287,26 @@ void MVM_gc_root_add_gen2s_to_worklist(MVMThreadContext *tc, MVMGCWorklist *work
     for (i = 0; i < num_roots; i++) {
         /* Count items on worklist before we mark it. */
         MVMuint32 items_before_mark  = worklist->items;
+        MVMint32  references_nursery;
 
         /* Put things it references into the worklist; since the worklist will
          * be set not to include gen2 things, only nursery things will make it
-         * in. */
+         * in. Arrays are handled by their REPR, since large ones may only need
+         * the dirty cards scanning. */
         assert(!(gen2roots[i]->flags & MVM_CF_FORWARDER_VALID));
-        MVM_gc_mark_collectable(tc, worklist, gen2roots[i]);
+        if (!(gen2roots[i]->flags & (MVM_CF_TYPE_OBJECT | MVM_CF_STABLE | MVM_CF_FRAME)) &&
+                REPR((MVMObject *)gen2roots[i])->ID == MVM_REPR_ID_VMArray) {
+            references_nursery = MVM_vmarray_mark_gen2_root(tc,
+                (MVMObject *)gen2roots[i], worklist);
+        }
+        else {
+            MVM_gc_mark_collectable(tc, worklist, gen2roots[i]);
+            references_nursery = worklist->items != items_before_mark;
+        }
 
         /* If we added any nursery objects, or if we are a frame with ->work
          * area, keep in this list. */
-        if (worklist->items != items_before_mark ||
+        if (references_nursery ||
                 (gen2roots[i]->flags & MVM_CF_FRAME && ((MVMFrame *)gen2roots[i])->work)) {
             gen2roots[insert_pos] = gen2roots[i];
             insert_pos++;
@@ -305,7 +316,7 @@ void MVM_gc_root_add_gen2s_to_worklist(MVMThreadContext *tc, MVMGCWorklist *work
          * thread may also clear this flag if it also had the entry in its
          * inter-gen list, so be careful to clear it, not just toggle. */
         else {
-            gen2roots[i]->flags &= ~MVM_CF_IN_GEN2_ROOT_LIST;
+            MVM_gc_clear_flags(gen2roots[i], MVM_CF_IN_GEN2_ROOT_LIST);
         }
     }
 
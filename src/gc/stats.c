@@ -0,0 +1,161 @@
+#include "moar.h"
+
+/* GC statistics: counts of collections, pause and rendezvous times, a pause
+ * time histogram, and promoted bytes, both per thread and for the instance as
+ * a whole. They are cheap enough to keep always, so can be asked for by the
+ * gcstats op in production, and also dumped periodically if MVM_GC_STATS is
+ * set. */
+
+/* Works out which histogram bucket a pause goes in. */
+static MVMuint32 histogram_bucket(MVMuint64 pause) {
+    MVMuint64 us     = pause / 1000;
+    MVMuint32 bucket = 0;
+    while (us && bucket < MVM_GC_STATS_BUCKETS - 1) {
+        us >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+/* Records a GC run that a thread took part in. It stopped for the run at the
+ * start time, the run itself started (that is, all threads had joined it) at
+ * the run_start time, and it was free to continue at the end time. */
+void MVM_gc_stats_record_pause(MVMThreadContext *tc, MVMGCStats *stats, MVMuint8 gen,
+        MVMuint64 start, MVMuint64 run_start, MVMuint64 end) {
+    MVMuint64 pause      = end - start;
+    MVMuint64 rendezvous = run_start - start;
+    if (gen == MVMGCGenerations_Both)
+        stats->full_collections++;
+    else
+        stats->nursery_collections++;
+    stats->pause_total += pause;
+    if (pause > stats->pause_max)
+        stats->pause_max = pause;
+    stats->rendezvous_total += rendezvous;
+    if (rendezvous > stats->rendezvous_max)
+        stats->rendezvous_max = rendezvous;
+    stats->pause_histogram[histogram_bucket(pause)]++;
+}
+
+/* Called by the co-ordinator of a GC run once all threads are done with
+ * collecting, and still waiting for it. Adds up the bytes promoted over all
+ * threads, and dumps the statistics if it is time to. */
+void MVM_gc_stats_run_finished(MVMThreadContext *tc) {
+    MVMInstance *instance   = tc->instance;
+    MVMThread   *cur_thread = (MVMThread *)MVM_load(&instance->threads);
+    while (cur_thread) {
+        if (cur_thread->body.tc)
+            instance->gc_stats.promoted_bytes += cur_thread->body.tc->gc_promoted_bytes;
+        cur_thread = cur_thread->body.next;
+    }
+    if (instance->gc_stats_interval &&
+            MVM_load(&instance->gc_seq_number) % instance->gc_stats_interval == 0)
+        MVM_gc_stats_dump(tc, stderr);
+}
+
+/* Builds a hash describing a set of statistics. Times are given in
+ * microseconds. */
+static MVMObject * stats_hash(MVMThreadContext *tc, MVMGCStats *stats) {
+    MVMHLLConfig *hll       = MVM_hll_current(tc);
+    MVMObject    *hash      = MVM_repr_alloc_init(tc, hll->slurpy_hash_type);
+    MVMObject    *histogram = MVM_repr_alloc_init(tc, hll->slurpy_array_type);
+    MVMuint32     i;
+    MVM_repr_bind_stat(tc, hash, "nursery_collections", stats->nursery_collections);
+    MVM_repr_bind_stat(tc, hash, "full_collections", stats->full_collections);
+    MVM_repr_bind_stat(tc, hash, "pause_total", stats->pause_total / 1000);
+    MVM_repr_bind_stat(tc, hash, "pause_max", stats->pause_max / 1000);
+    MVM_repr_bind_stat(tc, hash, "rendezvous_total", stats->rendezvous_total / 1000);
+    MVM_repr_bind_stat(tc, hash, "rendezvous_max", stats->rendezvous_max / 1000);
+    MVM_repr_bind_stat(tc, hash, "promoted_bytes", stats->promoted_bytes);
+    for (i = 0; i < MVM_GC_STATS_BUCKETS; i++)
+        MVM_repr_push_o(tc, histogram, MVM_repr_box_int(tc, hll->int_box_type,
+            (MVMint64)stats->pause_histogram[i]));
+    MVM_repr_bind_key_o(tc, hash,
+        MVM_string_ascii_decode_nt(tc, tc->instance->VMString, "pause_histogram"),
+        histogram);
+    return hash;
+}
+
+/* Gets the GC statistics for the instance as a hash, which has a "threads"
+ * key with an array of hashes of the same statistics for each running thread
+ * (with added "thread_id", and the number and size of the objects in its
+ * large object space). The instance level hash also has the counts
+ * of gen2 and fixed size allocator pages released. */
+MVMObject * MVM_gc_stats_get(MVMThreadContext *tc) {
+    MVMInstance  *instance = tc->instance;
+    MVMHLLConfig *hll      = MVM_hll_current(tc);
+    MVMObject    *result, *threads;
+    MVMThread    *cur_thread;
+
+    MVM_gc_allocate_gen2_default_set(tc);
+    result  = stats_hash(tc, &instance->gc_stats);
+    threads = MVM_repr_alloc_init(tc, hll->slurpy_array_type);
+    MVM_repr_bind_stat(tc, result, "gen2_pages_released", MVM_load(&instance->gc_gen2_pages_released));
+    MVM_repr_bind_stat(tc, result, "gen2_bytes_released", MVM_load(&instance->gc_gen2_bytes_released));
+    MVM_repr_bind_stat(tc, result, "fsa_pages_released", MVM_load(&instance->gc_fsa_pages_released));
+    MVM_repr_bind_stat(tc, result, "fsa_bytes_released", MVM_load(&instance->gc_fsa_bytes_released));
+    uv_mutex_lock(&instance->mutex_threads);
+    cur_thread = (MVMThread *)MVM_load(&instance->threads);
+    while (cur_thread) {
+        MVMThreadContext *thread_tc = cur_thread->body.tc;
+        if (thread_tc) {
+            MVMObject *thread_hash = stats_hash(tc, &thread_tc->gc_stats);
+            MVM_repr_bind_stat(tc, thread_hash, "thread_id", thread_tc->thread_id);
+            MVM_repr_bind_stat(tc, thread_hash, "large_objects", thread_tc->gen2->num_large_objects);
+            MVM_repr_bind_stat(tc, thread_hash, "large_object_bytes", thread_tc->gen2->large_object_bytes);
+            MVM_repr_push_o(tc, threads, thread_hash);
+        }
+        cur_thread = cur_thread->body.next;
+    }
+    uv_mutex_unlock(&instance->mutex_threads);
+    MVM_repr_bind_key_o(tc, result,
+        MVM_string_ascii_decode_nt(tc, instance->VMString, "threads"), threads);
+    MVM_gc_allocate_gen2_default_clear(tc);
+
+    return result;
+}
+
+/* Writes a set of statistics as a line of text. */
+static void dump_stats(FILE *out, const char *what, MVMGCStats *stats) {
+    MVMuint32 i;
+    fprintf(out, "%s: %"PRIu64" nursery, %"PRIu64" full; "
+        "pause total %.3fms, max %.3fms; rendezvous total %.3fms, max %.3fms; "
+        "promoted %"PRIu64" bytes; pauses:",
+        what, stats->nursery_collections, stats->full_collections,
+        stats->pause_total / 1e6, stats->pause_max / 1e6,
+        stats->rendezvous_total / 1e6, stats->rendezvous_max / 1e6,
+        stats->promoted_bytes);
+    for (i = 0; i < MVM_GC_STATS_BUCKETS - 1; i++)
+        if (stats->pause_histogram[i])
+            fprintf(out, " <%"PRIu64"us:%"PRIu64,
+                (MVMuint64)1 << i, stats->pause_histogram[i]);
+    if (stats->pause_histogram[i])
+        fprintf(out, " >=%"PRIu64"us:%"PRIu64,
+            (MVMuint64)1 << (i - 1), stats->pause_histogram[i]);
+    fprintf(out, "\n");
+}
+
+/* Dumps the GC statistics of the instance and each thread. Must only be used
+ * while the world is stopped for GC, as it walks the threads without taking
+ * the threads mutex. */
+void MVM_gc_stats_dump(MVMThreadContext *tc, FILE *out) {
+    MVMInstance *instance   = tc->instance;
+    MVMThread   *cur_thread = (MVMThread *)MVM_load(&instance->threads);
+    fprintf(out, "GC stats at run %"MVM_PRSz"; released %"MVM_PRSz" gen2 pages "
+        "(%"MVM_PRSz" bytes), %"MVM_PRSz" fixed size allocator pages (%"MVM_PRSz" bytes)\n",
+        MVM_load(&instance->gc_seq_number),
+        MVM_load(&instance->gc_gen2_pages_released),
+        MVM_load(&instance->gc_gen2_bytes_released),
+        MVM_load(&instance->gc_fsa_pages_released),
+        MVM_load(&instance->gc_fsa_bytes_released));
+    dump_stats(out, "  all threads", &instance->gc_stats);
+    while (cur_thread) {
+        if (cur_thread->body.tc) {
+            char what[32];
+            snprintf(what, sizeof(what), "  thread %u", cur_thread->body.tc->thread_id);
+            dump_stats(out, what, &cur_thread->body.tc->gc_stats);
+        }
+        cur_thread = cur_thread->body.next;
+    }
+    fflush(out);
+}
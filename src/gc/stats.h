@@ -0,0 +1,35 @@
+/* The number of buckets in a GC pause time histogram. Bucket 0 counts pauses
+ * of under 1 microsecond, and bucket n those of 2^(n-1) up to 2^n
+ * microseconds; the last also counts anything longer. */
+#define MVM_GC_STATS_BUCKETS    24
+
+/* GC statistics, kept both for each thread and for the VM instance as a
+ * whole. Times are in nanoseconds. A thread's pause is from when it stopped
+ * to take part in a GC run until it could continue, and its rendezvous time
+ * is the part of that it spent waiting for the other threads to join the
+ * run. For the instance, the pause and rendezvous times are those seen by
+ * the co-ordinator of each run. These are only ever written by the GC, so
+ * may be a little out of date when read while other threads are running. */
+struct MVMGCStats {
+    /* Number of nursery and full collections. */
+    MVMuint64 nursery_collections;
+    MVMuint64 full_collections;
+
+    /* Total and longest pause and rendezvous time. */
+    MVMuint64 pause_total;
+    MVMuint64 pause_max;
+    MVMuint64 rendezvous_total;
+    MVMuint64 rendezvous_max;
+
+    /* Total bytes promoted from the nursery to gen2. */
+    MVMuint64 promoted_bytes;
+
+    /* Histogram of pause times. */
+    MVMuint64 pause_histogram[MVM_GC_STATS_BUCKETS];
+};
+
+void MVM_gc_stats_record_pause(MVMThreadContext *tc, MVMGCStats *stats, MVMuint8 gen,
+    MVMuint64 start, MVMuint64 run_start, MVMuint64 end);
+void MVM_gc_stats_run_finished(MVMThreadContext *tc);
+MVMObject * MVM_gc_stats_get(MVMThreadContext *tc);
+void MVM_gc_stats_dump(MVMThreadContext *tc, FILE *out);
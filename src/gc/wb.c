@@ -11,3 +11,28 @@ void MVM_gc_write_barrier_hit(MVMThreadContext *tc, MVMCollectable *update_root)
     if (!(update_root->flags & MVM_CF_IN_GEN2_ROOT_LIST))
         MVM_gc_root_gen2_add(tc, update_root);
 }
+
+/* Called when the write barrier macro detects that an incremental gen2
+ * marking cycle is in progress and an unmarked gen2 object is being stored
+ * into a gen2 object. Adds the referenced object to the thread's mark log,
+ * which is processed by the GC at its next run. Note that we must not set
+ * the mark here, since only the GC may touch the flags of objects that may
+ * be owned by another thread. */
+void MVM_gc_write_barrier_log(MVMThreadContext *tc, MVMCollectable *referenced) {
+    if (tc->num_gc_mark_log == tc->alloc_gc_mark_log) {
+        tc->alloc_gc_mark_log = tc->alloc_gc_mark_log ? tc->alloc_gc_mark_log * 2 : 64;
+        tc->gc_mark_log = MVM_realloc(tc->gc_mark_log,
+            sizeof(MVMCollectable *) * tc->alloc_gc_mark_log);
+    }
+    tc->gc_mark_log[tc->num_gc_mark_log++] = referenced;
+}
+
+/* Called from JIT compiled code once it has found that storing referenced
+ * into update_root needs one of the barriers above, to pick which. */
+void MVM_gc_write_barrier_hit_by(MVMThreadContext *tc, MVMCollectable *update_root,
+                                 MVMCollectable *referenced) {
+    if (referenced->flags & MVM_CF_SECOND_GEN)
+        MVM_gc_write_barrier_log(tc, referenced);
+    else
+        MVM_gc_write_barrier_hit(tc, update_root);
+}
@@ -1,12 +1,22 @@
 /* Functions for if the write barriers are hit. */
 MVM_PUBLIC void MVM_gc_write_barrier_hit(MVMThreadContext *tc, MVMCollectable *update_root);
+MVM_PUBLIC void MVM_gc_write_barrier_log(MVMThreadContext *tc, MVMCollectable *referenced);
+MVM_PUBLIC void MVM_gc_write_barrier_hit_by(MVMThreadContext *tc, MVMCollectable *update_root,
+    MVMCollectable *referenced);
 
 /* Ensures that if a generation 2 object comes to hold a reference to a
  * nursery object, then the generation 2 object becomes an inter-generational
- * root. */
+ * root. Also, while an incremental gen2 marking cycle is in progress, makes
+ * sure that a gen2 object that is not yet marked and comes to be referenced
+ * by another gen2 object (which may already have been scanned) is logged, so
+ * the marker will not miss it. */
 MVM_STATIC_INLINE void MVM_gc_write_barrier(MVMThreadContext *tc, MVMCollectable *update_root, const MVMCollectable *referenced) {
-    if (((update_root->flags & MVM_CF_SECOND_GEN) && referenced && !(referenced->flags & MVM_CF_SECOND_GEN)))
-        MVM_gc_write_barrier_hit(tc, update_root);
+    if ((update_root->flags & MVM_CF_SECOND_GEN) && referenced) {
+        if (!(referenced->flags & MVM_CF_SECOND_GEN))
+            MVM_gc_write_barrier_hit(tc, update_root);
+        else if (tc->instance->gc_marking && !(referenced->flags & MVM_CF_GEN2_LIVE))
+            MVM_gc_write_barrier_log(tc, (MVMCollectable *)referenced);
+    }
 }
 
 /* Does an assignment, but makes sure the write barrier MVM_WB is applied
@@ -1,6 +1,5 @@
 #include "moar.h"
 #include "dasm_proto.h"
-#include "platform/mmap.h"
 #include "emit.h"
 
 #define COPY_ARRAY(a, n, t) memcpy(MVM_malloc(n * sizeof(t)), a, n * sizeof(t))
@@ -11,6 +10,7 @@ static const MVMuint16 MAGIC_BYTECODE[] = { MVM_OP_sp_jit_enter, 0 };
 MVMJitCode * MVM_jit_compile_graph(MVMThreadContext *tc, MVMJitGraph *jg) {
     dasm_State *state;
     char * memory;
+    void * writable;
     size_t codesize;
     /* Space for globals */
     MVMint32  num_globals = MVM_jit_num_globals();
@@ -58,6 +58,9 @@ MVMJitCode * MVM_jit_compile_graph(MVMThreadContext *tc, MVMJitGraph *jg) {
         case MVM_JIT_NODE_DATA:
             MVM_jit_emit_data(tc, jg, &node->u.data, &state);
             break;
+        case MVM_JIT_NODE_EXPR:
+            MVM_jit_emit_expr(tc, jg, node->u.expr, &state);
+            break;
         }
         node = node->next;
     }
@@ -65,12 +68,15 @@ MVMJitCode * MVM_jit_compile_graph(MVMThreadContext *tc, MVMJitGraph *jg) {
 
     /* compile the function */
     dasm_link(&state, &codesize);
-    memory = MVM_platform_alloc_pages(codesize, MVM_PAGE_READ|MVM_PAGE_WRITE);
-    dasm_encode(&state, memory);
+    memory = MVM_jit_heap_alloc(tc, codesize, &writable);
+    if (memory)
+        dasm_encode(&state, writable);
     /* set memory readable + executable */
-    if (!MVM_platform_set_page_mode(memory, codesize, MVM_PAGE_READ|MVM_PAGE_EXEC)) {
+    if (!memory || !MVM_jit_heap_seal(tc, memory, codesize)) {
         MVM_jit_log(tc, "Setting jit page executable failed or was denied. deactivating jit.\n");
 
+        if (memory)
+            MVM_jit_heap_free(tc, memory, codesize);
         dasm_free(&state);
         MVM_free(dasm_globals);
         tc->instance->jit_enabled = 0;
@@ -117,13 +123,15 @@ MVMJitCode * MVM_jit_compile_graph(MVMThreadContext *tc, MVMJitGraph *jg) {
     if (tc->instance->jit_bytecode_dir) {
         MVM_jit_log_bytecode(tc, code);
     }
+    if (tc->instance->jit_perf_map)
+        MVM_jit_log_perf_map(tc, code);
     if (tc->instance->jit_log_fh)
         fflush(tc->instance->jit_log_fh);
     return code;
 }
 
 void MVM_jit_destroy_code(MVMThreadContext *tc, MVMJitCode *code) {
-    MVM_platform_free_pages(code->func_ptr, code->size);
+    MVM_jit_heap_free(tc, code->func_ptr, code->size);
     MVM_free(code->labels);
     MVM_free(code->bb_labels);
     MVM_free(code->deopts);
@@ -0,0 +1,258 @@
+#include "moar.h"
+
+/* Annotations that need a label (or control node) right before the
+ * instruction; such an instruction may only start a run. */
+static MVMint32 has_before_annotation(MVMSpeshIns *ins) {
+    MVMSpeshAnn *ann = ins->annotations;
+    while (ann) {
+        switch (ann->type) {
+        case MVM_SPESH_ANN_FH_START:
+        case MVM_SPESH_ANN_FH_END:
+        case MVM_SPESH_ANN_FH_GOTO:
+        case MVM_SPESH_ANN_INLINE_START:
+        case MVM_SPESH_ANN_DEOPT_OSR:
+            return 1;
+        }
+        ann = ann->next;
+    }
+    return 0;
+}
+
+/* Annotations that need a label right after the instruction; such an
+ * instruction may only end a run. */
+static MVMint32 has_after_annotation(MVMSpeshIns *ins) {
+    MVMSpeshAnn *ann = ins->annotations;
+    while (ann) {
+        switch (ann->type) {
+        case MVM_SPESH_ANN_INLINE_END:
+        case MVM_SPESH_ANN_DEOPT_ALL_INS:
+            return 1;
+        }
+        ann = ann->next;
+    }
+    return 0;
+}
+
+static MVMint32 is_expr_op(MVMSpeshIns *ins) {
+    switch (ins->info->opcode) {
+    case MVM_OP_const_i64_16:
+    case MVM_OP_const_i64_32:
+    case MVM_OP_const_i64:
+    case MVM_OP_set:
+    case MVM_OP_add_i:
+    case MVM_OP_sub_i:
+    case MVM_OP_mul_i:
+    case MVM_OP_band_i:
+    case MVM_OP_bor_i:
+    case MVM_OP_bxor_i:
+    case MVM_OP_inc_i:
+    case MVM_OP_dec_i:
+    case MVM_OP_neg_i:
+    case MVM_OP_bnot_i:
+    case MVM_OP_eq_i:
+    case MVM_OP_ne_i:
+    case MVM_OP_lt_i:
+    case MVM_OP_le_i:
+    case MVM_OP_gt_i:
+    case MVM_OP_ge_i:
+    case MVM_OP_sp_p6oget_i:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+/* Works out how many instructions starting at first can be compiled as a
+ * single run. Returns 0 if the run would be too short to be worth it. */
+MVMint32 MVM_jit_expr_run_length(MVMThreadContext *tc, MVMSpeshGraph *sg,
+                                 MVMSpeshIns *first) {
+    MVMSpeshIns *ins = first;
+    MVMint32 length  = 0;
+    while (ins && length < MVM_JIT_EXPR_MAX_NODES && is_expr_op(ins)) {
+        if (ins != first && has_before_annotation(ins))
+            break;
+        length++;
+        if (has_after_annotation(ins))
+            break;
+        ins = ins->next;
+    }
+    return length >= MVM_JIT_EXPR_MIN_NODES ? length : 0;
+}
+
+typedef struct {
+    MVMJitExprTree *tree;
+    MVMint32        cur_node;
+} ExprBuilder;
+
+/* Finds or creates the value for a local and extends its live interval to
+ * the current node. Reads must be noted before writes of the same node. */
+static MVMint16 use_local(ExprBuilder *eb, MVMuint16 local, MVMint32 is_write) {
+    MVMJitExprTree *tree = eb->tree;
+    MVMJitExprValue *value;
+    MVMint32 i;
+    for (i = 0; i < tree->num_values; i++)
+        if (tree->values[i].local == local)
+            break;
+    value = &tree->values[i];
+    if (i == tree->num_values) {
+        tree->num_values++;
+        value->local   = local;
+        value->first   = eb->cur_node;
+        value->live_in = !is_write;
+        value->dirty   = 0;
+    }
+    value->last = eb->cur_node;
+    if (is_write)
+        value->dirty = 1;
+    return (MVMint16)i;
+}
+
+static MVMint32 fits_in_32_bit(MVMint64 number) {
+    return (number >= INT32_MIN) && (number <= INT32_MAX);
+}
+
+/* Sets up the right hand side of a binary node, using the known value of
+ * the operand as an immediate where spesh has one for us. */
+static void use_rhs(MVMThreadContext *tc, MVMSpeshGraph *sg, ExprBuilder *eb,
+                    MVMJitExprNode *node, MVMSpeshOperand operand, MVMint32 allow_imm) {
+    MVMSpeshFacts *facts = MVM_spesh_get_facts(tc, sg, operand);
+    if (allow_imm && (facts->flags & MVM_SPESH_FACT_KNOWN_VALUE) &&
+            fits_in_32_bit(facts->value.i)) {
+        node->src[1] = MVM_JIT_EXPR_IMM;
+        node->imm    = facts->value.i;
+    }
+    else {
+        node->src[1] = use_local(eb, operand.reg.orig, 0);
+    }
+}
+
+static void add_node(MVMThreadContext *tc, MVMSpeshGraph *sg, ExprBuilder *eb,
+                     MVMSpeshIns *ins) {
+    MVMJitExprNode *node = &eb->tree->nodes[eb->cur_node];
+    MVMuint16 op = ins->info->opcode;
+    node->src[0] = node->src[1] = 0;
+    node->imm    = 0;
+    switch (op) {
+    case MVM_OP_const_i64_16:
+    case MVM_OP_const_i64_32:
+    case MVM_OP_const_i64:
+        node->op  = MVM_JIT_EXPR_CONST;
+        node->imm = op == MVM_OP_const_i64_16 ? (MVMint64)ins->operands[1].lit_i16
+                  : op == MVM_OP_const_i64_32 ? (MVMint64)ins->operands[1].lit_i32
+                  : ins->operands[1].lit_i64;
+        break;
+    case MVM_OP_set:
+        node->op     = MVM_JIT_EXPR_COPY;
+        node->src[0] = use_local(eb, ins->operands[1].reg.orig, 0);
+        break;
+    case MVM_OP_inc_i:
+    case MVM_OP_dec_i:
+        node->op     = op == MVM_OP_inc_i ? MVM_JIT_EXPR_ADD : MVM_JIT_EXPR_SUB;
+        node->src[0] = use_local(eb, ins->operands[0].reg.orig, 0);
+        node->src[1] = MVM_JIT_EXPR_IMM;
+        node->imm    = 1;
+        break;
+    case MVM_OP_neg_i:
+    case MVM_OP_bnot_i:
+        node->op     = op == MVM_OP_neg_i ? MVM_JIT_EXPR_NEG : MVM_JIT_EXPR_NOT;
+        node->src[0] = use_local(eb, ins->operands[1].reg.orig, 0);
+        break;
+    case MVM_OP_sp_p6oget_i:
+        node->op     = MVM_JIT_EXPR_P6OGET;
+        node->src[0] = use_local(eb, ins->operands[1].reg.orig, 0);
+        node->imm    = ins->operands[2].lit_i16;
+        break;
+    default:
+        switch (op) {
+        case MVM_OP_add_i:  node->op = MVM_JIT_EXPR_ADD; break;
+        case MVM_OP_sub_i:  node->op = MVM_JIT_EXPR_SUB; break;
+        case MVM_OP_mul_i:  node->op = MVM_JIT_EXPR_MUL; break;
+        case MVM_OP_band_i: node->op = MVM_JIT_EXPR_AND; break;
+        case MVM_OP_bor_i:  node->op = MVM_JIT_EXPR_OR;  break;
+        case MVM_OP_bxor_i: node->op = MVM_JIT_EXPR_XOR; break;
+        case MVM_OP_eq_i:   node->op = MVM_JIT_EXPR_EQ;  break;
+        case MVM_OP_ne_i:   node->op = MVM_JIT_EXPR_NE;  break;
+        case MVM_OP_lt_i:   node->op = MVM_JIT_EXPR_LT;  break;
+        case MVM_OP_le_i:   node->op = MVM_JIT_EXPR_LE;  break;
+        case MVM_OP_gt_i:   node->op = MVM_JIT_EXPR_GT;  break;
+        case MVM_OP_ge_i:   node->op = MVM_JIT_EXPR_GE;  break;
+        default:
+            MVM_oops(tc, "JIT: unexpected op %s in expression run", ins->info->name);
+        }
+        node->src[0] = use_local(eb, ins->operands[1].reg.orig, 0);
+        /* imul only takes an immediate in its three operand form, which the
+         * emitter doesn't bother with. */
+        use_rhs(tc, sg, eb, node, ins->operands[2], node->op != MVM_JIT_EXPR_MUL);
+        break;
+    }
+    node->dst = use_local(eb, ins->operands[0].reg.orig, 1);
+}
+
+/* Linear scan register allocation (Poletto & Sarkar). Values are created in
+ * order of first use, so they're already sorted by interval start. The
+ * active list is kept sorted by interval end; when we run out of registers,
+ * whichever interval ends last is spilled for its whole length. */
+static void allocate_registers(MVMThreadContext *tc, MVMJitExprTree *tree) {
+    MVMint32 active[MVM_JIT_EXPR_NUM_REGS];
+    MVMint8  free_regs[MVM_JIT_EXPR_NUM_REGS];
+    MVMint32 num_active = 0, num_free = MVM_JIT_EXPR_NUM_REGS;
+    MVMint32 i, j;
+    for (i = 0; i < MVM_JIT_EXPR_NUM_REGS; i++)
+        free_regs[i] = MVM_JIT_EXPR_NUM_REGS - 1 - i;
+    tree->num_spilled = 0;
+    for (i = 0; i < tree->num_values; i++) {
+        MVMJitExprValue *value = &tree->values[i];
+        MVMint32 expired = 0;
+        /* Expire intervals that ended before this one starts. */
+        while (expired < num_active && tree->values[active[expired]].last < value->first)
+            free_regs[num_free++] = tree->values[active[expired++]].reg;
+        for (j = expired; j < num_active; j++)
+            active[j - expired] = active[j];
+        num_active -= expired;
+
+        if (num_free == 0) {
+            MVMJitExprValue *victim = &tree->values[active[num_active - 1]];
+            tree->num_spilled++;
+            if (victim->last > value->last) {
+                value->reg  = victim->reg;
+                victim->reg = MVM_JIT_EXPR_SPILLED;
+                num_active--;
+            }
+            else {
+                value->reg = MVM_JIT_EXPR_SPILLED;
+                continue;
+            }
+        }
+        else {
+            value->reg = free_regs[--num_free];
+        }
+
+        /* Insert into the active list, keeping it sorted by end. */
+        for (j = num_active; j > 0 && tree->values[active[j - 1]].last > value->last; j--)
+            active[j] = active[j - 1];
+        active[j] = i;
+        num_active++;
+    }
+}
+
+MVMJitExprTree * MVM_jit_expr_tree_build(MVMThreadContext *tc, MVMSpeshGraph *sg,
+                                         MVMSpeshIns *first, MVMint32 length) {
+    ExprBuilder eb;
+    MVMSpeshIns *ins = first;
+    MVMJitExprTree *tree = MVM_spesh_alloc(tc, sg, sizeof(MVMJitExprTree));
+    tree->nodes     = MVM_spesh_alloc(tc, sg, length * sizeof(MVMJitExprNode));
+    tree->num_nodes = length;
+    /* Every node touches at most three locals. */
+    tree->values     = MVM_spesh_alloc(tc, sg, 3 * length * sizeof(MVMJitExprValue));
+    tree->num_values = 0;
+
+    eb.tree = tree;
+    for (eb.cur_node = 0; eb.cur_node < length; eb.cur_node++) {
+        add_node(tc, sg, &eb, ins);
+        ins = ins->next;
+    }
+    allocate_registers(tc, tree);
+    MVM_jit_log(tc, "expression run: %d nodes, %d values, %d spilled\n",
+                tree->num_nodes, tree->num_values, tree->num_spilled);
+    return tree;
+}
@@ -0,0 +1,83 @@
+/* The expression layer compiles straight-line runs of simple integer and
+ * attribute ops without going through the frame's register array for every
+ * operand. A run is translated into a flat list of expression nodes over
+ * values (the MoarVM locals touched by the run); each value gets a live
+ * interval and a linear-scan pass assigns machine registers to as many of
+ * them as fit. Values are loaded at the start of their interval if they're
+ * read before being written, and stored back at its end if they were
+ * written, so outside of a run the frame's registers are always current. */
+
+/* Maximum number of spesh instructions folded into a single run. */
+#define MVM_JIT_EXPR_MAX_NODES 64
+
+/* Minimum run length; shorter runs are left to the per-op emitter. */
+#define MVM_JIT_EXPR_MIN_NODES 2
+
+/* Number of machine registers the allocator hands out. The emitter maps
+ * these to caller-saved registers, as nothing in a run calls into C, and
+ * keeps a couple more for scratch. */
+#define MVM_JIT_EXPR_NUM_REGS 5
+
+/* Register assignment of a value that lives in the frame's registers. */
+#define MVM_JIT_EXPR_SPILLED -1
+
+/* Source operand marker for the node's immediate value. */
+#define MVM_JIT_EXPR_IMM -1
+
+typedef enum {
+    MVM_JIT_EXPR_CONST,
+    MVM_JIT_EXPR_COPY,
+    MVM_JIT_EXPR_ADD,
+    MVM_JIT_EXPR_SUB,
+    MVM_JIT_EXPR_MUL,
+    MVM_JIT_EXPR_AND,
+    MVM_JIT_EXPR_OR,
+    MVM_JIT_EXPR_XOR,
+    MVM_JIT_EXPR_NEG,
+    MVM_JIT_EXPR_NOT,
+    MVM_JIT_EXPR_EQ,
+    MVM_JIT_EXPR_NE,
+    MVM_JIT_EXPR_LT,
+    MVM_JIT_EXPR_LE,
+    MVM_JIT_EXPR_GT,
+    MVM_JIT_EXPR_GE,
+    /* Load an int attribute of a P6opaque; imm holds the body offset. */
+    MVM_JIT_EXPR_P6OGET,
+} MVMJitExprOp;
+
+struct MVMJitExprNode {
+    MVMJitExprOp op;
+    /* Value written by this node. */
+    MVMint16     dst;
+    /* Values read by this node, or MVM_JIT_EXPR_IMM; unused ones are 0. */
+    MVMint16     src[2];
+    /* Immediate operand (constant, 32-bit right hand side, or offset). */
+    MVMint64     imm;
+};
+
+struct MVMJitExprValue {
+    /* The MoarVM local this value is held in. */
+    MVMuint16 local;
+    /* Live interval, as indexes of the first and last node touching it. */
+    MVMint32  first;
+    MVMint32  last;
+    /* Allocated register number, or MVM_JIT_EXPR_SPILLED. */
+    MVMint8   reg;
+    /* Read before written in the run, so must be loaded. */
+    MVMint8   live_in;
+    /* Written in the run, so must be stored back. */
+    MVMint8   dirty;
+};
+
+struct MVMJitExprTree {
+    MVMJitExprNode  *nodes;
+    MVMint32         num_nodes;
+    MVMJitExprValue *values;
+    MVMint32         num_values;
+    MVMint32         num_spilled;
+};
+
+MVMint32 MVM_jit_expr_run_length(MVMThreadContext *tc, MVMSpeshGraph *sg,
+                                 MVMSpeshIns *first);
+MVMJitExprTree * MVM_jit_expr_tree_build(MVMThreadContext *tc, MVMSpeshGraph *sg,
+                                         MVMSpeshIns *first, MVMint32 length);
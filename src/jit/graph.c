@@ -1,5 +1,6 @@
 #include "moar.h"
 #include "math.h"
+#include "strings/unicode_ops.h"
 
 typedef struct {
     MVMSpeshGraph *sg;
@@ -163,6 +164,14 @@ static void jgb_append_branch(MVMThreadContext *tc, JitGraphBuilder *jgb,
     jgb_append_node(jgb, node);
 }
 
+static void jgb_append_expr(MVMThreadContext *tc, JitGraphBuilder *jgb,
+                            MVMSpeshIns *first, MVMint32 length) {
+    MVMJitNode * node = MVM_spesh_alloc(tc, jgb->sg, sizeof(MVMJitNode));
+    node->type   = MVM_JIT_NODE_EXPR;
+    node->u.expr = MVM_jit_expr_tree_build(tc, jgb->sg, first, length);
+    jgb_append_node(jgb, node);
+}
+
 static void jgb_append_label(MVMThreadContext *tc, JitGraphBuilder *jgb, MVMint32 name) {
     MVMJitNode *node;
     if (jgb->last_node &&
@@ -176,6 +185,16 @@ static void jgb_append_label(MVMThreadContext *tc, JitGraphBuilder *jgb, MVMint3
     MVM_jit_log(tc, "append label: %d\n", node->u.label.name);
 }
 
+/* Calls to C are stored with MVM_JIT_RV_INT, which takes all of the return
+ * register, but the ABI leaves the upper half undefined when a function
+ * returns a 32 bit value; these widen the result. */
+static MVMint64 ord_basechar_at(MVMThreadContext *tc, MVMString *s, MVMint64 offset) {
+    return MVM_string_ord_basechar_at(tc, s, offset);
+}
+static MVMint64 unicode_lookup_by_name(MVMThreadContext *tc, MVMString *name) {
+    return MVM_unicode_lookup_by_name(tc, name);
+}
+
 static void * op_to_func(MVMThreadContext *tc, MVMint16 opcode) {
     switch(opcode) {
     case MVM_OP_checkarity: return MVM_args_checkarity;
@@ -213,6 +232,17 @@ static void * op_to_func(MVMThreadContext *tc, MVMint16 opcode) {
     case MVM_OP_resume: return MVM_exception_resume;
     case MVM_OP_continuationreset: return MVM_continuation_reset;
     case MVM_OP_continuationcontrol: return MVM_continuation_control;
+    case MVM_OP_continuationinvoke: return MVM_continuation_invoke;
+    case MVM_OP_bindexmessage: return MVM_bind_exception_message;
+    case MVM_OP_bindexpayload: return MVM_bind_exception_payload;
+    case MVM_OP_bindexcategory: return MVM_bind_exception_category;
+    case MVM_OP_getexmessage: return MVM_get_exception_message;
+    case MVM_OP_getexpayload: return MVM_get_exception_payload;
+    case MVM_OP_getexcategory: return MVM_get_exception_category;
+    case MVM_OP_exreturnafterunwind: return MVM_exception_returnafterunwind;
+    case MVM_OP_newexception: return MVM_repr_alloc_init;
+    case MVM_OP_backtrace: return MVM_exception_backtrace;
+    case MVM_OP_backtracestrings: return MVM_exception_backtrace_strings;
     case MVM_OP_smrt_numify: return MVM_coerce_smart_numify;
     case MVM_OP_smrt_strify: return MVM_coerce_smart_stringify;
     case MVM_OP_gethow: return MVM_6model_get_how_obj;
@@ -320,6 +350,24 @@ static void * op_to_func(MVMThreadContext *tc, MVMint16 opcode) {
     case MVM_OP_fc: return MVM_string_fc;
     case MVM_OP_eq_s: return MVM_string_equal;
     case MVM_OP_eqat_s: return MVM_string_equal_at;
+    case MVM_OP_eqatic_s: return MVM_string_equal_at_ignore_case;
+    case MVM_OP_eqatim_s: return MVM_string_equal_at_ignore_mark;
+    case MVM_OP_eqaticim_s: return MVM_string_equal_at_ignore_case_ignore_mark;
+    case MVM_OP_haveat_s: return MVM_string_have_at;
+    case MVM_OP_indexic_s: return MVM_string_index_ignore_case;
+    case MVM_OP_indexim_s: return MVM_string_index_ignore_mark;
+    case MVM_OP_indexicim_s: return MVM_string_index_ignore_case_ignore_mark;
+    case MVM_OP_rindexfrom: return MVM_string_index_from_end;
+    case MVM_OP_indexcp_s: return MVM_string_index_of_grapheme;
+    case MVM_OP_ordbaseat: return ord_basechar_at;
+    case MVM_OP_istrue_s: case MVM_OP_isfalse_s: return MVM_coerce_istrue_s;
+    case MVM_OP_bitand_s: return MVM_string_bitand;
+    case MVM_OP_bitor_s: return MVM_string_bitor;
+    case MVM_OP_bitxor_s: return MVM_string_bitxor;
+    case MVM_OP_unicmp_s: return MVM_unicode_string_compare;
+    case MVM_OP_getcpbyname: return unicode_lookup_by_name;
+    case MVM_OP_getuniname: return MVM_unicode_get_name;
+    case MVM_OP_strfromcodes: return MVM_unicode_codepoints_to_nfg_string;
     case MVM_OP_chars: case MVM_OP_graphs_s: return MVM_string_graphs;
     case MVM_OP_chr: return MVM_string_chr;
     case MVM_OP_codes_s: return MVM_string_codes;
@@ -375,6 +423,10 @@ static void * op_to_func(MVMThreadContext *tc, MVMint16 opcode) {
     case MVM_OP_isnanorinf: return MVM_num_isnanorinf;
     case MVM_OP_nativecallcast: return MVM_nativecall_cast;
     case MVM_OP_nativecallinvoke: return MVM_nativecall_invoke;
+    case MVM_OP_nativecallbuild: return MVM_nativecall_build;
+    case MVM_OP_nativecallrefresh: return MVM_nativecall_refresh;
+    case MVM_OP_nativecallglobal: return MVM_nativecall_global;
+    case MVM_OP_nativecallsizeof: return MVM_nativecall_sizeof;
     case MVM_OP_typeparameterized: return MVM_6model_parametric_type_parameterized;
     case MVM_OP_typeparameters: return MVM_6model_parametric_type_parameters;
     case MVM_OP_typeparameterat: return MVM_6model_parametric_type_parameter_at;
@@ -552,6 +604,8 @@ static MVMint32 jgb_consume_invoke(MVMThreadContext *tc, JitGraphBuilder *jgb,
         MVM_jit_log(tc, "Could not find invoke opcode or enough arguments\n"
                     "BAIL: op <%s>, expected args: %d, num of args: %d\n",
                     ins? ins->info->name : "NULL", i, cs->arg_count);
+        if (ins)
+            MVM_jit_count_bail(tc, ins);
         return 0;
     }
     MVM_jit_log(tc, "Invoke instruction: <%s>\n", ins->info->name);
@@ -1608,10 +1662,12 @@ static MVMint32 jgb_consume_ins(MVMThreadContext *tc, JitGraphBuilder *jgb,
     case MVM_OP_getcode:
     case MVM_OP_callercode:
     case MVM_OP_sp_fastcreate:
+    case MVM_OP_sp_fastcreate_gen2:
     case MVM_OP_iscont:
     case MVM_OP_decont:
     case MVM_OP_sp_decont:
     case MVM_OP_sp_findmeth:
+    case MVM_OP_sp_findmeth_poly:
     case MVM_OP_hllboxtype_i:
     case MVM_OP_hllboxtype_n:
     case MVM_OP_hllboxtype_s:
@@ -1661,6 +1717,15 @@ static MVMint32 jgb_consume_ins(MVMThreadContext *tc, JitGraphBuilder *jgb,
     case MVM_OP_sp_cas_o:
     case MVM_OP_sp_atomicload_o:
     case MVM_OP_sp_atomicstore_o:
+        /* Specialized array and hash access */
+    case MVM_OP_sp_vmarray_atpos_i:
+    case MVM_OP_sp_vmarray_atpos_n:
+    case MVM_OP_sp_vmarray_atpos_o:
+    case MVM_OP_sp_vmarray_bindpos_i:
+    case MVM_OP_sp_vmarray_bindpos_n:
+    case MVM_OP_sp_vmarray_bindpos_o:
+    case MVM_OP_sp_vmhash_atkey_o:
+    case MVM_OP_sp_vmhash_existskey:
         jgb_append_primitive(tc, jgb, ins);
         break;
     case MVM_OP_param_rp_i: {
@@ -2122,12 +2187,18 @@ static MVMint32 jgb_consume_ins(MVMThreadContext *tc, JitGraphBuilder *jgb,
     case MVM_OP_elems:
         if (!jgb_consume_reprop(tc, jgb, bb, ins)) {
             MVM_jit_log(tc, "BAIL: op <%s> (devirt attempted)\n", ins->info->name);
+            MVM_jit_count_bail(tc, ins);
             return 0;
         }
         break;
     case MVM_OP_iterkey_s:
     case MVM_OP_iterval:
-    case MVM_OP_iter: {
+    case MVM_OP_iter:
+    case MVM_OP_getexmessage:
+    case MVM_OP_getexpayload:
+    case MVM_OP_backtrace:
+    case MVM_OP_backtracestrings:
+    case MVM_OP_strfromcodes: {
         MVMint16 dst      = ins->operands[0].reg.orig;
         MVMint32 invocant = ins->operands[1].reg.orig;
         MVMJitCallArg args[] = { { MVM_JIT_INTERP_VAR, { MVM_JIT_INTERP_TC } },
@@ -2159,6 +2230,52 @@ static MVMint32 jgb_consume_ins(MVMThreadContext *tc, JitGraphBuilder *jgb,
         jgb_append_call_c(tc, jgb, op_to_func(tc, op), 5, args, MVM_JIT_RV_VOID, -1);
         break;
     }
+    case MVM_OP_continuationinvoke: {
+        MVMint16 reg  = ins->operands[0].reg.orig;
+        MVMint16 cont = ins->operands[1].reg.orig;
+        MVMint16 code = ins->operands[2].reg.orig;
+        MVMJitCallArg args[] = { { MVM_JIT_INTERP_VAR, { MVM_JIT_INTERP_TC } },
+                                 { MVM_JIT_REG_VAL, { cont } },
+                                 { MVM_JIT_REG_VAL, { code } },
+                                 { MVM_JIT_REG_ADDR, { reg } }};
+        jgb_append_call_c(tc, jgb, op_to_func(tc, op), 4, args, MVM_JIT_RV_VOID, -1);
+        break;
+    }
+    case MVM_OP_bindexmessage:
+    case MVM_OP_bindexpayload:
+    case MVM_OP_bindexcategory: {
+        MVMint16 ex    = ins->operands[0].reg.orig;
+        MVMint16 value = ins->operands[1].reg.orig;
+        MVMJitCallArg args[] = { { MVM_JIT_INTERP_VAR, { MVM_JIT_INTERP_TC } },
+                                 { MVM_JIT_REG_VAL, { ex } },
+                                 { MVM_JIT_REG_VAL, { value } } };
+        jgb_append_call_c(tc, jgb, op_to_func(tc, op), 3, args, MVM_JIT_RV_VOID, -1);
+        break;
+    }
+    case MVM_OP_exreturnafterunwind:
+    case MVM_OP_nativecallrefresh: {
+        MVMint16 obj = ins->operands[0].reg.orig;
+        MVMJitCallArg args[] = { { MVM_JIT_INTERP_VAR, { MVM_JIT_INTERP_TC } },
+                                 { MVM_JIT_REG_VAL, { obj } } };
+        jgb_append_call_c(tc, jgb, op_to_func(tc, op), 2, args, MVM_JIT_RV_VOID, -1);
+        break;
+    }
+    case MVM_OP_getexcategory:
+    case MVM_OP_nativecallsizeof: {
+        MVMint16 dst = ins->operands[0].reg.orig;
+        MVMint16 obj = ins->operands[1].reg.orig;
+        MVMJitCallArg args[] = { { MVM_JIT_INTERP_VAR, { MVM_JIT_INTERP_TC } },
+                                 { MVM_JIT_REG_VAL, { obj } } };
+        jgb_append_call_c(tc, jgb, op_to_func(tc, op), 2, args, MVM_JIT_RV_INT, dst);
+        break;
+    }
+    case MVM_OP_newexception: {
+        MVMint16 dst = ins->operands[0].reg.orig;
+        MVMJitCallArg args[] = { { MVM_JIT_INTERP_VAR, { MVM_JIT_INTERP_TC } },
+                                 { MVM_JIT_LITERAL_PTR, { (MVMint64)tc->instance->boot_types.BOOTException } } };
+        jgb_append_call_c(tc, jgb, op_to_func(tc, op), 2, args, MVM_JIT_RV_PTR, dst);
+        break;
+    }
     case MVM_OP_sp_boolify_iter: {
         MVMint16 dst = ins->operands[0].reg.orig;
         MVMint16 obj = ins->operands[1].reg.orig;
@@ -2391,7 +2508,10 @@ static MVMint32 jgb_consume_ins(MVMThreadContext *tc, JitGraphBuilder *jgb,
         }
         break;
     }
-    case MVM_OP_eqat_s: {
+    case MVM_OP_eqat_s:
+    case MVM_OP_eqatic_s:
+    case MVM_OP_eqatim_s:
+    case MVM_OP_eqaticim_s: {
         MVMint16 dst    = ins->operands[0].reg.orig;
         MVMint16 src_a  = ins->operands[1].reg.orig;
         MVMint16 src_b  = ins->operands[2].reg.orig;
@@ -2416,7 +2536,9 @@ static MVMint32 jgb_consume_ins(MVMThreadContext *tc, JitGraphBuilder *jgb,
         jgb_append_call_c(tc, jgb, op_to_func(tc, op), 2, args, rv_mode, dst);
         break;
     }
-    case MVM_OP_getcp_s: {
+    case MVM_OP_getcp_s:
+    case MVM_OP_indexcp_s:
+    case MVM_OP_ordbaseat: {
         MVMint16 dst = ins->operands[0].reg.orig;
         MVMint16 src = ins->operands[1].reg.orig;
         MVMint16 idx = ins->operands[2].reg.orig;
@@ -2426,7 +2548,71 @@ static MVMint32 jgb_consume_ins(MVMThreadContext *tc, JitGraphBuilder *jgb,
         jgb_append_call_c(tc, jgb, op_to_func(tc, op), 3, args, MVM_JIT_RV_INT, dst);
         break;
     }
-    case MVM_OP_chr: {
+    case MVM_OP_istrue_s:
+    case MVM_OP_isfalse_s:
+    case MVM_OP_getcpbyname: {
+        MVMint16 dst = ins->operands[0].reg.orig;
+        MVMint16 src = ins->operands[1].reg.orig;
+        MVMJitCallArg args[] = { { MVM_JIT_INTERP_VAR, { MVM_JIT_INTERP_TC } },
+                                 { MVM_JIT_REG_VAL, { src } } };
+        jgb_append_call_c(tc, jgb, op_to_func(tc, op), 2, args, MVM_JIT_RV_INT, dst);
+        if (op == MVM_OP_isfalse_s) {
+            /* append not_i to negate istrue_s */
+            MVMSpeshIns *not_i          = MVM_spesh_alloc(tc, jgb->sg, sizeof(MVMSpeshIns));
+            not_i->info                 = MVM_op_get_op(MVM_OP_not_i);
+            not_i->operands             = MVM_spesh_alloc(tc, jgb->sg, sizeof(MVMSpeshOperand) * 2);
+            not_i->operands[0].reg.orig = dst;
+            not_i->operands[1].reg.orig = dst;
+            jgb_append_primitive(tc, jgb, not_i);
+        }
+        break;
+    }
+    case MVM_OP_bitand_s:
+    case MVM_OP_bitor_s:
+    case MVM_OP_bitxor_s: {
+        MVMint16 dst   = ins->operands[0].reg.orig;
+        MVMint16 src_a = ins->operands[1].reg.orig;
+        MVMint16 src_b = ins->operands[2].reg.orig;
+        MVMJitCallArg args[] = { { MVM_JIT_INTERP_VAR, { MVM_JIT_INTERP_TC } },
+                                 { MVM_JIT_REG_VAL, { src_a } },
+                                 { MVM_JIT_REG_VAL, { src_b } } };
+        jgb_append_call_c(tc, jgb, op_to_func(tc, op), 3, args, MVM_JIT_RV_PTR, dst);
+        break;
+    }
+    case MVM_OP_haveat_s: {
+        MVMint16 dst        = ins->operands[0].reg.orig;
+        MVMint16 a          = ins->operands[1].reg.orig;
+        MVMint16 starta     = ins->operands[2].reg.orig;
+        MVMint16 length     = ins->operands[3].reg.orig;
+        MVMint16 b          = ins->operands[4].reg.orig;
+        MVMint16 startb     = ins->operands[5].reg.orig;
+        MVMJitCallArg args[] = { { MVM_JIT_INTERP_VAR, { MVM_JIT_INTERP_TC } },
+                                 { MVM_JIT_REG_VAL, { a } },
+                                 { MVM_JIT_REG_VAL, { starta } },
+                                 { MVM_JIT_REG_VAL, { length } },
+                                 { MVM_JIT_REG_VAL, { b } },
+                                 { MVM_JIT_REG_VAL, { startb } } };
+        jgb_append_call_c(tc, jgb, op_to_func(tc, op), 6, args, MVM_JIT_RV_INT, dst);
+        break;
+    }
+    case MVM_OP_unicmp_s: {
+        MVMint16 dst     = ins->operands[0].reg.orig;
+        MVMint16 a       = ins->operands[1].reg.orig;
+        MVMint16 b       = ins->operands[2].reg.orig;
+        MVMint16 mode    = ins->operands[3].reg.orig;
+        MVMint16 lang    = ins->operands[4].reg.orig;
+        MVMint16 country = ins->operands[5].reg.orig;
+        MVMJitCallArg args[] = { { MVM_JIT_INTERP_VAR, { MVM_JIT_INTERP_TC } },
+                                 { MVM_JIT_REG_VAL, { a } },
+                                 { MVM_JIT_REG_VAL, { b } },
+                                 { MVM_JIT_REG_VAL, { mode } },
+                                 { MVM_JIT_REG_VAL, { lang } },
+                                 { MVM_JIT_REG_VAL, { country } } };
+        jgb_append_call_c(tc, jgb, op_to_func(tc, op), 6, args, MVM_JIT_RV_INT, dst);
+        break;
+    }
+    case MVM_OP_chr:
+    case MVM_OP_getuniname: {
         MVMint16 dst = ins->operands[0].reg.orig;
         MVMint16 src = ins->operands[1].reg.orig;
         MVMJitCallArg args[] = { { MVM_JIT_INTERP_VAR, { MVM_JIT_INTERP_TC } },
@@ -2470,7 +2656,11 @@ static MVMint32 jgb_consume_ins(MVMThreadContext *tc, JitGraphBuilder *jgb,
         jgb_append_call_c(tc, jgb, op_to_func(tc, op), 4, args, MVM_JIT_RV_PTR, dst);
         break;
     }
-    case MVM_OP_index_s: {
+    case MVM_OP_index_s:
+    case MVM_OP_indexic_s:
+    case MVM_OP_indexim_s:
+    case MVM_OP_indexicim_s:
+    case MVM_OP_rindexfrom: {
         MVMint16 dst = ins->operands[0].reg.orig;
         MVMint16 haystack = ins->operands[1].reg.orig;
         MVMint16 needle = ins->operands[2].reg.orig;
@@ -2813,6 +3003,37 @@ static MVMint32 jgb_consume_ins(MVMThreadContext *tc, JitGraphBuilder *jgb,
                           MVM_JIT_RV_PTR, dst);
         break;
     }
+    case MVM_OP_nativecallbuild: {
+        MVMint16 site     = ins->operands[0].reg.orig;
+        MVMint16 lib      = ins->operands[1].reg.orig;
+        MVMint16 sym      = ins->operands[2].reg.orig;
+        MVMint16 conv     = ins->operands[3].reg.orig;
+        MVMint16 arg_info = ins->operands[4].reg.orig;
+        MVMint16 ret_info = ins->operands[5].reg.orig;
+        MVMJitCallArg args[] = { { MVM_JIT_INTERP_VAR, { MVM_JIT_INTERP_TC } },
+                                 { MVM_JIT_REG_VAL, { site } },
+                                 { MVM_JIT_REG_VAL, { lib } },
+                                 { MVM_JIT_REG_VAL, { sym } },
+                                 { MVM_JIT_REG_VAL, { conv } },
+                                 { MVM_JIT_REG_VAL, { arg_info } },
+                                 { MVM_JIT_REG_VAL, { ret_info } } };
+        jgb_append_call_c(tc, jgb, op_to_func(tc, op), 7, args, MVM_JIT_RV_VOID, -1);
+        break;
+    }
+    case MVM_OP_nativecallglobal: {
+        MVMint16 dst    = ins->operands[0].reg.orig;
+        MVMint16 lib    = ins->operands[1].reg.orig;
+        MVMint16 sym    = ins->operands[2].reg.orig;
+        MVMint16 target = ins->operands[3].reg.orig;
+        MVMint16 type   = ins->operands[4].reg.orig;
+        MVMJitCallArg args[] = { { MVM_JIT_INTERP_VAR, { MVM_JIT_INTERP_TC } },
+                                 { MVM_JIT_REG_VAL, { lib } },
+                                 { MVM_JIT_REG_VAL, { sym } },
+                                 { MVM_JIT_REG_VAL, { target } },
+                                 { MVM_JIT_REG_VAL, { type } } };
+        jgb_append_call_c(tc, jgb, op_to_func(tc, op), 5, args, MVM_JIT_RV_PTR, dst);
+        break;
+    }
     case MVM_OP_nativecallinvoke: {
         MVMint16 dst     = ins->operands[0].reg.orig;
         MVMint16 restype = ins->operands[1].reg.orig;
@@ -3029,6 +3250,7 @@ static MVMint32 jgb_consume_ins(MVMThreadContext *tc, JitGraphBuilder *jgb,
         }
         if (!emitted_extop) {
             MVM_jit_log(tc, "BAIL: op <%s>\n", ins->info->name);
+            MVM_jit_count_bail(tc, ins);
             return 0;
         }
     }
@@ -3050,6 +3272,21 @@ static MVMint32 jgb_consume_bb(MVMThreadContext *tc, JitGraphBuilder *jgb,
     jgb_append_control(tc, jgb, bb->first_ins, MVM_JIT_CONTROL_DYNAMIC_LABEL);
     jgb->cur_ins = bb->first_ins;
     while (jgb->cur_ins) {
+        /* Compile runs of simple integer ops in machine registers. The run
+         * may only carry annotations before its first and after its last
+         * instruction, so those are handled as for single instructions. */
+        MVMint32 run_length = tc->instance->jit_expr_enabled
+            ? MVM_jit_expr_run_length(tc, jgb->sg, jgb->cur_ins) : 0;
+        if (run_length) {
+            MVMint32 i;
+            jgb_before_ins(tc, jgb, jgb->cur_bb, jgb->cur_ins);
+            jgb_append_expr(tc, jgb, jgb->cur_ins, run_length);
+            for (i = 1; i < run_length; i++)
+                jgb->cur_ins = jgb->cur_ins->next;
+            jgb_after_ins(tc, jgb, jgb->cur_bb, jgb->cur_ins);
+            jgb->cur_ins = jgb->cur_ins->next;
+            continue;
+        }
         jgb_before_ins(tc, jgb, jgb->cur_bb, jgb->cur_ins);
         if(!jgb_consume_ins(tc, jgb, jgb->cur_bb, jgb->cur_ins))
             return 0;
@@ -0,0 +1,317 @@
+#include "moar.h"
+#include "platform/mmap.h"
+
+static size_t align_size(size_t size) {
+    return (size + MVM_JIT_HEAP_ALIGN - 1) & ~(size_t)(MVM_JIT_HEAP_ALIGN - 1);
+}
+
+static size_t page_align_size(size_t size) {
+    size_t page_size = MVM_platform_page_size();
+    return (size + page_size - 1) & ~(page_size - 1);
+}
+
+/* Maps a new chunk big enough for the given size and makes it the one we
+ * allocate from. Returns NULL if we couldn't map it executable the way the
+ * heap is configured to. */
+static MVMJitHeapChunk * new_chunk(MVMThreadContext *tc, MVMJitHeap *heap, size_t size) {
+    MVMJitHeapChunk *chunk;
+    size_t chunk_size = size <= MVM_JIT_HEAP_CHUNK_SIZE
+        ? MVM_JIT_HEAP_CHUNK_SIZE
+        : (size + MVM_JIT_HEAP_CHUNK_SIZE - 1) & ~(size_t)(MVM_JIT_HEAP_CHUNK_SIZE - 1);
+    void *code;
+    char *writable;
+    if (heap->allow_rwx) {
+        writable = MVM_platform_alloc_pages(chunk_size, MVM_PAGE_READ|MVM_PAGE_WRITE);
+        if (!writable)
+            return NULL;
+        if (!MVM_platform_set_page_mode(writable, chunk_size,
+                MVM_PAGE_READ|MVM_PAGE_WRITE|MVM_PAGE_EXEC)) {
+            MVM_platform_free_pages(writable, chunk_size);
+            return NULL;
+        }
+        code = writable;
+    }
+    else {
+        writable = MVM_platform_alloc_dual_pages(chunk_size, &code);
+        if (!writable)
+            return NULL;
+    }
+    chunk           = MVM_malloc(sizeof(MVMJitHeapChunk));
+    chunk->code     = code;
+    chunk->writable = writable;
+    chunk->size     = chunk_size;
+    chunk->used     = 0;
+    chunk->live     = 0;
+    chunk->next     = heap->chunks;
+    heap->chunks    = chunk;
+    heap->mapped_bytes += chunk_size;
+    heap->num_chunks++;
+    MVM_jit_log(tc, "JIT heap: mapped chunk of %"MVM_PRSz" bytes at %p\n",
+        chunk_size, code);
+    return chunk;
+}
+
+static void unmap_chunk(MVMJitHeapChunk *chunk) {
+    if (chunk->code == chunk->writable)
+        MVM_platform_free_pages(chunk->code, chunk->size);
+    else
+        MVM_platform_free_dual_pages(chunk->writable, chunk->code, chunk->size);
+}
+
+/* Adds a block to the free list, keeping it sorted and merging it with
+ * free neighbours in the same chunk. Returns the (possibly merged) block
+ * and its predecessor in the list. */
+static MVMJitHeapBlock * add_free_block(MVMJitHeap *heap, MVMJitHeapChunk *chunk,
+                                        char *start, size_t size, MVMJitHeapBlock **prev_out) {
+    MVMJitHeapBlock *prev = NULL, *next = heap->free_list, *block;
+    while (next && next->start < start) {
+        prev = next;
+        next = next->next;
+    }
+    heap->free_bytes += size;
+    if (prev && prev->chunk == chunk && prev->start + prev->size == start) {
+        block = prev;
+        block->size += size;
+        prev = NULL;
+        /* Find the block before the one we grew. */
+        if (heap->free_list != block) {
+            prev = heap->free_list;
+            while (prev->next != block)
+                prev = prev->next;
+        }
+    }
+    else {
+        block        = MVM_malloc(sizeof(MVMJitHeapBlock));
+        block->start = start;
+        block->size  = size;
+        block->chunk = chunk;
+        block->next  = next;
+        if (prev)
+            prev->next = block;
+        else
+            heap->free_list = block;
+    }
+    if (next && next->chunk == chunk && block->start + block->size == next->start) {
+        block->size += next->size;
+        block->next  = next->next;
+        MVM_free(next);
+    }
+    *prev_out = prev;
+    return block;
+}
+
+static void unlink_free_block(MVMJitHeap *heap, MVMJitHeapBlock *prev, MVMJitHeapBlock *block) {
+    if (prev)
+        prev->next = block->next;
+    else
+        heap->free_list = block->next;
+    heap->free_bytes -= block->size;
+    MVM_free(block);
+}
+
+/* Drops all free blocks of a chunk that has no live code left in it. */
+static void drop_free_blocks(MVMJitHeap *heap, MVMJitHeapChunk *chunk) {
+    MVMJitHeapBlock *prev = NULL, *block = heap->free_list;
+    while (block) {
+        MVMJitHeapBlock *next = block->next;
+        if (block->chunk == chunk)
+            unlink_free_block(heap, prev, block);
+        else
+            prev = block;
+        block = next;
+    }
+}
+
+/* Allocates memory for a piece of code of the given size. Returns the address
+ * the code will run from, and puts the address it must be written to in
+ * writable; once it is, MVM_jit_heap_seal must be called on it. Returns NULL
+ * if we can't get executable memory at all. */
+void * MVM_jit_heap_alloc(MVMThreadContext *tc, size_t size, void **writable) {
+    MVMJitHeap      *heap = tc->instance->jit_heap;
+    MVMJitHeapChunk *chunk;
+    MVMJitHeapBlock *prev, *block;
+    size_t           alloc_size = align_size(size);
+    char            *memory;
+
+    uv_mutex_lock(&heap->mutex);
+    if (heap->mode == MVM_JIT_HEAP_UNKNOWN) {
+        if (new_chunk(tc, heap, alloc_size)) {
+            heap->mode = heap->allow_rwx ? MVM_JIT_HEAP_RWX : MVM_JIT_HEAP_DUAL;
+        }
+        else {
+            MVM_jit_log(tc, "JIT heap: can't map shared code chunks; using a mapping per frame\n");
+            heap->mode = MVM_JIT_HEAP_PAGES;
+        }
+    }
+    if (heap->mode == MVM_JIT_HEAP_PAGES) {
+        size_t map_size = page_align_size(size);
+        memory = MVM_platform_alloc_pages(map_size, MVM_PAGE_READ|MVM_PAGE_WRITE);
+        if (memory) {
+            heap->mapped_bytes += map_size;
+            heap->code_bytes   += size;
+            heap->num_codes++;
+        }
+        uv_mutex_unlock(&heap->mutex);
+        *writable = memory;
+        return memory;
+    }
+
+    /* First fit from the free list. */
+    prev  = NULL;
+    block = heap->free_list;
+    while (block && block->size < alloc_size) {
+        prev  = block;
+        block = block->next;
+    }
+    if (block) {
+        memory = block->start;
+        chunk  = block->chunk;
+        if (block->size == alloc_size) {
+            unlink_free_block(heap, prev, block);
+        }
+        else {
+            block->start     += alloc_size;
+            block->size      -= alloc_size;
+            heap->free_bytes -= alloc_size;
+        }
+    }
+    else {
+        /* Otherwise bump allocate, giving the rest of the current chunk to
+         * the free list if we need a new one. */
+        chunk = heap->chunks;
+        if (chunk->size - chunk->used < alloc_size) {
+            if (chunk->used < chunk->size)
+                add_free_block(heap, chunk, chunk->code + chunk->used,
+                    chunk->size - chunk->used, &prev);
+            chunk->used = chunk->size;
+            chunk = new_chunk(tc, heap, alloc_size);
+            if (!chunk) {
+                uv_mutex_unlock(&heap->mutex);
+                MVM_jit_log(tc, "JIT heap: failed to map another chunk\n");
+                return NULL;
+            }
+        }
+        memory = chunk->code + chunk->used;
+        chunk->used += alloc_size;
+    }
+    chunk->live      += alloc_size;
+    heap->code_bytes += alloc_size;
+    heap->num_codes++;
+    uv_mutex_unlock(&heap->mutex);
+    *writable = chunk->writable + (memory - chunk->code);
+    return memory;
+}
+
+/* Makes freshly written code executable. Code in a chunk already is, through
+ * the chunk's executable view. Returns 0 if that was denied. */
+MVMint32 MVM_jit_heap_seal(MVMThreadContext *tc, void *memory, size_t size) {
+    if (tc->instance->jit_heap->mode == MVM_JIT_HEAP_PAGES)
+        return MVM_platform_set_page_mode(memory, page_align_size(size),
+            MVM_PAGE_READ|MVM_PAGE_EXEC);
+    return 1;
+}
+
+/* Frees the memory of code that can no longer run. A chunk with no code
+ * left in it is unmapped, unless it's the one we're allocating from, in
+ * which case it's just reset. */
+void MVM_jit_heap_free(MVMThreadContext *tc, void *memory, size_t size) {
+    MVMJitHeap      *heap = tc->instance->jit_heap;
+    MVMJitHeapChunk *chunk, *prev_chunk = NULL;
+    MVMJitHeapBlock *prev, *block;
+    size_t           alloc_size = align_size(size);
+
+    uv_mutex_lock(&heap->mutex);
+    if (heap->mode == MVM_JIT_HEAP_PAGES) {
+        size_t map_size = page_align_size(size);
+        heap->mapped_bytes -= map_size;
+        heap->code_bytes   -= size;
+        heap->num_codes--;
+        uv_mutex_unlock(&heap->mutex);
+        MVM_platform_free_pages(memory, map_size);
+        return;
+    }
+
+    chunk = heap->chunks;
+    while (chunk && !((char *)memory >= chunk->code &&
+                      (char *)memory <  chunk->code + chunk->size)) {
+        prev_chunk = chunk;
+        chunk      = chunk->next;
+    }
+    if (!chunk) {
+        uv_mutex_unlock(&heap->mutex);
+        MVM_oops(tc, "JIT heap: freeing code at %p that isn't in any chunk", memory);
+    }
+    chunk->live      -= alloc_size;
+    heap->code_bytes -= alloc_size;
+    heap->num_codes--;
+
+    if (chunk->live == 0) {
+        drop_free_blocks(heap, chunk);
+        if (chunk == heap->chunks) {
+            chunk->used = 0;
+        }
+        else {
+            prev_chunk->next = chunk->next;
+            heap->mapped_bytes -= chunk->size;
+            heap->num_chunks--;
+            unmap_chunk(chunk);
+            MVM_free(chunk);
+        }
+    }
+    else {
+        block = add_free_block(heap, chunk, memory, alloc_size, &prev);
+        /* Space at the end of the chunk we're allocating from goes back to
+         * the bump pointer. */
+        if (chunk == heap->chunks && block->start + block->size == chunk->code + chunk->used) {
+            chunk->used -= block->size;
+            unlink_free_block(heap, prev, block);
+        }
+    }
+    uv_mutex_unlock(&heap->mutex);
+}
+
+/* Returns a hash describing the memory used by JIT compiled code. */
+MVMObject * MVM_jit_heap_stats(MVMThreadContext *tc) {
+    MVMJitHeap   *heap = tc->instance->jit_heap;
+    MVMHLLConfig *hll  = MVM_hll_current(tc);
+    MVMObject    *result;
+    MVMint64      pooled, chunks, frames, mapped_bytes, code_bytes, free_bytes;
+    uv_mutex_lock(&heap->mutex);
+    pooled       = heap->mode == MVM_JIT_HEAP_DUAL || heap->mode == MVM_JIT_HEAP_RWX;
+    chunks       = heap->num_chunks;
+    frames       = heap->num_codes;
+    mapped_bytes = heap->mapped_bytes;
+    code_bytes   = heap->code_bytes;
+    free_bytes   = heap->free_bytes;
+    uv_mutex_unlock(&heap->mutex);
+    MVM_gc_allocate_gen2_default_set(tc);
+    result = MVM_repr_alloc_init(tc, hll->slurpy_hash_type);
+    MVM_repr_bind_stat(tc, result, "pooled", pooled);
+    MVM_repr_bind_stat(tc, result, "chunks", chunks);
+    MVM_repr_bind_stat(tc, result, "frames", frames);
+    MVM_repr_bind_stat(tc, result, "mapped_bytes", mapped_bytes);
+    MVM_repr_bind_stat(tc, result, "code_bytes", code_bytes);
+    MVM_repr_bind_stat(tc, result, "free_bytes", free_bytes);
+    MVM_gc_allocate_gen2_default_clear(tc);
+    return result;
+}
+
+void MVM_jit_heap_destroy(MVMInstance *instance) {
+    MVMJitHeap      *heap  = instance->jit_heap;
+    MVMJitHeapChunk *chunk = heap->chunks;
+    MVMJitHeapBlock *block = heap->free_list;
+    while (block) {
+        MVMJitHeapBlock *next = block->next;
+        MVM_free(block);
+        block = next;
+    }
+    while (chunk) {
+        MVMJitHeapChunk *next = chunk->next;
+        unmap_chunk(chunk);
+        MVM_free(chunk);
+        chunk = next;
+    }
+    uv_mutex_destroy(&heap->mutex);
+    MVM_free(heap);
+    instance->jit_heap = NULL;
+}
@@ -0,0 +1,70 @@
+/* The JIT code heap packs compiled frames into shared executable chunks,
+ * rather than giving each its own mapping. Each chunk is mapped twice, so
+ * that new code is written through a writable view while the code next to
+ * it, which may be running on another thread, is executed from a separate
+ * view that is never writable. If the platform won't let us do that, we
+ * fall back to a mapping per frame that is made executable once the code
+ * is written, unless chunks that are writable and executable at once have
+ * been explicitly allowed with MVM_JIT_RWX. */
+
+/* Size of a chunk; code that doesn't fit gets a chunk of its own, rounded
+ * up to a multiple of this. Kept a multiple of the allocation granularity
+ * on Windows. */
+#define MVM_JIT_HEAP_CHUNK_SIZE 262144
+
+/* Alignment of each piece of code in a chunk. */
+#define MVM_JIT_HEAP_ALIGN 16
+
+/* Whether we've yet to try mapping a chunk, and if so how we ended up
+ * mapping code. */
+#define MVM_JIT_HEAP_UNKNOWN 0
+#define MVM_JIT_HEAP_DUAL    1
+#define MVM_JIT_HEAP_RWX     2
+#define MVM_JIT_HEAP_PAGES   3
+
+struct MVMJitHeapChunk {
+    /* Where the code runs from, and where it's written to; the same in
+     * MVM_JIT_HEAP_RWX mode. */
+    char            *code;
+    char            *writable;
+    size_t           size;
+    /* Everything below this offset has been handed out at some point; free
+     * blocks are only ever below it. */
+    size_t           used;
+    /* Bytes of live code in the chunk. */
+    size_t           live;
+    MVMJitHeapChunk *next;
+};
+
+/* A free block within a chunk, by its executable address. The free list is
+ * sorted by address, so we can coalesce neighbours. */
+struct MVMJitHeapBlock {
+    char            *start;
+    size_t           size;
+    MVMJitHeapChunk *chunk;
+    MVMJitHeapBlock *next;
+};
+
+struct MVMJitHeap {
+    uv_mutex_t       mutex;
+    MVMint32         mode;
+    /* Set from MVM_JIT_RWX to map chunks writable and executable at once,
+     * rather than twice. */
+    MVMint32         allow_rwx;
+    /* The first chunk is the one we bump allocate from. */
+    MVMJitHeapChunk *chunks;
+    MVMJitHeapBlock *free_list;
+
+    /* Statistics. */
+    MVMuint64        mapped_bytes;
+    MVMuint64        code_bytes;
+    MVMuint64        free_bytes;
+    MVMuint32        num_chunks;
+    MVMuint32        num_codes;
+};
+
+void * MVM_jit_heap_alloc(MVMThreadContext *tc, size_t size, void **writable);
+MVMint32 MVM_jit_heap_seal(MVMThreadContext *tc, void *memory, size_t size);
+void MVM_jit_heap_free(MVMThreadContext *tc, void *memory, size_t size);
+MVMObject * MVM_jit_heap_stats(MVMThreadContext *tc);
+void MVM_jit_heap_destroy(MVMInstance *instance);
@@ -35,3 +35,66 @@ void MVM_jit_log_bytecode(MVMThreadContext *tc, MVMJitCode *code) {
     }
     MVM_free(filename);
 }
+
+/* Writes an entry for a compiled frame to the perf map, so profilers such
+ * as perf can attribute samples in the code to the routine it came from. */
+void MVM_jit_log_perf_map(MVMThreadContext *tc, MVMJitCode *code) {
+    MVMStaticFrame        *sf  = code->sf;
+    MVMCompUnit           *cu  = sf->body.cu;
+    MVMBytecodeAnnotation *ann = MVM_bytecode_resolve_annotation(tc, &sf->body, 0);
+    MVMString *file_str = ann && ann->filename_string_heap_index < cu->body.num_strings
+        ? MVM_cu_string(tc, cu, ann->filename_string_heap_index)
+        : cu->body.filename;
+    char *name = MVM_string_utf8_encode_C_string(tc, sf->body.name);
+    char *file = file_str ? MVM_string_utf8_encode_C_string(tc, file_str) : NULL;
+    fprintf(tc->instance->jit_perf_map, "%"PRIx64" %"PRIx64" %s %s:%"PRIu32"\n",
+        (MVMuint64)(uintptr_t)code->func_ptr, (MVMuint64)code->size,
+        name[0] ? name : "<anon>", file ? file : "<unknown>",
+        ann ? ann->line_number : 1);
+    fflush(tc->instance->jit_perf_map);
+    MVM_free(name);
+    MVM_free(file);
+    MVM_free(ann);
+}
+
+/* Records that a frame was refused by the JIT because of the given
+ * instruction. */
+void MVM_jit_count_bail(MVMThreadContext *tc, MVMSpeshIns *ins) {
+    MVMuint16 opcode = ins->info->opcode;
+    MVM_incr(&tc->instance->jit_bail_counts[opcode < MVM_OP_EXT_BASE ? opcode : MVM_OP_EXT_BASE]);
+}
+
+static const char * bail_name(MVMuint16 i) {
+    return i == MVM_OP_EXT_BASE ? "extop" : MVM_op_get_op(i)->name;
+}
+
+/* Writes the bail census to the JIT log, if there is one. */
+void MVM_jit_log_bail_census(MVMInstance *instance) {
+    MVMuint16 i;
+    if (!instance->jit_log_fh)
+        return;
+    for (i = 0; i <= MVM_OP_EXT_BASE; i++) {
+        AO_t count = MVM_load(&instance->jit_bail_counts[i]);
+        if (count && (i == MVM_OP_EXT_BASE || MVM_op_get_op(i)))
+            fprintf(instance->jit_log_fh, "BAIL CENSUS: <%s> %"PRIu64"\n",
+                bail_name(i), (MVMuint64)count);
+    }
+}
+
+/* Returns a hash of op name to the number of frames the JIT refused to
+ * compile because of that op. */
+MVMObject * MVM_jit_bail_census(MVMThreadContext *tc) {
+    MVMInstance  *instance = tc->instance;
+    MVMHLLConfig *hll      = MVM_hll_current(tc);
+    MVMObject    *result;
+    MVMuint16     i;
+    MVM_gc_allocate_gen2_default_set(tc);
+    result = MVM_repr_alloc_init(tc, hll->slurpy_hash_type);
+    for (i = 0; i <= MVM_OP_EXT_BASE; i++) {
+        AO_t count = MVM_load(&instance->jit_bail_counts[i]);
+        if (count && (i == MVM_OP_EXT_BASE || MVM_op_get_op(i)))
+            MVM_repr_bind_stat(tc, result, bail_name(i), (MVMint64)count);
+    }
+    MVM_gc_allocate_gen2_default_clear(tc);
+    return result;
+}
@@ -1,2 +1,6 @@
 void MVM_jit_log(MVMThreadContext *tc, const char *fmt, ...) MVM_FORMAT(printf, 2, 3);
 void MVM_jit_log_bytecode(MVMThreadContext *tc, MVMJitCode *code);
+void MVM_jit_log_perf_map(MVMThreadContext *tc, MVMJitCode *code);
+void MVM_jit_count_bail(MVMThreadContext *tc, MVMSpeshIns *ins);
+void MVM_jit_log_bail_census(MVMInstance *instance);
+MVMObject * MVM_jit_bail_census(MVMThreadContext *tc);
@@ -1,5 +1,6 @@
 #include "moar.h"
 #include <platform/threads.h>
+#include <errno.h>
 
 #if defined(_MSC_VER)
 #define snprintf _snprintf
@@ -70,18 +71,69 @@ static FILE *fopen_perhaps_with_pid(char *path, const char *mode) {
     }
 }
 
+/* Reads a nursery size, in bytes, from an environment variable. One that
+ * isn't a number is ignored, and one too big is clamped, with a warning. */
+static MVMuint32 nursery_size_from_env(const char *name, MVMuint32 default_size) {
+    char *value = getenv(name);
+    char *end;
+    unsigned long long size;
+    if (!value || !value[0])
+        return default_size;
+    size = strtoull(value, &end, 10);
+    if (*end || value[0] == '-') {
+        fprintf(stderr, "MoarVM: ignoring %s, which is not a size in bytes\n", name);
+        return default_size;
+    }
+    if (size > MVM_NURSERY_SIZE_HIGHEST) {
+        fprintf(stderr, "MoarVM: %s is too big; using %u\n", name,
+            (unsigned)MVM_NURSERY_SIZE_HIGHEST);
+        return MVM_NURSERY_SIZE_HIGHEST;
+    }
+    return (MVMuint32)size;
+}
+
+/* Reads an integer setting from an environment variable. One that isn't a
+ * number of at least the given minimum is ignored with a warning, and one
+ * above the given maximum is clamped to it. */
+static MVMint64 int_from_env(const char *name, MVMint64 min, MVMint64 max,
+                             MVMint64 default_value) {
+    char *value = getenv(name);
+    char *end;
+    long parsed;
+    if (!value || !value[0])
+        return default_value;
+    errno  = 0;
+    parsed = strtol(value, &end, 10);
+    if (*end || errno || parsed < min) {
+        fprintf(stderr, "MoarVM: ignoring %s, which must be a whole number of at least %"PRId64"\n",
+            name, min);
+        return default_value;
+    }
+    return parsed > max ? max : parsed;
+}
+
 /* Create a new instance of the VM. */
 MVMInstance * MVM_vm_create_instance(void) {
     MVMInstance *instance;
     char *spesh_log, *spesh_nodelay, *spesh_disable, *spesh_inline_disable,
-         *spesh_osr_disable, *spesh_limit, *spesh_blocking;
-    char *jit_log, *jit_disable, *jit_bytecode_dir;
-    char *dynvar_log;
+         *spesh_osr_disable, *spesh_limit, *spesh_blocking, *spesh_workers, *spesh_cache,
+         *spesh_osr_threshold, *spesh_type_tuple_percent,
+         *spesh_adaptive;
+    char *jit_log, *jit_disable, *jit_expr_disable, *jit_bytecode_dir, *jit_perf_map,
+         *jit_rwx;
+    char *dynvar_log, *gc_incremental, *gc_compact, *gc_page_release_idle,
+         *gc_stats;
     int init_stat;
 
     /* Set up instance data structure. */
     instance = MVM_calloc(1, sizeof(MVMInstance));
 
+    /* Set the bounds within which each thread's nursery size is adapted;
+     * these must be in place before we create the first thread context. */
+    MVM_vm_set_nursery_size(instance,
+        nursery_size_from_env("MVM_GC_NURSERY_MIN", MVM_NURSERY_SIZE_MIN),
+        nursery_size_from_env("MVM_GC_NURSERY_MAX", MVM_NURSERY_SIZE_MAX));
+
     /* Create the main thread's ThreadContext and stash it. */
     instance->main_thread = MVM_tc_create(NULL, instance);
     instance->main_thread->thread_id = 1;
@@ -101,6 +153,31 @@ MVMInstance * MVM_vm_create_instance(void) {
     init_cond(instance->cond_gc_start, "GC start");
     init_cond(instance->cond_gc_finish, "GC finish");
     init_cond(instance->cond_gc_intrays_clearing, "GC intrays clearing");
+    init_mutex(instance->mutex_gc_steal_pool, "GC steal pool");
+
+    /* Should we mark gen2 incrementally, to keep full collection pauses
+     * short? */
+    gc_incremental = getenv("MVM_GC_INCREMENTAL");
+    if (gc_incremental && gc_incremental[0])
+        instance->gc_incremental = 1;
+
+    /* Should we compact gen2 after full collections, so that memory can be
+     * given back after a spike in its use? */
+    gc_compact = getenv("MVM_GC_COMPACT");
+    if (gc_compact && gc_compact[0])
+        instance->gc_compact = 1;
+
+    /* How long should a size class go without needing more memory before
+     * its free pages are given back? */
+    gc_page_release_idle = getenv("MVM_GC_PAGE_RELEASE_IDLE");
+    instance->gc_page_release_idle = gc_page_release_idle && gc_page_release_idle[0]
+        ? strtoul(gc_page_release_idle, NULL, 10)
+        : MVM_GC_PAGE_RELEASE_IDLE;
+
+    /* Should GC statistics be dumped every so many GC runs? */
+    gc_stats = getenv("MVM_GC_STATS");
+    if (gc_stats && gc_stats[0])
+        instance->gc_stats_interval = strtoul(gc_stats, NULL, 10);
 
     /* Create fixed size allocator. */
     instance->fsa = MVM_fixed_size_create(instance->main_thread);
@@ -217,6 +294,31 @@ MVMInstance * MVM_vm_create_instance(void) {
         instance->spesh_nodelay = 1;
     }
 
+    /* How eager should we be to specialize? The thresholds can be scaled by
+     * a percentage (lower for short-running programs, higher for long-running
+     * ones), and optionally adapted to how busy the specialization worker is
+     * at runtime. */
+    instance->spesh_threshold_scale = (MVMuint32)int_from_env("MVM_SPESH_THRESHOLD",
+        1, UINT32_MAX, 100);
+    spesh_osr_threshold = getenv("MVM_SPESH_OSR_THRESHOLD");
+    instance->spesh_osr_threshold = spesh_osr_threshold && spesh_osr_threshold[0]
+        ? atoi(spesh_osr_threshold)
+        : MVM_SPESH_PLAN_MIN_OSR;
+    spesh_type_tuple_percent = getenv("MVM_SPESH_TYPE_TUPLE_PERCENT");
+    instance->spesh_type_tuple_percent = spesh_type_tuple_percent && spesh_type_tuple_percent[0]
+        ? atoi(spesh_type_tuple_percent)
+        : MVM_SPESH_PLAN_TT_OBS_PERCENT;
+    spesh_adaptive = getenv("MVM_SPESH_ADAPTIVE");
+    if (spesh_adaptive && spesh_adaptive[0])
+        instance->spesh_threshold_adaptive = 1;
+    MVM_store(&instance->spesh_threshold_adapt, 100);
+
+    /* How much memory may specialization statistics use before those of the
+     * frames that were updated least recently are thrown away? */
+    instance->spesh_stats_budget = (size_t)int_from_env("MVM_SPESH_STATS_BUDGET",
+        0, (MVMint64)(SIZE_MAX / (1024 * 1024)),
+        MVM_SPESH_STATS_DEFAULT_BUDGET / (1024 * 1024)) * 1024 * 1024;
+
     /* Should we limit the number of specialized frames produced? (This is
      * mostly useful for building spesh bug bisect tools.) */
     spesh_limit = getenv("MVM_SPESH_LIMIT");
@@ -234,6 +336,9 @@ MVMInstance * MVM_vm_create_instance(void) {
     jit_disable = getenv("MVM_JIT_DISABLE");
     if (!jit_disable || !jit_disable[0])
         instance->jit_enabled = 1;
+    jit_expr_disable = getenv("MVM_JIT_EXPR_DISABLE");
+    if (!jit_expr_disable || !jit_expr_disable[0])
+        instance->jit_expr_enabled = 1;
     jit_log = getenv("MVM_JIT_LOG");
     if (jit_log && jit_log[0])
         instance->jit_log_fh = fopen_perhaps_with_pid(jit_log, "w");
@@ -245,12 +350,38 @@ MVMInstance * MVM_vm_create_instance(void) {
         instance->jit_bytecode_dir = jit_bytecode_dir;
         MVM_free(bytecode_map_name);
     }
+    jit_perf_map = getenv("MVM_JIT_PERF_MAP");
+    if (jit_perf_map && jit_perf_map[0])
+        instance->jit_perf_map = fopen_perhaps_with_pid("/tmp/perf-%d.map", "w");
     instance->jit_seq_nr = 0;
+    instance->jit_bail_counts = MVM_calloc(MVM_OP_EXT_BASE + 1, sizeof(AO_t));
+    instance->jit_heap = MVM_calloc(1, sizeof(MVMJitHeap));
+    init_mutex(instance->jit_heap->mutex, "JIT heap");
+    jit_rwx = getenv("MVM_JIT_RWX");
+    if (jit_rwx && jit_rwx[0])
+        instance->jit_heap->allow_rwx = 1;
 
     /* Spesh thread syncing. */
     init_mutex(instance->mutex_spesh_sync, "spesh sync");
     init_cond(instance->cond_spesh_sync, "spesh sync");
 
+    /* How many specialization workers should there be? By default, we use a
+     * quarter of the CPUs, up to 4. We only use one if logging spesh or JIT
+     * work, since the logs would be interleaved otherwise. */
+    spesh_workers = getenv("MVM_SPESH_WORKERS");
+    if (spesh_workers && spesh_workers[0]) {
+        int workers = atoi(spesh_workers);
+        instance->spesh_workers = workers > 1 ? workers : 1;
+    }
+    else {
+        MVMuint32 workers = MVM_platform_cpu_count() / 4;
+        instance->spesh_workers = workers > 4 ? 4 : workers > 1 ? workers : 1;
+    }
+    if (instance->spesh_log_fh || instance->jit_log_fh)
+        instance->spesh_workers = 1;
+    init_mutex(instance->mutex_spesh_plan, "spesh plan");
+    init_cond(instance->cond_spesh_plan, "spesh plan");
+
     /* Various kinds of debugging that can be enabled. */
     dynvar_log = getenv("MVM_DYNVAR_LOG");
     if (dynvar_log && dynvar_log[0]) {
@@ -297,6 +428,11 @@ MVMInstance * MVM_vm_create_instance(void) {
     /* Create std[in/out/err]. */
     setup_std_handles(instance->main_thread);
 
+    /* Load the persistent specialization cache, if we're to use one. */
+    spesh_cache = getenv("MVM_SPESH_CACHE");
+    if (instance->spesh_enabled && spesh_cache && spesh_cache[0])
+        MVM_spesh_cache_load(instance->main_thread, spesh_cache);
+
     /* Set up the specialization worker thread and a log for the main thread. */
     MVM_spesh_worker_setup(instance->main_thread);
     MVM_spesh_log_initialize_thread(instance->main_thread, 1);
@@ -389,13 +525,20 @@ void MVM_vm_exit(MVMInstance *instance) {
     /* Join any foreground threads. */
     MVM_thread_join_foreground(instance->main_thread);
 
+    /* Save any persistent specialization cache. */
+    MVM_spesh_cache_save(instance);
+
     /* Close any spesh or jit log. */
     if (instance->spesh_log_fh)
         fclose(instance->spesh_log_fh);
-    if (instance->jit_log_fh)
+    if (instance->jit_log_fh) {
+        MVM_jit_log_bail_census(instance);
         fclose(instance->jit_log_fh);
+    }
     if (instance->jit_bytecode_map)
         fclose(instance->jit_bytecode_map);
+    if (instance->jit_perf_map)
+        fclose(instance->jit_perf_map);
     if (instance->dynvar_log_fh) {
         fprintf(instance->dynvar_log_fh, "- x 0 0 0 0 %"PRId64" %"PRIu64" %"PRIu64"\n", instance->dynvar_log_lasttime, uv_hrtime(), uv_hrtime());
         fclose(instance->dynvar_log_fh);
@@ -438,6 +581,9 @@ void MVM_vm_destroy_instance(MVMInstance *instance) {
     /* Join any foreground threads. */
     MVM_thread_join_foreground(instance->main_thread);
 
+    /* Save any persistent specialization cache. */
+    MVM_spesh_cache_save(instance);
+
     /* Run the GC global destruction phase. After this,
      * no 6model object pointers should be accessed. */
     MVM_gc_global_destruction(instance->main_thread);
@@ -455,6 +601,7 @@ void MVM_vm_destroy_instance(MVMInstance *instance) {
     uv_cond_destroy(&instance->cond_gc_finish);
     uv_cond_destroy(&instance->cond_gc_intrays_clearing);
     uv_mutex_destroy(&instance->mutex_gc_orchestrate);
+    uv_mutex_destroy(&instance->mutex_gc_steal_pool);
 
     /* Clean up Hash of HLLConfig. */
     uv_mutex_destroy(&instance->mutex_hllconfigs);
@@ -506,12 +653,21 @@ void MVM_vm_destroy_instance(MVMInstance *instance) {
     uv_mutex_destroy(&instance->mutex_spesh_install);
     uv_cond_destroy(&instance->cond_spesh_sync);
     uv_mutex_destroy(&instance->mutex_spesh_sync);
+    uv_cond_destroy(&instance->cond_spesh_plan);
+    uv_mutex_destroy(&instance->mutex_spesh_plan);
+    MVM_spesh_cache_destroy(instance);
     if (instance->spesh_log_fh)
         fclose(instance->spesh_log_fh);
-    if (instance->jit_log_fh)
+    if (instance->jit_log_fh) {
+        MVM_jit_log_bail_census(instance);
         fclose(instance->jit_log_fh);
+    }
+    if (instance->jit_perf_map)
+        fclose(instance->jit_perf_map);
     if (instance->dynvar_log_fh)
         fclose(instance->dynvar_log_fh);
+    MVM_free(instance->jit_bail_counts);
+    MVM_jit_heap_destroy(instance);
 
     /* Clean up cross-thread-write-logging mutex */
     uv_mutex_destroy(&instance->mutex_cross_thread_write_logging);
@@ -552,6 +708,21 @@ void MVM_vm_set_prog_name(MVMInstance *instance, const char *prog_name) {
     instance->prog_name = prog_name;
 }
 
+/* Sets the bounds within which the nursery size of each thread is adapted.
+ * Threads pick up new bounds after their next GC run. */
+void MVM_vm_set_nursery_size(MVMInstance *instance, MVMuint32 min, MVMuint32 max) {
+    if (min < MVM_NURSERY_SIZE_LOWEST)
+        min = MVM_NURSERY_SIZE_LOWEST;
+    if (min > MVM_NURSERY_SIZE_HIGHEST)
+        min = MVM_NURSERY_SIZE_HIGHEST;
+    if (max > MVM_NURSERY_SIZE_HIGHEST)
+        max = MVM_NURSERY_SIZE_HIGHEST;
+    if (max < min)
+        max = min;
+    instance->nursery_size_min = min;
+    instance->nursery_size_max = max;
+}
+
 void MVM_vm_set_lib_path(MVMInstance *instance, int count, const char **lib_path) {
     enum { MAX_COUNT = sizeof instance->lib_path / sizeof *instance->lib_path };
 
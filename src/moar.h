@@ -93,9 +93,10 @@ MVM_PUBLIC const MVMint32 MVM_jit_support(void);
 #include "6model/6model.h"
 #include "gc/collect.h"
 #include "gc/debug.h"
-#include "gc/wb.h"
+#include "gc/stats.h"
 #include "core/threadcontext.h"
 #include "core/instance.h"
+#include "gc/wb.h"
 #include "core/interp.h"
 #include "core/callsite.h"
 #include "core/args.h"
@@ -130,6 +131,8 @@ MVM_PUBLIC const MVMint32 MVM_jit_support(void);
 #include "6model/parametric.h"
 #include "core/compunit.h"
 #include "gc/gen2.h"
+#include "gc/los.h"
+#include "gc/compact.h"
 #include "gc/allocation.h"
 #include "gc/worklist.h"
 #include "gc/orchestrate.h"
@@ -156,6 +159,10 @@ MVM_PUBLIC const MVMint32 MVM_jit_support(void);
 #include "spesh/stats.h"
 #include "spesh/plan.h"
 #include "spesh/arg_guard.h"
+#include "spesh/cache.h"
+#include "spesh/escape.h"
+#include "spesh/hoist.h"
+#include "spesh/gvn.h"
 #include "strings/nfg.h"
 #include "strings/normalize.h"
 #include "strings/decode_stream.h"
@@ -186,8 +193,10 @@ MVM_PUBLIC const MVMint32 MVM_jit_support(void);
 #include "mast/driver.h"
 #include "core/intcache.h"
 #include "core/fixedsizealloc.h"
+#include "jit/expr.h"
 #include "jit/graph.h"
 #include "jit/compile.h"
+#include "jit/heap.h"
 #include "jit/log.h"
 #include "profiler/instrument.h"
 #include "profiler/log.h"
@@ -209,6 +218,7 @@ MVM_PUBLIC void MVM_vm_set_clargs(MVMInstance *instance, int argc, char **argv);
 MVM_PUBLIC void MVM_vm_set_exec_name(MVMInstance *instance, const char *exec_name);
 MVM_PUBLIC void MVM_vm_set_prog_name(MVMInstance *instance, const char *prog_name);
 MVM_PUBLIC void MVM_vm_set_lib_path(MVMInstance *instance, int count, const char **lib_path);
+MVM_PUBLIC void MVM_vm_set_nursery_size(MVMInstance *instance, MVMuint32 min, MVMuint32 max);
 
 #if defined(__s390__)
 AO_t AO_fetch_compare_and_swap_emulation(volatile AO_t *addr, AO_t old_val, AO_t new_val);
@@ -1,5 +1,8 @@
 #include <stddef.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include "moar.h"
 #include "platform/mmap.h"
 #include <errno.h>
@@ -60,6 +63,55 @@ int MVM_platform_free_pages(void *block, size_t size)
     return munmap(block, size) == 0;
 }
 
+size_t MVM_platform_page_size(void)
+{
+    return (size_t)sysconf(_SC_PAGESIZE);
+}
+
+/* Maps the same memory twice: once readable and writable, which is what we
+ * return, and once readable and executable, which goes in exec_block. So we
+ * can write code that may sit next to running code without any page ever
+ * being both writable and executable. Returns NULL if the system won't let
+ * us, rather than panicking, as the caller has something to fall back on. */
+static AO_t dual_pages_seq = 0;
+void *MVM_platform_alloc_dual_pages(size_t size, void **exec_block)
+{
+    char name[64];
+    void *block, *exec;
+    int fd;
+
+    snprintf(name, sizeof(name), "/moarvm-jit-%ld-%lu", (long)getpid(),
+        (unsigned long)MVM_incr(&dual_pages_seq));
+    fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+    if (fd < 0)
+        return NULL;
+    shm_unlink(name);
+    if (ftruncate(fd, size) != 0) {
+        close(fd);
+        return NULL;
+    }
+
+    block = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    exec  = block != MAP_FAILED
+        ? mmap(NULL, size, PROT_READ | PROT_EXEC, MAP_SHARED, fd, 0)
+        : MAP_FAILED;
+    close(fd);
+    if (exec == MAP_FAILED) {
+        if (block != MAP_FAILED)
+            munmap(block, size);
+        return NULL;
+    }
+
+    *exec_block = exec;
+    return block;
+}
+
+int MVM_platform_free_dual_pages(void *block, void *exec_block, size_t size)
+{
+    int freed = munmap(block, size) == 0;
+    return munmap(exec_block, size) == 0 && freed;
+}
+
 void *MVM_platform_map_file(int fd, void **handle, size_t size, int writable)
 {
     void *block = mmap(NULL, size,
@@ -40,6 +40,46 @@ int MVM_platform_free_pages(void *pages, size_t size) {
     return VirtualFree(pages, 0, MEM_RELEASE);
 }
 
+size_t MVM_platform_page_size(void) {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwPageSize;
+}
+
+/* Maps the same memory twice, writable and executable; see the POSIX
+ * version. The views keep the mapping alive once its handle is closed. */
+void *MVM_platform_alloc_dual_pages(size_t size, void **exec_block) {
+    HANDLE mapping;
+    LARGE_INTEGER li;
+    void *block, *exec;
+
+    li.QuadPart = size;
+    mapping = CreateFileMapping(INVALID_HANDLE_VALUE, NULL,
+        PAGE_EXECUTE_READWRITE, li.HighPart, li.LowPart, NULL);
+    if (mapping == NULL)
+        return NULL;
+
+    block = MapViewOfFile(mapping, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, size);
+    exec  = block
+        ? MapViewOfFile(mapping, FILE_MAP_READ | FILE_MAP_EXECUTE, 0, 0, size)
+        : NULL;
+    CloseHandle(mapping);
+    if (exec == NULL) {
+        if (block)
+            UnmapViewOfFile(block);
+        return NULL;
+    }
+
+    *exec_block = exec;
+    return block;
+}
+
+int MVM_platform_free_dual_pages(void *block, void *exec_block, size_t size) {
+    BOOL unmapped = UnmapViewOfFile(block);
+    (void)size;
+    return UnmapViewOfFile(exec_block) && unmapped;
+}
+
 void *MVM_platform_map_file(int fd, void **handle, size_t size, int writable) {
     HANDLE fh, mapping;
     LARGE_INTEGER li;
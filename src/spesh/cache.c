@@ -0,0 +1,626 @@
+#include "moar.h"
+
+#ifndef _WIN32
+#  include <unistd.h>
+#else
+#  include <process.h>
+#endif
+
+/* The persistent specialization cache. Each record is a line of text, with
+ * the fields separated by spaces:
+ *
+ *   <compunit hash> <cuuid> <num pos> <arg flags> <arg names> <type tuple>
+ *
+ * The compilation unit hash is taken over its bytecode, so that records are
+ * never applied to code that has changed. The cuuid is hex encoded UTF-8,
+ * the arg flags are hex bytes (or - if there are none), and the arg names
+ * are hex encoded UTF-8 separated by commas (or - if there are none). The
+ * type tuple is - for a certain specialization. Otherwise, it has an entry
+ * for each argument, separated by commas: _ for a native argument, and for
+ * an object argument the hex encoded handle of the serialization context
+ * that its type lives in, the index of the type in that, whether it was
+ * concrete, and whether it must be an rw container, followed by the first
+ * three of these for the decont type if there is one, all separated by
+ * colons. Types that are not in a serialization context can't be found
+ * again by a later run, so specializations involving them aren't recorded.
+ *
+ * Records loaded from the cache file are replayed when the specializer next
+ * plans for their frame: once the callsite and the types involved have been
+ * seen, the specialization is planned right away, without waiting for the
+ * frame to get hot again. */
+
+#define CACHE_HEADER "MoarVM spesh cache 1"
+
+/* A growable string we build records in. */
+typedef struct {
+    char   *buffer;
+    size_t  alloc;
+    size_t  pos;
+} RecordStr;
+
+static void init_str(RecordStr *rs) {
+    rs->alloc  = 256;
+    rs->buffer = MVM_malloc(rs->alloc);
+    rs->pos    = 0;
+    rs->buffer[0] = '\0';
+}
+
+static void append(RecordStr *rs, const char *s) {
+    size_t len = strlen(s);
+    if (rs->pos + len + 1 > rs->alloc) {
+        while (rs->pos + len + 1 > rs->alloc)
+            rs->alloc *= 2;
+        rs->buffer = MVM_realloc(rs->buffer, rs->alloc);
+    }
+    memcpy(rs->buffer + rs->pos, s, len + 1);
+    rs->pos += len;
+}
+
+/* Hex encodes a sequence of bytes. */
+static char * hex_encode(const MVMuint8 *bytes, size_t len) {
+    static const char digits[] = "0123456789abcdef";
+    char   *result = MVM_malloc(2 * len + 1);
+    size_t  i;
+    for (i = 0; i < len; i++) {
+        result[2 * i]     = digits[bytes[i] >> 4];
+        result[2 * i + 1] = digits[bytes[i] & 0xF];
+    }
+    result[2 * len] = '\0';
+    return result;
+}
+
+/* Hex encodes the UTF-8 encoding of a VM string. */
+static char * hex_encode_str(MVMThreadContext *tc, MVMString *s) {
+    char *utf8   = MVM_string_utf8_encode_C_string(tc, s);
+    char *result = hex_encode((MVMuint8 *)utf8, strlen(utf8));
+    MVM_free(utf8);
+    return result;
+}
+
+/* Decodes a hex digit, returning -1 if it isn't one. */
+static int hex_digit(char c) {
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    return -1;
+}
+
+/* Hashes the bytecode of a compilation unit, caching the result. This is
+ * only ever done by the specialization worker that forms plans. */
+static MVMuint64 cu_hash(MVMCompUnit *cu) {
+    if (!cu->body.spesh_cache_hash) {
+        MVMuint64 hash = 14695981039346656037ULL;
+        MVMuint32 i;
+        for (i = 0; i < cu->body.data_size; i++) {
+            hash ^= cu->body.data_start[i];
+            hash *= 1099511628211ULL;
+        }
+        cu->body.spesh_cache_hash = hash ? hash : 1;
+    }
+    return cu->body.spesh_cache_hash;
+}
+
+/* Appends the key for a static frame's records, with a trailing space. */
+static void append_key(MVMThreadContext *tc, RecordStr *rs, MVMStaticFrame *sf) {
+    char  hash[24];
+    char *cuuid = hex_encode_str(tc, sf->body.cuuid);
+    snprintf(hash, sizeof(hash), "%016"PRIx64" ", cu_hash(sf->body.cu));
+    append(rs, hash);
+    append(rs, cuuid);
+    append(rs, " ");
+    MVM_free(cuuid);
+}
+
+/* Appends the description of a callsite, with a trailing space. */
+static void append_callsite(MVMThreadContext *tc, RecordStr *rs, MVMCallsite *cs) {
+    MVMuint16 num_nameds = MVM_callsite_num_nameds(tc, cs);
+    char      num_pos[16];
+    MVMuint16 i;
+    snprintf(num_pos, sizeof(num_pos), "%u ", cs->num_pos);
+    append(rs, num_pos);
+    if (cs->flag_count) {
+        char *flags = hex_encode(cs->arg_flags, cs->flag_count);
+        append(rs, flags);
+        MVM_free(flags);
+    }
+    else {
+        append(rs, "-");
+    }
+    append(rs, " ");
+    if (num_nameds) {
+        for (i = 0; i < num_nameds; i++) {
+            char *name = hex_encode_str(tc, cs->arg_names[i]);
+            if (i)
+                append(rs, ",");
+            append(rs, name);
+            MVM_free(name);
+        }
+    }
+    else {
+        append(rs, "-");
+    }
+    append(rs, " ");
+}
+
+/* Appends a type as its serialization context handle, index, and whether it
+ * was concrete. Returns zero if the type isn't in a serialization context. */
+static MVMint32 append_type(MVMThreadContext *tc, RecordStr *rs, MVMObject *type,
+        MVMuint8 concrete) {
+    MVMSerializationContext *sc = MVM_sc_get_obj_sc(tc, type);
+    MVMuint32 idx;
+    char *handle;
+    char  rest[32];
+    if (!sc)
+        return 0;
+    idx = MVM_sc_get_idx_in_sc(&(type->header));
+    if (idx == (MVMuint32)~0)
+        return 0;
+    handle = hex_encode_str(tc, MVM_sc_get_handle(tc, sc));
+    append(rs, handle);
+    MVM_free(handle);
+    snprintf(rest, sizeof(rest), ":%u:%d", idx, concrete ? 1 : 0);
+    append(rs, rest);
+    return 1;
+}
+
+/* Forms the record for a planned specialization, or returns NULL if it can't
+ * be recorded. */
+static char * record_line(MVMThreadContext *tc, MVMSpeshPlanned *p) {
+    MVMCallsite *cs = p->cs_stats->cs;
+    RecordStr    rs;
+    if (!cs || !cs->is_interned)
+        return NULL;
+    init_str(&rs);
+    append_key(tc, &rs, p->sf);
+    append_callsite(tc, &rs, cs);
+    if (p->type_tuple) {
+        MVMuint16 i;
+        for (i = 0; i < cs->flag_count; i++) {
+            MVMSpeshStatsType *t = &(p->type_tuple[i]);
+            if (i)
+                append(&rs, ",");
+            if (cs->arg_flags[i] & MVM_CALLSITE_ARG_OBJ) {
+                if (!t->type || !append_type(tc, &rs, t->type, t->type_concrete))
+                    goto unrecordable;
+                append(&rs, t->rw_cont ? ":1" : ":0");
+                if (t->decont_type) {
+                    append(&rs, ":");
+                    if (!append_type(tc, &rs, t->decont_type, t->decont_type_concrete))
+                        goto unrecordable;
+                }
+            }
+            else {
+                append(&rs, "_");
+            }
+        }
+    }
+    else {
+        append(&rs, "-");
+    }
+    return rs.buffer;
+
+  unrecordable:
+    MVM_free(rs.buffer);
+    return NULL;
+}
+
+/* Finds the position of the first record not sorting before the line. */
+static MVMuint32 find_position(MVMSpeshCache *cache, const char *line) {
+    MVMuint32 lo = 0;
+    MVMuint32 hi = cache->num_records;
+    while (lo < hi) {
+        MVMuint32 mid = lo + (hi - lo) / 2;
+        if (strcmp(cache->records[mid].line, line) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/* Adds a record, unless we already have it or the cache is full. Takes
+ * ownership of the line. Must hold the cache mutex. */
+static void insert_record(MVMSpeshCache *cache, char *line, MVMuint8 loaded) {
+    MVMuint32 pos = find_position(cache, line);
+    if (pos < cache->num_records && strcmp(cache->records[pos].line, line) == 0 ||
+            cache->num_records == MVM_SPESH_CACHE_MAX_RECORDS) {
+        MVM_free(line);
+        return;
+    }
+    if (cache->num_records == cache->alloc_records) {
+        cache->alloc_records = cache->alloc_records ? cache->alloc_records * 2 : 256;
+        cache->records = MVM_realloc(cache->records,
+            cache->alloc_records * sizeof(MVMSpeshCacheRecord));
+    }
+    memmove(cache->records + pos + 1, cache->records + pos,
+        (cache->num_records - pos) * sizeof(MVMSpeshCacheRecord));
+    cache->records[pos].line   = line;
+    cache->records[pos].loaded = loaded;
+    cache->num_records++;
+    if (!loaded)
+        cache->changed = 1;
+}
+
+/* Reads a line from a file, without its newline. Returns NULL at the end of
+ * the file. */
+static char * read_line(FILE *fh) {
+    size_t  alloc  = 256;
+    size_t  pos    = 0;
+    char   *buffer = MVM_malloc(alloc);
+    while (fgets(buffer + pos, (int)(alloc - pos), fh)) {
+        pos += strlen(buffer + pos);
+        if (pos && buffer[pos - 1] == '\n') {
+            buffer[--pos] = '\0';
+            if (pos && buffer[pos - 1] == '\r')
+                buffer[--pos] = '\0';
+            return buffer;
+        }
+        alloc *= 2;
+        buffer = MVM_realloc(buffer, alloc);
+    }
+    if (pos)
+        return buffer;
+    MVM_free(buffer);
+    return NULL;
+}
+
+/* Finds the start of the type tuple of a record. */
+static const char * type_tuple_field(const char *line) {
+    MVMuint32 i;
+    for (i = 0; i < 5; i++) {
+        line = strchr(line, ' ');
+        if (!line)
+            return NULL;
+        line++;
+    }
+    return line;
+}
+
+static int compare_strings(const void *a, const void *b) {
+    return strcmp(*(char **)a, *(char **)b);
+}
+
+/* Collects the serialization context handles used by the loaded records,
+ * and makes VM strings of them so we can look the contexts up later without
+ * allocating. */
+static void collect_handles(MVMThreadContext *tc, MVMSpeshCache *cache) {
+    char      **hexes     = NULL;
+    MVMuint32   num_hexes = 0;
+    MVMuint32   alloc     = 0;
+    MVMuint32   i;
+    for (i = 0; i < cache->num_records; i++) {
+        const char *cur = type_tuple_field(cache->records[i].line);
+        MVMuint32   part = 0;
+        if (!cur || strcmp(cur, "-") == 0)
+            continue;
+        while (*cur) {
+            const char *end = cur + strcspn(cur, ":,");
+            if ((part == 0 || part == 4) && end > cur && *cur != '_') {
+                if (num_hexes == alloc) {
+                    alloc = alloc ? alloc * 2 : 32;
+                    hexes = MVM_realloc(hexes, alloc * sizeof(char *));
+                }
+                hexes[num_hexes] = MVM_malloc(end - cur + 1);
+                memcpy(hexes[num_hexes], cur, end - cur);
+                hexes[num_hexes][end - cur] = '\0';
+                num_hexes++;
+            }
+            part = *end == ':' ? part + 1 : 0;
+            cur  = *end ? end + 1 : end;
+        }
+    }
+    if (!num_hexes)
+        return;
+
+    /* Sort them, dropping duplicates, and make the VM strings. */
+    qsort(hexes, num_hexes, sizeof(char *), compare_strings);
+    cache->handles = MVM_malloc(num_hexes * sizeof(MVMSpeshCacheHandle));
+    for (i = 0; i < num_hexes; i++) {
+        MVMSpeshCacheHandle *h;
+        size_t   len = strlen(hexes[i]) / 2;
+        MVMuint8 *bytes;
+        size_t   j;
+        if (cache->num_handles && strcmp(cache->handles[cache->num_handles - 1].hex, hexes[i]) == 0) {
+            MVM_free(hexes[i]);
+            continue;
+        }
+        bytes = MVM_malloc(len + 1);
+        for (j = 0; j < len; j++) {
+            int high = hex_digit(hexes[i][2 * j]);
+            int low  = hex_digit(hexes[i][2 * j + 1]);
+            bytes[j] = high >= 0 && low >= 0 ? (MVMuint8)(high << 4 | low) : '?';
+        }
+        h         = &(cache->handles[cache->num_handles++]);
+        h->hex    = hexes[i];
+        h->handle = MVM_string_utf8_decode(tc, tc->instance->VMString, (char *)bytes, len);
+        MVM_gc_root_add_permanent_desc(tc, (MVMCollectable **)&(h->handle),
+            "Spesh cache serialization context handle");
+        MVM_free(bytes);
+    }
+    MVM_free(hexes);
+}
+
+/* Sets up the specialization cache, loading any records from an earlier run
+ * from the specified file. Records from a cache file of a different version
+ * are ignored. */
+void MVM_spesh_cache_load(MVMThreadContext *tc, const char *filename) {
+    MVMSpeshCache *cache = MVM_calloc(1, sizeof(MVMSpeshCache));
+    FILE          *fh;
+    cache->filename = MVM_malloc(strlen(filename) + 1);
+    strcpy(cache->filename, filename);
+    uv_mutex_init(&(cache->mutex));
+    fh = fopen(filename, "r");
+    if (fh) {
+        char *line = read_line(fh);
+        if (line && strcmp(line, CACHE_HEADER) == 0) {
+            MVM_free(line);
+            while ((line = read_line(fh)))
+                if (line[0] && type_tuple_field(line))
+                    insert_record(cache, line, 1);
+                else
+                    MVM_free(line);
+        }
+        else {
+            MVM_free(line);
+        }
+        fclose(fh);
+    }
+    collect_handles(tc, cache);
+    tc->instance->spesh_cache = cache;
+}
+
+/* Records the specializations in a plan, so a later run can replay them. */
+void MVM_spesh_cache_record(MVMThreadContext *tc, MVMSpeshPlan *plan) {
+    MVMSpeshCache *cache = tc->instance->spesh_cache;
+    MVMuint32      i;
+    for (i = 0; i < plan->num_planned; i++) {
+        char *line = record_line(tc, &(plan->planned[i]));
+        if (line) {
+            uv_mutex_lock(&(cache->mutex));
+            insert_record(cache, line, 0);
+            uv_mutex_unlock(&(cache->mutex));
+        }
+    }
+}
+
+/* Looks up a type by the hex encoded handle of its serialization context and
+ * its index in it. Only succeeds if the serialization context is loaded and
+ * the type already deserialized. */
+static MVMObject * resolve_type(MVMThreadContext *tc, MVMSpeshCache *cache,
+        const char *hex, const char *idx) {
+    MVMuint32 lo = 0;
+    MVMuint32 hi = cache->num_handles;
+    while (lo < hi) {
+        MVMuint32 mid = lo + (hi - lo) / 2;
+        int       cmp = strcmp(cache->handles[mid].hex, hex);
+        if (cmp == 0) {
+            MVMSerializationContext *sc = MVM_sc_find_by_handle(tc, cache->handles[mid].handle);
+            MVMObject *type = sc ? MVM_sc_try_get_object(tc, sc, strtoll(idx, NULL, 10)) : NULL;
+            return type && !IS_CONCRETE(type) ? type : NULL;
+        }
+        if (cmp < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return NULL;
+}
+
+/* Resolves an argument type entry of a record. Returns zero if it can't be
+ * resolved, or would not be a complete type tuple entry. */
+static MVMint32 resolve_arg_type(MVMThreadContext *tc, MVMSpeshCache *cache,
+        const char *start, const char *end, MVMSpeshStatsType *t) {
+    char      *entry = MVM_malloc(end - start + 1);
+    char      *parts[7];
+    MVMuint32  num_parts = 0;
+    MVMint32   result = 0;
+    char      *cur = entry;
+    memcpy(entry, start, end - start);
+    entry[end - start] = '\0';
+    while (num_parts < 7) {
+        parts[num_parts++] = cur;
+        cur = strchr(cur, ':');
+        if (!cur)
+            break;
+        *cur++ = '\0';
+    }
+    if (cur || (num_parts != 4 && num_parts != 7))
+        goto done;
+    t->type = resolve_type(tc, cache, parts[0], parts[1]);
+    if (!t->type)
+        goto done;
+    t->type_concrete = parts[2][0] == '1';
+    t->rw_cont       = parts[3][0] == '1';
+    if (num_parts == 7) {
+        if (!t->type_concrete || !STABLE(t->type)->container_spec)
+            goto done;
+        t->decont_type = resolve_type(tc, cache, parts[4], parts[5]);
+        if (!t->decont_type)
+            goto done;
+        t->decont_type_concrete = parts[6][0] == '1';
+    }
+    else if (t->type_concrete && STABLE(t->type)->container_spec) {
+        goto done;
+    }
+    result = 1;
+
+  done:
+    MVM_free(entry);
+    return result;
+}
+
+/* Resolves the type tuple of a record against a callsite. Returns NULL if
+ * it can't be resolved. */
+static MVMSpeshStatsType * resolve_type_tuple(MVMThreadContext *tc, MVMSpeshCache *cache,
+        MVMCallsite *cs, const char *cur) {
+    MVMSpeshStatsType *tuple = MVM_calloc(cs->flag_count, sizeof(MVMSpeshStatsType));
+    MVMuint16 i;
+    for (i = 0; i < cs->flag_count; i++) {
+        const char *end = cur + strcspn(cur, ",");
+        if (cs->arg_flags[i] & MVM_CALLSITE_ARG_OBJ) {
+            if (!resolve_arg_type(tc, cache, cur, end, &(tuple[i])))
+                goto unresolved;
+        }
+        else if (end - cur != 1 || *cur != '_') {
+            goto unresolved;
+        }
+        if (*end == ',' && i + 1 < cs->flag_count)
+            cur = end + 1;
+        else if (*end || i + 1 < cs->flag_count)
+            goto unresolved;
+    }
+    return tuple;
+
+  unresolved:
+    MVM_free(tuple);
+    return NULL;
+}
+
+/* Resolves records loaded from the cache file for a static frame against the
+ * callsites that its statistics have seen in this run, and the types that are
+ * loaded so far. Specializations that resolved and don't yet exist are put
+ * into an array of resolved entries, and the number of them returned. Once
+ * all records for the frame have resolved, it is not considered again. Runs
+ * on the specialization worker, so may not allocate. */
+MVMuint32 MVM_spesh_cache_resolve(MVMThreadContext *tc, MVMStaticFrame *sf,
+        MVMSpeshCacheResolved **resolved) {
+    MVMSpeshCache       *cache = tc->instance->spesh_cache;
+    MVMStaticFrameSpesh *spesh = sf->body.spesh;
+    MVMSpeshStats       *ss    = spesh->body.spesh_stats;
+    MVMuint32  num_resolved = 0;
+    MVMuint32  unresolved   = 0;
+    MVMuint32  pos, i;
+    RecordStr  key;
+    RecordStr *prefixes;
+
+    *resolved = NULL;
+    if (spesh->body.spesh_cache_replayed || !ss || !ss->num_by_callsite)
+        return 0;
+
+    /* Form the record key, and the record prefix for each callsite. */
+    init_str(&key);
+    append_key(tc, &key, sf);
+    prefixes = MVM_malloc(ss->num_by_callsite * sizeof(RecordStr));
+    for (i = 0; i < ss->num_by_callsite; i++) {
+        init_str(&(prefixes[i]));
+        if (ss->by_callsite[i].cs && ss->by_callsite[i].cs->is_interned) {
+            append(&(prefixes[i]), key.buffer);
+            append_callsite(tc, &(prefixes[i]), ss->by_callsite[i].cs);
+        }
+    }
+
+    /* Go through the records for the frame. */
+    uv_mutex_lock(&(cache->mutex));
+    for (pos = find_position(cache, key.buffer); pos < cache->num_records; pos++) {
+        const char              *line = cache->records[pos].line;
+        MVMSpeshStatsByCallsite *cs_stats;
+        MVMSpeshStatsType       *type_tuple;
+        if (strncmp(line, key.buffer, key.pos) != 0)
+            break;
+        if (!cache->records[pos].loaded)
+            continue;
+
+        /* Find the callsite; if we've not seen it yet, try again later. */
+        for (i = 0; i < ss->num_by_callsite; i++)
+            if (prefixes[i].pos && strncmp(line, prefixes[i].buffer, prefixes[i].pos) == 0)
+                break;
+        if (i == ss->num_by_callsite) {
+            unresolved++;
+            continue;
+        }
+        cs_stats = &(ss->by_callsite[i]);
+
+        /* Resolve the types, if any. */
+        line += prefixes[i].pos;
+        if (strcmp(line, "-") == 0) {
+            type_tuple = NULL;
+        }
+        else {
+            type_tuple = resolve_type_tuple(tc, cache, cs_stats->cs, line);
+            if (!type_tuple) {
+                unresolved++;
+                continue;
+            }
+        }
+
+        /* Skip it if we already have it, otherwise add it to the results. */
+        if (MVM_spesh_arg_guard_exists(tc, spesh->body.spesh_arg_guard, cs_stats->cs, type_tuple)) {
+            MVM_free(type_tuple);
+            continue;
+        }
+        *resolved = MVM_realloc(*resolved, (num_resolved + 1) * sizeof(MVMSpeshCacheResolved));
+        (*resolved)[num_resolved].cs_stats   = cs_stats;
+        (*resolved)[num_resolved].type_tuple = type_tuple;
+        num_resolved++;
+    }
+    uv_mutex_unlock(&(cache->mutex));
+
+    for (i = 0; i < ss->num_by_callsite; i++)
+        MVM_free(prefixes[i].buffer);
+    MVM_free(prefixes);
+    MVM_free(key.buffer);
+    if (!unresolved)
+        spesh->body.spesh_cache_replayed = 1;
+    return num_resolved;
+}
+
+/* Saves the cache, if it changed since it was loaded. The file is written
+ * under a temporary name and then renamed over the old one, so processes
+ * starting up meanwhile never see a partially written cache. */
+void MVM_spesh_cache_save(MVMInstance *instance) {
+    MVMSpeshCache *cache = instance->spesh_cache;
+    if (!cache)
+        return;
+    uv_mutex_lock(&(cache->mutex));
+    if (cache->changed) {
+        size_t  len       = strlen(cache->filename) + 32;
+        char   *temp_name = MVM_malloc(len);
+        FILE   *fh;
+        MVMint64 pid;
+#ifdef _WIN32
+        pid = _getpid();
+#else
+        pid = getpid();
+#endif
+        snprintf(temp_name, len, "%s.%"PRId64, cache->filename, pid);
+        fh = fopen(temp_name, "w");
+        if (fh) {
+            MVMuint32 i;
+            int       failed = fprintf(fh, "%s\n", CACHE_HEADER) < 0;
+            for (i = 0; i < cache->num_records && !failed; i++)
+                failed = fprintf(fh, "%s\n", cache->records[i].line) < 0;
+            if (fclose(fh) == 0 && !failed) {
+#ifdef _WIN32
+                remove(cache->filename);
+#endif
+                if (rename(temp_name, cache->filename) != 0)
+                    remove(temp_name);
+            }
+            else {
+                remove(temp_name);
+            }
+        }
+        MVM_free(temp_name);
+        cache->changed = 0;
+    }
+    uv_mutex_unlock(&(cache->mutex));
+}
+
+/* Frees the memory associated with the specialization cache. */
+void MVM_spesh_cache_destroy(MVMInstance *instance) {
+    MVMSpeshCache *cache = instance->spesh_cache;
+    MVMuint32      i;
+    if (!cache)
+        return;
+    for (i = 0; i < cache->num_records; i++)
+        MVM_free(cache->records[i].line);
+    MVM_free(cache->records);
+    for (i = 0; i < cache->num_handles; i++)
+        MVM_free(cache->handles[i].hex);
+    MVM_free(cache->handles);
+    MVM_free(cache->filename);
+    uv_mutex_destroy(&(cache->mutex));
+    MVM_free(cache);
+    instance->spesh_cache = NULL;
+}
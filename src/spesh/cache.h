@@ -0,0 +1,61 @@
+/* The persistent specialization cache, which records the specializations a
+ * run planned, so a later run of the same code can produce them as soon as
+ * it sees the frames involved. Enabled by setting MVM_SPESH_CACHE to the
+ * name of the file to keep it in. */
+struct MVMSpeshCache {
+    /* The file the cache is loaded from and saved to. */
+    char *filename;
+
+    /* Records, kept sorted so those for a static frame are adjacent, and
+     * the number of them and space allocated for them. */
+    MVMSpeshCacheRecord *records;
+    MVMuint32 num_records;
+    MVMuint32 alloc_records;
+
+    /* The serialization context handles mentioned in the loaded records,
+     * sorted by their hex encoding. */
+    MVMSpeshCacheHandle *handles;
+    MVMuint32 num_handles;
+
+    /* Whether records were added since the cache was loaded. */
+    MVMuint8 changed;
+
+    /* Mutex protecting the records, since they are saved by whichever
+     * thread is exiting while the specialization worker may be adding
+     * to them. */
+    uv_mutex_t mutex;
+};
+
+/* A cache record. */
+struct MVMSpeshCacheRecord {
+    /* The record, as a line of text (without the newline). */
+    char *line;
+
+    /* Whether it was loaded from the cache file, and so is worth replaying
+     * (those recorded during this run already have specializations). */
+    MVMuint8 loaded;
+};
+
+/* A serialization context handle, as hex encoded in the cache file and as
+ * a VM string that we can look the serialization context up by. */
+struct MVMSpeshCacheHandle {
+    char *hex;
+    MVMString *handle;
+};
+
+/* A cached specialization that was resolved against the callsites and types
+ * of the current run, and is ready to be planned. */
+struct MVMSpeshCacheResolved {
+    MVMSpeshStatsByCallsite *cs_stats;
+    MVMSpeshStatsType *type_tuple;
+};
+
+/* The maximum number of records we keep in the cache. */
+#define MVM_SPESH_CACHE_MAX_RECORDS 65536
+
+void MVM_spesh_cache_load(MVMThreadContext *tc, const char *filename);
+void MVM_spesh_cache_record(MVMThreadContext *tc, MVMSpeshPlan *plan);
+MVMuint32 MVM_spesh_cache_resolve(MVMThreadContext *tc, MVMStaticFrame *sf,
+    MVMSpeshCacheResolved **resolved);
+void MVM_spesh_cache_save(MVMInstance *instance);
+void MVM_spesh_cache_destroy(MVMInstance *instance);
@@ -31,7 +31,7 @@ void MVM_spesh_candidate_add(MVMThreadContext *tc, MVMSpeshPlanned *p) {
 
     /* If we've reached our specialization limit, don't continue. */
     if (tc->instance->spesh_limit)
-        if (++tc->instance->spesh_produced > tc->instance->spesh_limit)
+        if (MVM_incr(&(tc->instance->spesh_produced)) >= tc->instance->spesh_limit)
             return;
 
     /* Produce the specialization graph and, if we're logging, dump it out
@@ -72,6 +72,12 @@ void MVM_spesh_candidate_add(MVMThreadContext *tc, MVMSpeshPlanned *p) {
     /* Generate code and install it into the candidate. */
     sc = MVM_spesh_codegen(tc, sg);
     candidate = MVM_calloc(1, sizeof(MVMSpeshCandidate));
+    candidate->cs            = p->cs_stats->cs;
+    if (p->type_tuple) {
+        size_t tt_size = p->cs_stats->cs->flag_count * sizeof(MVMSpeshStatsType);
+        candidate->type_tuple = MVM_malloc(tt_size);
+        memcpy(candidate->type_tuple, p->type_tuple, tt_size);
+    }
     candidate->bytecode      = sc->bytecode;
     candidate->bytecode_size = sc->bytecode_size;
     candidate->handlers      = sc->handlers;
@@ -112,8 +118,10 @@ void MVM_spesh_candidate_add(MVMThreadContext *tc, MVMSpeshPlanned *p) {
     MVM_spesh_graph_destroy(tc, sg);
 
     /* Create a new candidate list and copy any existing ones. Free memory
-     * using the FSA safepoint mechanism. */
+     * using the FSA safepoint mechanism. There may be several specialization
+     * workers, so installation is done under the install mutex. */
     spesh = p->sf->body.spesh;
+    uv_mutex_lock(&(tc->instance->mutex_spesh_install));
     new_candidate_list = MVM_fixed_size_alloc(tc, tc->instance->fsa,
         (spesh->body.num_spesh_candidates + 1) * sizeof(MVMSpeshCandidate *));
     if (spesh->body.num_spesh_candidates) {
@@ -141,6 +149,7 @@ void MVM_spesh_candidate_add(MVMThreadContext *tc, MVMSpeshPlanned *p) {
         p->cs_stats->cs, p->type_tuple, spesh->body.num_spesh_candidates);
     MVM_barrier();
     spesh->body.num_spesh_candidates++;
+    uv_mutex_unlock(&(tc->instance->mutex_spesh_install));
 
     /* If we're logging, dump the updated arg guards also. */
     if (tc->instance->spesh_log_fh) {
@@ -155,8 +164,50 @@ void MVM_spesh_candidate_add(MVMThreadContext *tc, MVMSpeshPlanned *p) {
 #endif
 }
 
+/* Rebuilds the argument guard of a static frame, leaving out any retired
+ * candidates. Must be called with the install mutex held. */
+static void rebuild_arg_guard(MVMThreadContext *tc, MVMStaticFrameSpesh *spesh) {
+    MVMSpeshArgGuard *ag = NULL;
+    MVMuint32 i;
+    for (i = 0; i < spesh->body.num_spesh_candidates; i++) {
+        MVMSpeshCandidate *cand = spesh->body.spesh_candidates[i];
+        if (!cand->retired)
+            MVM_spesh_arg_guard_add(tc, &ag, cand->cs, cand->type_tuple, i);
+    }
+    MVM_spesh_arg_guard_destroy(tc, spesh->body.spesh_arg_guard, 1);
+    spesh->body.spesh_arg_guard = ag;
+}
+
+/* Counts a deopt from a specialization. If, over the last window of deopts,
+ * enough of its entries deopted, the type profile it was produced for
+ * probably no longer holds, so retire it and have the frame's statistics
+ * thrown away, so that it will be logged and planned again. */
+void MVM_spesh_candidate_count_deopt(MVMThreadContext *tc, MVMStaticFrame *sf,
+                                     MVMSpeshCandidate *candidate) {
+    MVMStaticFrameSpesh *spesh;
+    MVMuint64 entries;
+    if (MVM_incr(&(candidate->deopt_count)) + 1 != MVM_SPESH_DEOPT_WINDOW)
+        return;
+    entries = candidate->entry_count;
+    candidate->entry_count = 0;
+    MVM_store(&(candidate->deopt_count), 0);
+    if ((MVMuint64)MVM_SPESH_DEOPT_WINDOW * 100 <= entries * MVM_SPESH_DEOPT_RETIRE_PERCENT)
+        return;
+    spesh = sf->body.spesh;
+    uv_mutex_lock(&(tc->instance->mutex_spesh_install));
+    if (!candidate->retired && spesh->body.num_retirements < MVM_SPESH_MAX_RETIREMENTS) {
+        candidate->retired = 1;
+        spesh->body.num_retirements++;
+        rebuild_arg_guard(tc, spesh);
+        spesh->body.spesh_stats_stale = 1;
+        spesh->body.spesh_entries_recorded = 0;
+    }
+    uv_mutex_unlock(&(tc->instance->mutex_spesh_install));
+}
+
 /* Frees the memory associated with a spesh candidate. */
 void MVM_spesh_candidate_destroy(MVMThreadContext *tc, MVMSpeshCandidate *candidate) {
+    MVM_free(candidate->type_tuple);
     MVM_free(candidate->bytecode);
     MVM_free(candidate->handlers);
     MVM_free(candidate->spesh_slots);
@@ -1,8 +1,21 @@
+/* A specialization's deopts are looked at in windows of this many. If over
+ * the window they came from more than the given percentage of its entries,
+ * it is retired, so that the frame will be planned again from fresh
+ * statistics; otherwise, a new window starts. The last is the number of
+ * times that may happen to the specializations of a single frame. */
+#define MVM_SPESH_DEOPT_WINDOW          100
+#define MVM_SPESH_DEOPT_RETIRE_PERCENT  10
+#define MVM_SPESH_MAX_RETIREMENTS       4
+
 /* A specialization candidate. */
 struct MVMSpeshCandidate {
     /* The callsite we should have for a match. */
     MVMCallsite *cs;
 
+    /* The type tuple it was produced for, if any; kept so the argument guard
+     * can be rebuilt should another candidate be retired. */
+    MVMSpeshStatsType *type_tuple;
+
     /* Length of the specialized bytecode in bytes. */
     MVMuint32 bytecode_size;
 
@@ -55,8 +68,20 @@ struct MVMSpeshCandidate {
 
     /* JIT-code structure. */
     MVMJitCode *jitcode;
+
+    /* The number of times this specialization was entered, and the number
+     * of times code running it deopted, in the current window. The entry
+     * count isn't updated atomically, so is only an estimate. */
+    MVMuint32 entry_count;
+    AO_t deopt_count;
+
+    /* Set when the specialization has been retired. It is no longer reached
+     * through the argument guard, but frames already running it carry on. */
+    MVMuint32 retired;
 };
 
 /* Functions for creating and clearing up specializations. */
 void MVM_spesh_candidate_add(MVMThreadContext *tc, MVMSpeshPlanned *p);
+void MVM_spesh_candidate_count_deopt(MVMThreadContext *tc, MVMStaticFrame *sf,
+    MVMSpeshCandidate *candidate);
 void MVM_spesh_candidate_destroy(MVMThreadContext *tc, MVMSpeshCandidate *candidate);
@@ -165,6 +165,7 @@ static void deopt_named_args_used(MVMThreadContext *tc, MVMFrame *f) {
 static void deopt_frame(MVMThreadContext *tc, MVMFrame *f, MVMint32 deopt_offset, MVMint32 deopt_target) {
     /* Found it; are we in an inline? */
     MVMSpeshInline *inlines = f->spesh_cand->inlines;
+    MVM_spesh_candidate_count_deopt(tc, f->static_info, f->spesh_cand);
     deopt_named_args_used(tc, f);
     if (inlines) {
         /* Yes, going to have to re-create the frames; uninline
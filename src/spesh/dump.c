@@ -627,6 +627,17 @@ char * MVM_spesh_dump_stats(MVMThreadContext *tc, MVMStaticFrame *sf) {
                     ss->static_values[i].value,
                     ss->static_values[i].bytecode_offset);
         }
+
+        if (ss->num_alloc_sites) {
+            append(&ds, "Allocation sites:\n");
+            for (i = 0; i < ss->num_alloc_sites; i++)
+                appendf(&ds, "    - %d of %d survived @ %d\n",
+                    ss->alloc_sites[i].survivors,
+                    ss->alloc_sites[i].samples,
+                    ss->alloc_sites[i].bytecode_offset);
+        }
+        if (sf->body.spesh->body.pretenure_revoked)
+            append(&ds, "Pretenuring revoked\n");
     }
     else {
         append(&ds, "No spesh stats for this static frame\n");
@@ -655,6 +666,9 @@ char * MVM_spesh_dump_planned(MVMThreadContext *tc, MVMSpeshPlanned *p) {
         case MVM_SPESH_PLANNED_DERIVED_TYPES:
             append(&ds, "Derived type");
             break;
+        case MVM_SPESH_PLANNED_CACHED:
+            append(&ds, "Cached");
+            break;
     }
     append(&ds, " specialization of '");
     append_str(tc, &ds, p->sf->body.name);
@@ -680,7 +694,7 @@ char * MVM_spesh_dump_planned(MVMThreadContext *tc, MVMSpeshPlanned *p) {
                 appendf(&ds,
                     "It was planned due to the callsite receiving %u hits.\n",
                     p->cs_stats->hits);
-            else if (p->cs_stats->osr_hits >= MVM_SPESH_PLAN_CS_MIN_OSR)
+            else if (p->cs_stats->osr_hits >= MVM_spesh_threshold_osr(tc))
                 appendf(&ds,
                     "It was planned due to the callsite receiving %u OSR hits.\n",
                     p->cs_stats->osr_hits);
@@ -697,10 +711,10 @@ char * MVM_spesh_dump_planned(MVMThreadContext *tc, MVMSpeshPlanned *p) {
                : 0;
             append(&ds, "It was planned for the type tuple:\n");
             dump_stats_type_tuple(tc, &ds, cs, p->type_tuple, "    ");
-            if (osr_hit_percent >= MVM_SPESH_PLAN_TT_OBS_PERCENT_OSR)
+            if (osr_hit_percent >= tc->instance->spesh_type_tuple_percent)
                 appendf(&ds, "Which received %u OSR hits (%u%% of the %u callsite OSR hits).\n",
                     p->type_stats[0]->osr_hits, osr_hit_percent, p->cs_stats->osr_hits);
-            else if (hit_percent >= MVM_SPESH_PLAN_TT_OBS_PERCENT)
+            else if (hit_percent >= tc->instance->spesh_type_tuple_percent)
                 appendf(&ds, "Which received %u hits (%u%% of the %u callsite hits).\n",
                     p->type_stats[0]->hits, hit_percent, p->cs_stats->hits);
             else
@@ -709,6 +723,16 @@ char * MVM_spesh_dump_planned(MVMThreadContext *tc, MVMSpeshPlanned *p) {
         }
         case MVM_SPESH_PLANNED_DERIVED_TYPES:
             break;
+        case MVM_SPESH_PLANNED_CACHED:
+            if (p->type_tuple) {
+                append(&ds, "It was planned for the type tuple:\n");
+                dump_stats_type_tuple(tc, &ds, p->cs_stats->cs, p->type_tuple, "    ");
+                append(&ds, "Which was recorded in the specialization cache by an earlier run.\n");
+            }
+            else {
+                append(&ds, "It was recorded in the specialization cache by an earlier run.\n");
+            }
+            break;
     }
 
     appendf(&ds, "\nThe maximum stack depth is %d.\n\n", p->max_depth);
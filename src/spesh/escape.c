@@ -0,0 +1,456 @@
+#include "moar.h"
+
+/* This file does escape analysis of allocations in a specialized frame, and
+ * scalar replacement of those that don't escape. An object made by one of
+ * the sp_fastcreate ops that is only ever used to bind attributes and then
+ * get them back out, or a box that is only ever unboxed again, need never
+ * be allocated at all: the values bound into it (or boxed) can be used
+ * directly wherever they would have been read back out.
+ *
+ * The generated code only knows the original registers, so a read is only
+ * replaced with the register a value was bound (or boxed) from if nothing
+ * else in the graph writes to that register; otherwise it may hold something
+ * else by the time of the read.
+ *
+ * We don't materialize objects on deoptimization. Instead, we only replace
+ * allocations whose uses all follow them in the same basic block with no
+ * deopt point in between, which we check by walking the instructions rather
+ * than trusting usage counts. */
+
+/* The most attributes we'll track for a single object. */
+#define MAX_ATTRS 16
+
+/* An allocation we may be able to replace. */
+typedef struct Candidate Candidate;
+struct Candidate {
+    /* The allocating instruction and the basic block it is in. */
+    MVMSpeshIns *alloc;
+    MVMSpeshBB  *bb;
+
+    /* Whether it's a box (as opposed to an object with attributes), and if
+     * so the unbox op that gets the boxed value back. */
+    MVMuint8  is_box;
+    MVMuint16 unbox_op;
+
+    /* Set if it escapes, and so can't be replaced. */
+    MVMuint8 escaped;
+
+    /* The number of reads of it and the registers it was copied into, all
+     * by instructions we know how to replace. */
+    MVMint32 replaceable;
+
+    /* The number of attribute binds we saw. */
+    MVMuint32 num_binds;
+
+    /* The offsets of the attributes bound in the object, the kinds of the
+     * binds, and the registers bound into them. */
+    MVMuint32       num_attrs;
+    MVMint16        offsets[MAX_ATTRS];
+    MVMuint16       kinds[MAX_ATTRS];
+    MVMSpeshOperand values[MAX_ATTRS];
+
+    /* The next candidate. */
+    Candidate *next;
+};
+
+/* State of the analysis: the candidates, a mapping of each register
+ * version to the candidate it holds, if any, and the number of writes to
+ * each original register in the graph. */
+typedef struct {
+    Candidate   *candidates;
+    Candidate ***map;
+    MVMuint32   *graph_writes;
+} EscapeState;
+
+static Candidate * get_cand(MVMSpeshGraph *g, EscapeState *es, MVMSpeshOperand o) {
+    return es->map[o.reg.orig] ? es->map[o.reg.orig][o.reg.i] : NULL;
+}
+static void set_cand(MVMThreadContext *tc, MVMSpeshGraph *g, EscapeState *es,
+        MVMSpeshOperand o, Candidate *cand) {
+    if (!es->map[o.reg.orig])
+        es->map[o.reg.orig] = MVM_spesh_alloc(tc, g,
+            g->fact_counts[o.reg.orig] * sizeof(Candidate *));
+    es->map[o.reg.orig][o.reg.i] = cand;
+}
+
+/* Maps the bind and get ops to the kind of value they work on. */
+static MVMuint16 attr_kind(MVMuint16 opcode) {
+    switch (opcode) {
+        case MVM_OP_sp_p6obind_o: case MVM_OP_sp_p6oget_o: return MVM_reg_obj;
+        case MVM_OP_sp_p6obind_i: case MVM_OP_sp_p6oget_i: return MVM_reg_int64;
+        case MVM_OP_sp_p6obind_n: case MVM_OP_sp_p6oget_n: return MVM_reg_num64;
+        case MVM_OP_sp_p6obind_s: case MVM_OP_sp_p6oget_s: return MVM_reg_str;
+        default: return 0;
+    }
+}
+static MVMint32 is_bind(MVMuint16 opcode) {
+    return opcode == MVM_OP_sp_p6obind_o || opcode == MVM_OP_sp_p6obind_i ||
+           opcode == MVM_OP_sp_p6obind_n || opcode == MVM_OP_sp_p6obind_s;
+}
+
+/* Checks if the REPR of a box target gives back exactly the value boxed
+ * into it when unboxed with the matching op. */
+static MVMint32 repr_round_trips(MVMSTable *st, MVMuint16 box_op) {
+    switch (st->REPR->ID) {
+        case MVM_REPR_ID_P6int: {
+            MVMP6intREPRData *repr_data = (MVMP6intREPRData *)st->REPR_data;
+            return box_op == MVM_OP_box_i && repr_data &&
+                repr_data->bits == 64 && !repr_data->is_unsigned;
+        }
+        case MVM_REPR_ID_P6bigint:
+            return box_op == MVM_OP_box_i;
+        case MVM_REPR_ID_P6num: {
+            MVMP6numREPRData *repr_data = (MVMP6numREPRData *)st->REPR_data;
+            return box_op == MVM_OP_box_n && repr_data && repr_data->bits == 64;
+        }
+        case MVM_REPR_ID_P6str:
+            return box_op == MVM_OP_box_s;
+        default:
+            return 0;
+    }
+}
+static MVMint32 box_round_trips(MVMObject *type, MVMuint16 box_op) {
+    MVMSTable *st = STABLE(type);
+    if (st->mode_flags & MVM_FINALIZE_TYPE)
+        return 0;
+    if (st->REPR->ID == MVM_REPR_ID_P6opaque) {
+        MVMP6opaqueREPRData *repr_data = (MVMP6opaqueREPRData *)st->REPR_data;
+        MVMint16 slot;
+        if (!repr_data)
+            return 0;
+        slot = box_op == MVM_OP_box_i ? repr_data->unbox_int_slot :
+               box_op == MVM_OP_box_n ? repr_data->unbox_num_slot :
+                                        repr_data->unbox_str_slot;
+        return slot >= 0 && repr_data->flattened_stables[slot] &&
+            repr_round_trips(repr_data->flattened_stables[slot], box_op);
+    }
+    return repr_round_trips(st, box_op);
+}
+
+/* Adds a candidate for the allocation done by an instruction. */
+static void add_cand(MVMThreadContext *tc, MVMSpeshGraph *g, EscapeState *es,
+        MVMSpeshBB *bb, MVMSpeshIns *ins, MVMuint16 unbox_op) {
+    Candidate *cand = MVM_spesh_alloc(tc, g, sizeof(Candidate));
+    cand->alloc     = ins;
+    cand->bb        = bb;
+    cand->is_box    = unbox_op != 0;
+    cand->unbox_op  = unbox_op;
+    cand->next      = es->candidates;
+    es->candidates  = cand;
+    set_cand(tc, g, es, ins->operands[0], cand);
+}
+
+/* Looks at a read of a candidate, and either notes that it's a use we can
+ * replace or that the candidate escapes. */
+static void note_read(MVMThreadContext *tc, MVMSpeshGraph *g, EscapeState *es,
+        MVMSpeshIns *ins, MVMuint16 i, Candidate *cand) {
+    MVMuint16 opcode = ins->info->opcode;
+    if (opcode == MVM_OP_set) {
+        /* Copy it; the copy has the same candidate. */
+        cand->replaceable++;
+        set_cand(tc, g, es, ins->operands[0], cand);
+    }
+    else if (cand->is_box) {
+        if (opcode == cand->unbox_op)
+            cand->replaceable++;
+        else
+            cand->escaped = 1;
+    }
+    else {
+        switch (opcode) {
+            case MVM_OP_sp_p6oget_o:
+            case MVM_OP_sp_p6oget_i:
+            case MVM_OP_sp_p6oget_n:
+            case MVM_OP_sp_p6oget_s:
+                cand->replaceable++;
+                break;
+            case MVM_OP_sp_p6obind_o:
+            case MVM_OP_sp_p6obind_i:
+            case MVM_OP_sp_p6obind_n:
+            case MVM_OP_sp_p6obind_s:
+                /* Binding into it is fine, binding it somewhere is not. */
+                if (i == 0) {
+                    cand->num_binds++;
+                    cand->replaceable++;
+                }
+                else {
+                    cand->escaped = 1;
+                }
+                break;
+            default:
+                cand->escaped = 1;
+        }
+    }
+}
+
+/* Visits the blocks in dominator tree order, so we see the allocations
+ * before any of their uses, finding candidates and their uses. */
+static void find_candidates(MVMThreadContext *tc, MVMSpeshGraph *g, EscapeState *es,
+        MVMSpeshBB *bb) {
+    MVMSpeshIns *ins = bb->first_ins;
+    MVMint32 i;
+    while (ins) {
+        MVMuint16 opcode = ins->info->opcode;
+        MVMint32  is_phi = opcode == MVM_SSA_PHI;
+
+        /* Check reads for candidates. */
+        for (i = 0; i < ins->info->num_operands; i++) {
+            if ((is_phi && i > 0)
+                    || (!is_phi && (ins->info->operands[i] & MVM_operand_rw_mask) == MVM_operand_read_reg)) {
+                Candidate *cand = get_cand(g, es, ins->operands[i]);
+                if (cand && !cand->escaped) {
+                    if (is_phi)
+                        cand->escaped = 1;
+                    else
+                        note_read(tc, g, es, ins, i, cand);
+                }
+            }
+        }
+
+        /* See if it's an allocation we may replace. */
+        switch (opcode) {
+            case MVM_OP_sp_fastcreate:
+            case MVM_OP_sp_fastcreate_gen2: {
+                MVMSTable *st = (MVMSTable *)g->spesh_slots[ins->operands[2].lit_i16];
+                if (!(st->mode_flags & MVM_FINALIZE_TYPE))
+                    add_cand(tc, g, es, bb, ins, 0);
+                break;
+            }
+            case MVM_OP_box_i:
+            case MVM_OP_box_n:
+            case MVM_OP_box_s: {
+                MVMSpeshFacts *type_facts = MVM_spesh_get_facts(tc, g, ins->operands[2]);
+                if (type_facts->flags & MVM_SPESH_FACT_KNOWN_TYPE && type_facts->type &&
+                        box_round_trips(type_facts->type, opcode))
+                    add_cand(tc, g, es, bb, ins,
+                        opcode == MVM_OP_box_i ? MVM_OP_unbox_i :
+                        opcode == MVM_OP_box_n ? MVM_OP_unbox_n :
+                                                 MVM_OP_unbox_s);
+                break;
+            }
+        }
+
+        ins = ins->next;
+    }
+
+    /* Visit children. */
+    for (i = 0; i < bb->num_children; i++)
+        find_candidates(tc, g, es, bb->children[i]);
+}
+
+/* Checks if a value stays in its register, so a read of a candidate can
+ * be replaced with a read of the register anywhere the candidate is used.
+ * This is the same rule GVN uses for reusing a result. */
+static MVMint32 value_usable(EscapeState *es, MVMSpeshOperand o) {
+    return es->graph_writes[o.reg.orig] == 1;
+}
+
+/* Checks that all uses of a candidate follow its allocation in the same
+ * basic block, with no deopt point before the last of them. */
+static MVMint32 check_no_deopt(MVMThreadContext *tc, MVMSpeshGraph *g, EscapeState *es,
+        Candidate *cand) {
+    MVMSpeshIns *ins  = cand->alloc->next;
+    MVMint32     seen = 0;
+    MVMint32     i;
+    while (ins && seen < cand->replaceable) {
+        MVMSpeshAnn *ann = ins->annotations;
+        while (ann) {
+            switch (ann->type) {
+                case MVM_SPESH_ANN_DEOPT_ONE_INS:
+                case MVM_SPESH_ANN_DEOPT_ALL_INS:
+                case MVM_SPESH_ANN_DEOPT_INLINE:
+                case MVM_SPESH_ANN_DEOPT_OSR:
+                    return 0;
+            }
+            ann = ann->next;
+        }
+        if (ins->info->opcode != MVM_SSA_PHI)
+            for (i = 0; i < ins->info->num_operands; i++)
+                if ((ins->info->operands[i] & MVM_operand_rw_mask) == MVM_operand_read_reg
+                        && get_cand(g, es, ins->operands[i]) == cand)
+                    seen++;
+        ins = ins->next;
+    }
+    return seen == cand->replaceable;
+}
+
+/* Finds the attribute with the specified offset, if it was bound. */
+static MVMint32 find_attr(Candidate *cand, MVMint16 offset) {
+    MVMuint32 i;
+    for (i = 0; i < cand->num_attrs; i++)
+        if (cand->offsets[i] == offset)
+            return i;
+    return -1;
+}
+
+/* Checks that all of the attributes of an object candidate are bound right
+ * after it is allocated, in the same basic block and before it is first
+ * read from, each at most once. That way, every get sees the one value that
+ * was bound. Records the values bound along the way. */
+static MVMint32 check_binds(MVMThreadContext *tc, MVMSpeshGraph *g, EscapeState *es,
+        Candidate *cand) {
+    MVMSpeshIns *ins   = cand->alloc->next;
+    MVMuint32    binds = 0;
+    while (ins && binds < cand->num_binds) {
+        MVMuint16 kind = attr_kind(ins->info->opcode);
+        if (kind) {
+            if (is_bind(ins->info->opcode)) {
+                if (get_cand(g, es, ins->operands[0]) == cand) {
+                    MVMint16 offset = ins->operands[1].lit_i16;
+                    if (cand->num_attrs == MAX_ATTRS || find_attr(cand, offset) >= 0
+                            || !value_usable(es, ins->operands[2]))
+                        return 0;
+                    cand->offsets[cand->num_attrs] = offset;
+                    cand->kinds[cand->num_attrs]   = kind;
+                    cand->values[cand->num_attrs]  = ins->operands[2];
+                    cand->num_attrs++;
+                    binds++;
+                }
+            }
+            else if (get_cand(g, es, ins->operands[1]) == cand) {
+                /* Read before all binds were done. */
+                return 0;
+            }
+        }
+        ins = ins->next;
+    }
+    return binds == cand->num_binds;
+}
+
+/* Checks that every get of an object candidate is of an attribute that was
+ * bound, using the same kind as it was bound with. */
+static MVMint32 check_gets(MVMThreadContext *tc, MVMSpeshGraph *g, EscapeState *es,
+        Candidate *cand) {
+    MVMSpeshBB *bb = g->entry;
+    while (bb) {
+        MVMSpeshIns *ins = bb->first_ins;
+        while (ins) {
+            MVMuint16 kind = attr_kind(ins->info->opcode);
+            if (kind && !is_bind(ins->info->opcode) &&
+                    get_cand(g, es, ins->operands[1]) == cand) {
+                MVMint32 attr = find_attr(cand, ins->operands[2].lit_i16);
+                if (attr < 0 || cand->kinds[attr] != kind)
+                    return 0;
+            }
+            ins = ins->next;
+        }
+        bb = bb->linear_next;
+    }
+    return 1;
+}
+
+/* Turns an instruction reading a candidate into a set of the value that the
+ * candidate would have held. */
+static void replace_with_set(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpeshIns *ins,
+        MVMSpeshOperand value) {
+    MVMSpeshOperand *operands = MVM_spesh_alloc(tc, g, 2 * sizeof(MVMSpeshOperand));
+    MVM_spesh_get_facts(tc, g, ins->operands[1])->usages--;
+    MVM_spesh_get_facts(tc, g, value)->usages++;
+    operands[0]   = ins->operands[0];
+    operands[1]   = value;
+    ins->info     = MVM_op_get_op(MVM_OP_set);
+    ins->operands = operands;
+}
+
+/* Replaces the uses of the candidates that don't escape, then deletes the
+ * allocations along with the binds into them and any copies of them. */
+static void replace_candidates(MVMThreadContext *tc, MVMSpeshGraph *g, EscapeState *es) {
+    MVMSpeshBB *bb;
+    Candidate  *cand;
+
+    /* Replace the reads with the values they would have got. */
+    bb = g->entry;
+    while (bb) {
+        MVMSpeshIns *ins = bb->first_ins;
+        while (ins) {
+            MVMSpeshIns *next   = ins->next;
+            MVMuint16    opcode = ins->info->opcode;
+            if (opcode == MVM_OP_unbox_i || opcode == MVM_OP_unbox_n || opcode == MVM_OP_unbox_s) {
+                cand = get_cand(g, es, ins->operands[1]);
+                if (cand && !cand->escaped)
+                    replace_with_set(tc, g, ins, cand->alloc->operands[1]);
+            }
+            else if (attr_kind(opcode)) {
+                if (is_bind(opcode)) {
+                    cand = get_cand(g, es, ins->operands[0]);
+                    if (cand && !cand->escaped)
+                        MVM_spesh_manipulate_delete_ins(tc, g, bb, ins);
+                }
+                else {
+                    cand = get_cand(g, es, ins->operands[1]);
+                    if (cand && !cand->escaped)
+                        replace_with_set(tc, g, ins,
+                            cand->values[find_attr(cand, ins->operands[2].lit_i16)]);
+                }
+            }
+            ins = next;
+        }
+        bb = bb->linear_next;
+    }
+
+    /* Delete the copies, which are now unused, and then the allocations. */
+    bb = g->entry;
+    while (bb) {
+        MVMSpeshIns *ins = bb->first_ins;
+        while (ins) {
+            MVMSpeshIns *next = ins->next;
+            if (ins->info->opcode == MVM_OP_set) {
+                cand = get_cand(g, es, ins->operands[1]);
+                if (cand && !cand->escaped)
+                    MVM_spesh_manipulate_delete_ins(tc, g, bb, ins);
+            }
+            ins = next;
+        }
+        bb = bb->linear_next;
+    }
+    for (cand = es->candidates; cand; cand = cand->next) {
+        if (!cand->escaped)
+            MVM_spesh_manipulate_delete_ins(tc, g, cand->bb, cand->alloc);
+    }
+}
+
+/* Finds allocations in the graph that don't escape, and replaces them. */
+void MVM_spesh_escape_eliminate_allocations(MVMThreadContext *tc, MVMSpeshGraph *g) {
+    EscapeState  es;
+    Candidate   *cand;
+    MVMSpeshBB  *cur_bb;
+    MVMuint32    have_replaceable = 0;
+    MVMint32     i;
+
+    /* Count writes in the whole graph. */
+    es.graph_writes = MVM_calloc(g->num_locals, sizeof(MVMuint32));
+    cur_bb = g->entry;
+    while (cur_bb) {
+        MVMSpeshIns *ins = cur_bb->first_ins;
+        while (ins) {
+            MVMint32 is_phi = ins->info->opcode == MVM_SSA_PHI;
+            for (i = 0; i < ins->info->num_operands; i++)
+                if ((is_phi && i == 0)
+                        || (!is_phi && (ins->info->operands[i] & MVM_operand_rw_mask) == MVM_operand_write_reg))
+                    es.graph_writes[ins->operands[i].reg.orig]++;
+            ins = ins->next;
+        }
+        cur_bb = cur_bb->linear_next;
+    }
+
+    es.candidates = NULL;
+    es.map        = MVM_spesh_alloc(tc, g, g->num_locals * sizeof(Candidate **));
+    find_candidates(tc, g, &es, g->entry);
+
+    for (cand = es.candidates; cand; cand = cand->next) {
+        if (cand->escaped)
+            continue;
+        if (!check_no_deopt(tc, g, &es, cand))
+            cand->escaped = 1;
+        else if (cand->is_box && !value_usable(&es, cand->alloc->operands[1]))
+            cand->escaped = 1;
+        else if (!cand->is_box && !(check_binds(tc, g, &es, cand) && check_gets(tc, g, &es, cand)))
+            cand->escaped = 1;
+        else
+            have_replaceable = 1;
+    }
+
+    if (have_replaceable)
+        replace_candidates(tc, g, &es);
+    MVM_free(es.graph_writes);
+}
@@ -0,0 +1 @@
+void MVM_spesh_escape_eliminate_allocations(MVMThreadContext *tc, MVMSpeshGraph *g);
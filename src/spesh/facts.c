@@ -221,10 +221,16 @@ static void discover_extop(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpeshIns *
 static void log_facts(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpeshBB *bb,
                       MVMSpeshIns *ins, MVMSpeshPlanned *p,
                       MVMSpeshAnn *deopt_one_ann, MVMSpeshAnn *logged_ann) {
-    /* See if we have stable type information. For now, we need consistent
-     * types, since a mis-match will force a deopt. In the future we may be
-     * able to do Basic Block Versioning inspired tricks, like producing two
-     * different code paths ahead when there are a small number of options. */
+    /* See if we have stable type information. Since a mis-match will force a
+     * deopt, we need one type to account for almost all of the values seen.
+     * In the future we may be able to do Basic Block Versioning inspired
+     * tricks, like producing two different code paths ahead when there are a
+     * small number of options. */
+    MVMObject *seen_types[MVM_SPESH_LOG_FACTS_MAX_TYPES];
+    MVMuint32  seen_hits[MVM_SPESH_LOG_FACTS_MAX_TYPES];
+    MVMuint32  seen_concrete[MVM_SPESH_LOG_FACTS_MAX_TYPES];
+    MVMuint32  num_seen = 0;
+    MVMuint32  total_hits = 0;
     MVMObject *agg_type = NULL;
     MVMuint32 agg_type_object = 0;
     MVMuint32 agg_concrete = 0;
@@ -234,26 +240,29 @@ static void log_facts(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpeshBB *bb,
         MVMuint32 j;
         for (j = 0; j < ts->num_by_offset; j++) {
             if (ts->by_offset[j].bytecode_offset == logged_ann->data.bytecode_offset) {
-                /* Go over the logged types. */
+                /* Go over the logged types, totting up hits by type, and how
+                 * many of them were concrete. If there are too many types
+                 * to keep track of, it's certainly not stable. */
                 MVMuint32 num_types = ts->by_offset[j].num_types;
                 MVMuint32 k;
                 for (k = 0; k < num_types; k++) {
-                    /* If it's inconsistent with the aggregated type, then
-                     * bail out; too unstable. Otherwise, take it as the
-                     * aggregated type and tot up type object vs. concrete (we
-                     * assess facts about that at the end) */
-                    MVMObject *cur_type = ts->by_offset[j].types[k].type;
-                    if (agg_type) {
-                        if (agg_type != cur_type)
+                    MVMSpeshStatsTypeCount *type_count = &(ts->by_offset[j].types[k]);
+                    MVMuint32 l;
+                    for (l = 0; l < num_seen; l++)
+                        if (seen_types[l] == type_count->type)
+                            break;
+                    if (l == num_seen) {
+                        if (num_seen == MVM_SPESH_LOG_FACTS_MAX_TYPES)
                             return;
+                        seen_types[l] = type_count->type;
+                        seen_hits[l] = 0;
+                        seen_concrete[l] = 0;
+                        num_seen++;
                     }
-                    else {
-                        agg_type = cur_type;
-                    }
-                    if (ts->by_offset[j].types[k].type_concrete)
-                        agg_concrete++;
-                    else
-                        agg_type_object++;
+                    seen_hits[l] += type_count->count;
+                    if (type_count->type_concrete)
+                        seen_concrete[l] += type_count->count;
+                    total_hits += type_count->count;
                 }
 
                 /* No need to consider searching after this offset. */
@@ -261,6 +270,17 @@ static void log_facts(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpeshBB *bb,
             }
         }
     }
+    if (total_hits) {
+        MVMuint32 best = 0;
+        for (i = 1; i < num_seen; i++)
+            if (seen_hits[i] > seen_hits[best])
+                best = i;
+        if ((100 * seen_hits[best]) / total_hits < MVM_SPESH_LOG_FACTS_STABLE_PERCENT)
+            return;
+        agg_type = seen_types[best];
+        agg_concrete = seen_concrete[best];
+        agg_type_object = seen_hits[best] - seen_concrete[best];
+    }
     if (agg_type) {
         MVMSpeshIns *guard;
         MVMSpeshAnn *ann;
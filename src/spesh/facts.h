@@ -52,6 +52,12 @@ struct MVMSpeshFacts {
 #define MVM_SPESH_FACT_MERGED_WITH_LOG_GUARD 4096 /* These facts were merged at a PHI node, but at least one of the incoming facts had a "from log guard" flag set, so we'll have to look for that fact and increment its uses if we use this here fact. */
 #define MVM_SPESH_FACT_RW_CONT               8192 /* Known to be an rw container */
 
+/* The most distinct types we'll consider at a logged instruction, and the
+ * percentage of the values logged there that must be of a single type for us
+ * to guard on it (meaning that the rest will cause a deopt). */
+#define MVM_SPESH_LOG_FACTS_MAX_TYPES       8
+#define MVM_SPESH_LOG_FACTS_STABLE_PERCENT  99
+
 void MVM_spesh_facts_discover(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpeshPlanned *p);
 void MVM_spesh_facts_depend(MVMThreadContext *tc, MVMSpeshGraph *g,
     MVMSpeshFacts *target, MVMSpeshFacts *source);
@@ -1259,6 +1259,27 @@ MVMSpeshGraph * MVM_spesh_graph_create_from_cand(MVMThreadContext *tc, MVMStatic
     return g;
 }
 
+/* Recomputes the predecessors and the dominator tree of a graph, which may
+ * have been changed by inlining and dead basic block elimination since they
+ * were first computed. (Dominance frontiers are not recomputed, as they are
+ * only needed for SSA construction.) */
+void MVM_spesh_graph_recompute_dominance(MVMThreadContext *tc, MVMSpeshGraph *g) {
+    MVMSpeshBB **rpo;
+    MVMint32    *doms;
+    MVMSpeshBB  *cur_bb = g->entry;
+    while (cur_bb) {
+        cur_bb->num_pred     = 0;
+        cur_bb->num_children = 0;
+        cur_bb = cur_bb->linear_next;
+    }
+    add_predecessors(tc, g);
+    rpo  = reverse_postorder(tc, g);
+    doms = compute_dominators(tc, g, rpo);
+    add_children(tc, g, rpo, doms);
+    MVM_free(rpo);
+    MVM_free(doms);
+}
+
 /* Marks GCables held in a spesh graph. */
 void MVM_spesh_graph_mark(MVMThreadContext *tc, MVMSpeshGraph *g, MVMGCWorklist *worklist) {
     MVMuint16 i, j, num_locals, num_facts, *local_types;
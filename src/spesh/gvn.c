@@ -0,0 +1,372 @@
+#include "moar.h"
+
+/* This file does global value numbering over the SSA form of the spesh
+ * graph, to eliminate redundant computations. We walk the dominator tree,
+ * keeping a table of the computations available from the blocks that
+ * dominate the current one. Registers that are copies of one another (by
+ * set) get the same value number, so computations on them are seen to be
+ * the same too. When a computation is already available, we turn it into a
+ * set of the register holding the earlier result; when a guard is, we just
+ * delete it, since its condition already holds.
+ *
+ * The generated code only knows about the original registers, not the SSA
+ * versions of them, so we may only reuse a result held in an original
+ * register that is never written anywhere else. Attribute lookups and the
+ * like, which read memory that may change, are only reused within a basic
+ * block, and only if nothing that may write to an object happened since. */
+
+/* The kinds of instruction we number. */
+#define GVN_NONE    0
+#define GVN_PURE    1
+#define GVN_LOAD    2
+#define GVN_GUARD   3
+
+static MVMint32 gvn_kind(MVMuint16 opcode) {
+    switch (opcode) {
+        case MVM_OP_sp_getspeshslot:
+        case MVM_OP_wval:
+        case MVM_OP_wval_wide:
+        case MVM_OP_isnull:
+        case MVM_OP_isconcrete:
+        case MVM_OP_add_i:
+        case MVM_OP_sub_i:
+        case MVM_OP_mul_i:
+        case MVM_OP_neg_i:
+        case MVM_OP_band_i:
+        case MVM_OP_bor_i:
+        case MVM_OP_bxor_i:
+        case MVM_OP_bnot_i:
+        case MVM_OP_eq_i:
+        case MVM_OP_ne_i:
+        case MVM_OP_lt_i:
+        case MVM_OP_le_i:
+        case MVM_OP_gt_i:
+        case MVM_OP_ge_i:
+        case MVM_OP_add_n:
+        case MVM_OP_sub_n:
+        case MVM_OP_mul_n:
+        case MVM_OP_div_n:
+        case MVM_OP_neg_n:
+        case MVM_OP_eq_n:
+        case MVM_OP_ne_n:
+        case MVM_OP_lt_n:
+        case MVM_OP_le_n:
+        case MVM_OP_gt_n:
+        case MVM_OP_ge_n:
+        case MVM_OP_coerce_in:
+        case MVM_OP_coerce_ni:
+            return GVN_PURE;
+        case MVM_OP_sp_p6oget_o:
+        case MVM_OP_sp_p6oget_i:
+        case MVM_OP_sp_p6oget_n:
+        case MVM_OP_sp_p6oget_s:
+        case MVM_OP_sp_get_o:
+        case MVM_OP_sp_get_i64:
+        case MVM_OP_sp_get_i32:
+        case MVM_OP_sp_get_i16:
+        case MVM_OP_sp_get_i8:
+        case MVM_OP_sp_get_n:
+        case MVM_OP_sp_get_s:
+        case MVM_OP_getwhat:
+        case MVM_OP_getwho:
+        case MVM_OP_objprimspec:
+        case MVM_OP_elems:
+            return GVN_LOAD;
+        case MVM_OP_sp_guard:
+        case MVM_OP_sp_guardconc:
+        case MVM_OP_sp_guardtype:
+        case MVM_OP_sp_guardsf:
+        case MVM_OP_sp_guardsfouter:
+            return GVN_GUARD;
+        default:
+            return GVN_NONE;
+    }
+}
+
+/* Checks if an instruction may write to an object (or invoke something that
+ * may do so). */
+static MVMint32 may_store(MVMSpeshIns *ins) {
+    if (ins->info->opcode == MVM_SSA_PHI || gvn_kind(ins->info->opcode) == GVN_GUARD)
+        return 0;
+    return !ins->info->pure || (ins->info->jittivity & MVM_JIT_INFO_INVOKISH);
+}
+
+/* The value number of a register version, which is the register version
+ * that first held the value. */
+typedef struct {
+    MVMSpeshOperand reg;
+    MVMuint8        known;
+} ValueNumber;
+
+/* An available computation. */
+typedef struct {
+    /* The instruction that did it. */
+    MVMSpeshIns *ins;
+
+    /* Its hash, and the index of the next entry in the same bucket. */
+    MVMuint32 hash;
+    MVMint32  next;
+
+    /* For loads, the memory epoch it is valid in. */
+    MVMuint32 epoch;
+} Available;
+
+#define GVN_BUCKETS 64
+
+/* State of the numbering. */
+typedef struct {
+    /* Value numbers, per original register and version. */
+    ValueNumber **vn;
+
+    /* Number of writes of each original register in the whole graph. */
+    MVMuint32 *graph_writes;
+
+    /* The available computations, as a stack (popped when we leave the
+     * block that did them), along with hash buckets of them. */
+    Available *avail;
+    MVMint32   num_avail;
+    MVMint32   alloc_avail;
+    MVMint32   buckets[GVN_BUCKETS];
+
+    /* The memory epoch, bumped at the start of each basic block and at any
+     * instruction that may write to an object. */
+    MVMuint32 epoch;
+} GVNState;
+
+static MVMSpeshOperand get_vn(GVNState *gs, MVMSpeshOperand o) {
+    ValueNumber *row = gs->vn[o.reg.orig];
+    return row && row[o.reg.i].known ? row[o.reg.i].reg : o;
+}
+static void set_vn(MVMThreadContext *tc, MVMSpeshGraph *g, GVNState *gs,
+        MVMSpeshOperand o, MVMSpeshOperand value) {
+    if (!gs->vn[o.reg.orig])
+        gs->vn[o.reg.orig] = MVM_spesh_alloc(tc, g,
+            g->fact_counts[o.reg.orig] * sizeof(ValueNumber));
+    gs->vn[o.reg.orig][o.reg.i].reg   = get_vn(gs, value);
+    gs->vn[o.reg.orig][o.reg.i].known = 1;
+}
+
+/* Gets the number of operands of an instruction that are part of the
+ * computation it does, and the index of the first of them. The result
+ * of a computation is not, and nor is the deopt target of a guard. */
+static MVMint32 key_start(MVMint32 kind) {
+    return kind == GVN_GUARD ? 0 : 1;
+}
+static MVMint32 key_end(MVMSpeshIns *ins, MVMint32 kind) {
+    return kind == GVN_GUARD ? ins->info->num_operands - 1 : ins->info->num_operands;
+}
+
+/* Gets the value of a literal operand to hash and compare, or returns zero
+ * if it's of a kind we don't handle. */
+static MVMint32 literal_value(MVMSpeshGraph *g, MVMSpeshIns *ins, MVMint32 i, MVMint64 *value) {
+    MVMSpeshOperand o = ins->operands[i];
+    switch (ins->info->operands[i] & MVM_operand_type_mask) {
+        case MVM_operand_int8:
+        case MVM_operand_uint8:
+            *value = o.lit_i8;
+            return 1;
+        case MVM_operand_int16:
+        case MVM_operand_uint16:
+            *value = o.lit_i16;
+            return 1;
+        case MVM_operand_int32:
+        case MVM_operand_uint32:
+        case MVM_operand_num32:
+            *value = o.lit_i32;
+            return 1;
+        case MVM_operand_int64:
+        case MVM_operand_uint64:
+        case MVM_operand_num64:
+            *value = o.lit_i64;
+            return 1;
+        case MVM_operand_str:
+            *value = o.lit_str_idx;
+            return 1;
+        case MVM_operand_spesh_slot:
+            *value = (MVMint64)(uintptr_t)g->spesh_slots[o.lit_i16];
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/* Hashes the computation an instruction does. Returns zero if it involves
+ * something we can't number. */
+static MVMint32 hash_ins(MVMSpeshGraph *g, GVNState *gs, MVMSpeshIns *ins,
+        MVMint32 kind, MVMuint32 *hash) {
+    MVMuint32 h = ins->info->opcode;
+    MVMint32  i;
+    for (i = key_start(kind); i < key_end(ins, kind); i++) {
+        if ((ins->info->operands[i] & MVM_operand_rw_mask) == MVM_operand_read_reg) {
+            MVMSpeshOperand v = get_vn(gs, ins->operands[i]);
+            h = h * 31 + v.reg.orig;
+            h = h * 31 + (MVMuint32)v.reg.i;
+        }
+        else {
+            MVMint64 value;
+            if ((ins->info->operands[i] & MVM_operand_rw_mask) != MVM_operand_literal ||
+                    !literal_value(g, ins, i, &value))
+                return 0;
+            h = h * 31 + (MVMuint32)(value ^ (value >> 32));
+        }
+    }
+    *hash = h;
+    return 1;
+}
+
+/* Checks if two instructions do the same computation. */
+static MVMint32 same_computation(MVMSpeshGraph *g, GVNState *gs, MVMSpeshIns *a,
+        MVMSpeshIns *b, MVMint32 kind) {
+    MVMint32 i;
+    if (a->info != b->info)
+        return 0;
+    for (i = key_start(kind); i < key_end(a, kind); i++) {
+        if ((a->info->operands[i] & MVM_operand_rw_mask) == MVM_operand_read_reg) {
+            MVMSpeshOperand va = get_vn(gs, a->operands[i]);
+            MVMSpeshOperand vb = get_vn(gs, b->operands[i]);
+            if (va.reg.orig != vb.reg.orig || va.reg.i != vb.reg.i)
+                return 0;
+        }
+        else {
+            MVMint64 la, lb;
+            literal_value(g, a, i, &la);
+            literal_value(g, b, i, &lb);
+            if (la != lb)
+                return 0;
+        }
+    }
+    return 1;
+}
+
+/* Checks if the result of a computation stays in its register, so it can
+ * be used from anywhere the computation dominates. */
+static MVMint32 result_usable(MVMSpeshGraph *g, GVNState *gs, MVMSpeshOperand o) {
+    return gs->graph_writes[o.reg.orig] == 1 && g->facts[o.reg.orig][0].usages == 0;
+}
+
+/* Looks for an available computation the same as the one an instruction
+ * does. */
+static MVMSpeshIns * find_available(MVMSpeshGraph *g, GVNState *gs, MVMSpeshIns *ins,
+        MVMint32 kind, MVMuint32 hash) {
+    MVMint32 idx = gs->buckets[hash % GVN_BUCKETS];
+    while (idx >= 0) {
+        Available *a = &(gs->avail[idx]);
+        if (a->hash == hash && (kind != GVN_LOAD || a->epoch == gs->epoch) &&
+                same_computation(g, gs, a->ins, ins, kind))
+            return a->ins;
+        idx = a->next;
+    }
+    return NULL;
+}
+
+/* Makes a computation available. */
+static void add_available(GVNState *gs, MVMSpeshIns *ins, MVMuint32 hash) {
+    Available *a;
+    if (gs->num_avail == gs->alloc_avail) {
+        gs->alloc_avail = gs->alloc_avail ? gs->alloc_avail * 2 : 32;
+        gs->avail = MVM_realloc(gs->avail, gs->alloc_avail * sizeof(Available));
+    }
+    a        = &(gs->avail[gs->num_avail]);
+    a->ins   = ins;
+    a->hash  = hash;
+    a->epoch = gs->epoch;
+    a->next  = gs->buckets[hash % GVN_BUCKETS];
+    gs->buckets[hash % GVN_BUCKETS] = gs->num_avail++;
+}
+
+/* Turns an instruction into a set of the result of an earlier one that did
+ * the same computation. */
+static void replace_with_set(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpeshIns *ins,
+        MVMSpeshOperand result) {
+    MVMSpeshOperand *operands = MVM_spesh_alloc(tc, g, 2 * sizeof(MVMSpeshOperand));
+    MVMint32 i;
+    for (i = 1; i < ins->info->num_operands; i++)
+        if ((ins->info->operands[i] & MVM_operand_rw_mask) == MVM_operand_read_reg)
+            MVM_spesh_get_facts(tc, g, ins->operands[i])->usages--;
+    MVM_spesh_get_facts(tc, g, result)->usages++;
+    operands[0]   = ins->operands[0];
+    operands[1]   = result;
+    ins->info     = MVM_op_get_op(MVM_OP_set);
+    ins->operands = operands;
+}
+
+/* Visits the blocks in dominator tree order, numbering values. */
+static void gvn_bb(MVMThreadContext *tc, MVMSpeshGraph *g, GVNState *gs, MVMSpeshBB *bb) {
+    MVMint32     mark = gs->num_avail;
+    MVMSpeshIns *ins  = bb->first_ins;
+    MVMint32     i;
+
+    gs->epoch++;
+    while (ins) {
+        MVMSpeshIns *next   = ins->next;
+        MVMuint16    opcode = ins->info->opcode;
+        MVMint32     kind   = gvn_kind(opcode);
+        MVMuint32    hash;
+        if (opcode == MVM_OP_set) {
+            set_vn(tc, g, gs, ins->operands[0], ins->operands[1]);
+        }
+        else if (kind != GVN_NONE && hash_ins(g, gs, ins, kind, &hash)) {
+            MVMSpeshIns *earlier = find_available(g, gs, ins, kind, hash);
+            if (earlier && kind == GVN_GUARD) {
+                MVM_spesh_manipulate_delete_ins(tc, g, bb, ins);
+            }
+            else if (earlier) {
+                MVMSpeshOperand result = earlier->operands[0];
+                replace_with_set(tc, g, ins, result);
+                set_vn(tc, g, gs, ins->operands[0], result);
+            }
+            else if (kind == GVN_GUARD || result_usable(g, gs, ins->operands[0])) {
+                add_available(gs, ins, hash);
+            }
+        }
+        if (may_store(ins))
+            gs->epoch++;
+        ins = next;
+    }
+
+    /* Visit children. */
+    for (i = 0; i < bb->num_children; i++)
+        gvn_bb(tc, g, gs, bb->children[i]);
+
+    /* Computations done in this block are no longer available. */
+    while (gs->num_avail > mark) {
+        Available *a = &(gs->avail[--gs->num_avail]);
+        gs->buckets[a->hash % GVN_BUCKETS] = a->next;
+    }
+}
+
+/* Eliminates redundant computations and guards in a graph, whose dominator
+ * tree must be up to date. */
+void MVM_spesh_gvn_eliminate_redundancy(MVMThreadContext *tc, MVMSpeshGraph *g) {
+    GVNState    gs;
+    MVMSpeshBB *cur_bb;
+    MVMint32    i;
+
+    /* Count writes in the whole graph. */
+    gs.graph_writes = MVM_calloc(g->num_locals, sizeof(MVMuint32));
+    cur_bb = g->entry;
+    while (cur_bb) {
+        MVMSpeshIns *ins = cur_bb->first_ins;
+        while (ins) {
+            MVMint32 is_phi = ins->info->opcode == MVM_SSA_PHI;
+            for (i = 0; i < ins->info->num_operands; i++)
+                if ((is_phi && i == 0)
+                        || (!is_phi && (ins->info->operands[i] & MVM_operand_rw_mask) == MVM_operand_write_reg))
+                    gs.graph_writes[ins->operands[i].reg.orig]++;
+            ins = ins->next;
+        }
+        cur_bb = cur_bb->linear_next;
+    }
+
+    gs.vn          = MVM_spesh_alloc(tc, g, g->num_locals * sizeof(ValueNumber *));
+    gs.avail       = NULL;
+    gs.num_avail   = 0;
+    gs.alloc_avail = 0;
+    gs.epoch       = 0;
+    for (i = 0; i < GVN_BUCKETS; i++)
+        gs.buckets[i] = -1;
+    gvn_bb(tc, g, &gs, g->entry);
+
+    MVM_free(gs.graph_writes);
+    MVM_free(gs.avail);
+}
@@ -0,0 +1 @@
+void MVM_spesh_gvn_eliminate_redundancy(MVMThreadContext *tc, MVMSpeshGraph *g);
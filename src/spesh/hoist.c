@@ -0,0 +1,477 @@
+#include "moar.h"
+
+/* This file does loop invariant code motion. We find the natural loops of
+ * the graph, and move instructions whose result will be the same on every
+ * iteration of the loop to its preheader, so they are done only once. We
+ * do this for:
+ *
+ * - Instructions that only compute a result from registers and cannot throw,
+ *   which we may hoist from anywhere in the loop.
+ * - Attribute lookups, provided nothing in the loop may write to an object
+ *   (that is, everything in it is pure, a branch, or a guard) and there is
+ *   no guard left in the loop on the object we look in.
+ * - Guards at the start of the loop header (that is, before anything that
+ *   is not hoisted). Deoptimizing from the preheader then results in the
+ *   same state as deoptimizing at the loop head would have.
+ *
+ * In the spesh graph an original register may be written by more than one
+ * instruction, provided they are different SSA versions, and the generated
+ * code only knows about the original registers. We thus only hoist an
+ * instruction if no register it reads is written in the loop, and it is the
+ * only write to the register it writes in the loop. Instructions not at the
+ * start of the header are not executed on every entry to the loop, so may
+ * only be hoisted if they are the only write to their register at all.
+ *
+ * A loop head is usually also an OSR point, where a frame running in the
+ * interpreter jumps into the specialized code. Its OSR annotation is moved
+ * to the first hoisted instruction, so that hoisted instructions are run
+ * when entering that way too. */
+
+/* The kinds of instruction we can hoist. */
+#define HOIST_NONE      0
+#define HOIST_REGISTERS 1
+#define HOIST_LOAD      2
+#define HOIST_GUARD     3
+
+static MVMint32 hoist_kind(MVMuint16 opcode) {
+    switch (opcode) {
+        case MVM_OP_const_i8:
+        case MVM_OP_const_i16:
+        case MVM_OP_const_i32:
+        case MVM_OP_const_i64:
+        case MVM_OP_const_n32:
+        case MVM_OP_const_n64:
+        case MVM_OP_const_s:
+        case MVM_OP_const_i64_16:
+        case MVM_OP_const_i64_32:
+        case MVM_OP_null:
+        case MVM_OP_set:
+        case MVM_OP_sp_getspeshslot:
+        case MVM_OP_hllboxtype_i:
+        case MVM_OP_hllboxtype_n:
+        case MVM_OP_hllboxtype_s:
+        case MVM_OP_isnull:
+        case MVM_OP_isconcrete:
+        case MVM_OP_add_i:
+        case MVM_OP_sub_i:
+        case MVM_OP_mul_i:
+        case MVM_OP_neg_i:
+        case MVM_OP_band_i:
+        case MVM_OP_bor_i:
+        case MVM_OP_bxor_i:
+        case MVM_OP_bnot_i:
+        case MVM_OP_eq_i:
+        case MVM_OP_ne_i:
+        case MVM_OP_lt_i:
+        case MVM_OP_le_i:
+        case MVM_OP_gt_i:
+        case MVM_OP_ge_i:
+        case MVM_OP_add_n:
+        case MVM_OP_sub_n:
+        case MVM_OP_mul_n:
+        case MVM_OP_div_n:
+        case MVM_OP_neg_n:
+        case MVM_OP_eq_n:
+        case MVM_OP_ne_n:
+        case MVM_OP_lt_n:
+        case MVM_OP_le_n:
+        case MVM_OP_gt_n:
+        case MVM_OP_ge_n:
+        case MVM_OP_coerce_in:
+        case MVM_OP_coerce_ni:
+            return HOIST_REGISTERS;
+        case MVM_OP_sp_p6oget_o:
+        case MVM_OP_sp_p6oget_i:
+        case MVM_OP_sp_p6oget_n:
+        case MVM_OP_sp_p6oget_s:
+        case MVM_OP_sp_get_o:
+        case MVM_OP_sp_get_i64:
+        case MVM_OP_sp_get_i32:
+        case MVM_OP_sp_get_i16:
+        case MVM_OP_sp_get_i8:
+        case MVM_OP_sp_get_n:
+        case MVM_OP_sp_get_s:
+            return HOIST_LOAD;
+        case MVM_OP_sp_guard:
+        case MVM_OP_sp_guardconc:
+        case MVM_OP_sp_guardtype:
+        case MVM_OP_sp_guardsf:
+        case MVM_OP_sp_guardsfouter:
+            return HOIST_GUARD;
+        default:
+            return HOIST_NONE;
+    }
+}
+
+/* Checks if an instruction may write to an object (or invoke something that
+ * may do so). */
+static MVMint32 may_store(MVMSpeshIns *ins) {
+    switch (ins->info->opcode) {
+        case MVM_SSA_PHI:
+        case MVM_OP_goto:
+        case MVM_OP_if_i:
+        case MVM_OP_unless_i:
+        case MVM_OP_if_n:
+        case MVM_OP_unless_n:
+            return 0;
+        default:
+            if (hoist_kind(ins->info->opcode) == HOIST_GUARD)
+                return 0;
+            return !ins->info->pure || (ins->info->jittivity & MVM_JIT_INFO_INVOKISH);
+    }
+}
+
+/* State of the hoisting. */
+typedef struct {
+    /* The immediate dominator of each basic block, by index. */
+    MVMSpeshBB **idom;
+
+    /* Number of writes of each original register in the whole graph. */
+    MVMuint32 *graph_writes;
+
+    /* The loop we're working on: which basic blocks are in it, the number
+     * of writes of, and guards on, each original register in it (updated
+     * as we hoist), and whether anything in it may write to an object. */
+    MVMuint8  *in_loop;
+    MVMuint32 *loop_writes;
+    MVMuint32 *loop_guards;
+    MVMuint8   may_store;
+
+    /* The loop's header and preheader, and the instruction in the preheader
+     * to insert hoisted instructions after (NULL to insert at its start). */
+    MVMSpeshBB  *header;
+    MVMSpeshBB  *preheader;
+    MVMSpeshIns *insert_after;
+
+    /* The first instruction hoisted from the loop. */
+    MVMSpeshIns *first_hoisted;
+} HoistState;
+
+static MVMint32 dominates(HoistState *hs, MVMSpeshBB *a, MVMSpeshBB *b) {
+    while (b && b != a)
+        b = hs->idom[b->idx];
+    return b == a;
+}
+
+/* Visits the dominator tree recording immediate dominators. */
+static void record_idoms(HoistState *hs, MVMSpeshBB *bb) {
+    MVMint32 i;
+    for (i = 0; i < bb->num_children; i++) {
+        hs->idom[bb->children[i]->idx] = bb;
+        record_idoms(hs, bb->children[i]);
+    }
+}
+
+/* Counts the writes of each original register by an instruction. */
+static void count_writes(MVMSpeshIns *ins, MVMuint32 *writes) {
+    MVMint32 is_phi = ins->info->opcode == MVM_SSA_PHI;
+    MVMint32 i;
+    for (i = 0; i < ins->info->num_operands; i++)
+        if ((is_phi && i == 0)
+                || (!is_phi && (ins->info->operands[i] & MVM_operand_rw_mask) == MVM_operand_write_reg))
+            writes[ins->operands[i].reg.orig]++;
+}
+
+/* Finds the blocks in the loop with the specified header, which is the
+ * header together with everything that can reach a back edge to it without
+ * going through it. */
+static void find_loop(MVMThreadContext *tc, MVMSpeshGraph *g, HoistState *hs,
+        MVMSpeshBB *header) {
+    MVMSpeshBB **stack = MVM_malloc(g->num_bbs * sizeof(MVMSpeshBB *));
+    MVMint32     sp    = 0;
+    MVMint32     i;
+    memset(hs->in_loop, 0, g->num_bbs);
+    hs->in_loop[header->idx] = 1;
+    for (i = 0; i < header->num_pred; i++) {
+        MVMSpeshBB *pred = header->pred[i];
+        if (!hs->in_loop[pred->idx] && dominates(hs, header, pred)) {
+            hs->in_loop[pred->idx] = 1;
+            stack[sp++] = pred;
+        }
+    }
+    while (sp) {
+        MVMSpeshBB *bb = stack[--sp];
+        for (i = 0; i < bb->num_pred; i++) {
+            MVMSpeshBB *pred = bb->pred[i];
+            if (!hs->in_loop[pred->idx]) {
+                hs->in_loop[pred->idx] = 1;
+                stack[sp++] = pred;
+            }
+        }
+    }
+    MVM_free(stack);
+}
+
+/* Finds the annotation marking the OSR point at the loop head, if any. */
+static MVMSpeshAnn * find_osr_ann(MVMSpeshIns *ins) {
+    MVMSpeshAnn *ann = ins ? ins->annotations : NULL;
+    while (ann) {
+        if (ann->type == MVM_SPESH_ANN_DEOPT_OSR)
+            return ann;
+        ann = ann->next;
+    }
+    return NULL;
+}
+
+/* Gets the first instruction of a basic block that is not a PHI. */
+static MVMSpeshIns * first_non_phi(MVMSpeshBB *bb) {
+    MVMSpeshIns *ins = bb->first_ins;
+    while (ins && ins->info->opcode == MVM_SSA_PHI)
+        ins = ins->next;
+    return ins;
+}
+
+/* Sets up the preheader of the loop, which is the only block outside of the
+ * loop that goes to its header, and must go nowhere else. The entry block
+ * may also go to the header, when it's an OSR point. Returns zero if there
+ * is no such block, or we can't add instructions to its end. */
+static MVMint32 find_preheader(MVMThreadContext *tc, MVMSpeshGraph *g, HoistState *hs) {
+    MVMSpeshBB  *header    = hs->header;
+    MVMSpeshBB  *preheader = NULL;
+    MVMSpeshBB  *cur_bb;
+    MVMSpeshIns *last;
+    MVMint32     i;
+    for (i = 0; i < header->num_pred; i++) {
+        MVMSpeshBB *pred = header->pred[i];
+        if (hs->in_loop[pred->idx])
+            continue;
+        if (pred == g->entry) {
+            if (!find_osr_ann(first_non_phi(header)))
+                return 0;
+        }
+        else if (preheader) {
+            return 0;
+        }
+        else {
+            preheader = pred;
+        }
+    }
+    if (!preheader || preheader->num_succ != 1 || preheader->jumplist)
+        return 0;
+
+    /* The loop must be entered only through the header. */
+    cur_bb = g->entry;
+    while (cur_bb) {
+        if (cur_bb != header && hs->in_loop[cur_bb->idx])
+            for (i = 0; i < cur_bb->num_pred; i++)
+                if (!hs->in_loop[cur_bb->pred[i]->idx])
+                    return 0;
+        cur_bb = cur_bb->linear_next;
+    }
+
+    /* Hoisted instructions go before a goto at the end of the preheader, or
+     * after its last instruction if it just falls through to the header. */
+    last = preheader->last_ins;
+    if (last && last->info->opcode == MVM_OP_goto)
+        hs->insert_after = last->prev;
+    else if (!last || (!last->info->jittivity && !last->info->deopt_point))
+        hs->insert_after = last;
+    else
+        return 0;
+    hs->preheader = preheader;
+    return 1;
+}
+
+/* Checks if an instruction can be hoisted. Those at the start of the header
+ * are run every time the loop is entered, before anything else in the loop
+ * happens. */
+static MVMint32 can_hoist(MVMThreadContext *tc, MVMSpeshGraph *g, HoistState *hs,
+        MVMSpeshIns *ins, MVMint32 at_start) {
+    MVMint32     kind = hoist_kind(ins->info->opcode);
+    MVMSpeshAnn *ann  = ins->annotations;
+    MVMint32     i;
+
+    /* Check the kind is one we can hoist from here. */
+    if (kind == HOIST_NONE)
+        return 0;
+    if (kind == HOIST_LOAD && (hs->may_store || hs->loop_guards[ins->operands[1].reg.orig]))
+        return 0;
+    if (kind == HOIST_GUARD && (!at_start || hs->header->inlined || hs->preheader->inlined))
+        return 0;
+
+    /* A guard may take its deopt annotation with it, and anything at the
+     * start a line number; otherwise, annotations mark a position that the
+     * instruction must stay at. */
+    while (ann) {
+        if (!(kind == HOIST_GUARD && ann->type == MVM_SPESH_ANN_DEOPT_ONE_INS) &&
+                !(at_start && ann->type == MVM_SPESH_ANN_LINENO))
+            return 0;
+        ann = ann->next;
+    }
+
+    /* Check the registers read are not written in the loop, and the one
+     * written is not written by anything else. */
+    for (i = 0; i < ins->info->num_operands; i++) {
+        MVMSpeshOperand o  = ins->operands[i];
+        MVMint32        rw = ins->info->operands[i] & MVM_operand_rw_mask;
+        if (rw == MVM_operand_read_reg) {
+            if (hs->loop_writes[o.reg.orig])
+                return 0;
+        }
+        else if (rw == MVM_operand_write_reg) {
+            if (hs->loop_writes[o.reg.orig] != 1)
+                return 0;
+            if (!at_start && (hs->graph_writes[o.reg.orig] != 1 || g->facts[o.reg.orig][0].usages))
+                return 0;
+        }
+        else if (rw != MVM_operand_literal) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/* Moves an instruction from the loop to the preheader. */
+static void hoist(MVMThreadContext *tc, MVMSpeshGraph *g, HoistState *hs,
+        MVMSpeshBB *bb, MVMSpeshIns *ins) {
+    if (ins->prev)
+        ins->prev->next = ins->next;
+    else
+        bb->first_ins = ins->next;
+    if (ins->next)
+        ins->next->prev = ins->prev;
+    else
+        bb->last_ins = ins->prev;
+    MVM_spesh_manipulate_insert_ins(tc, hs->preheader, hs->insert_after, ins);
+    hs->insert_after = ins;
+    if (!hs->first_hoisted)
+        hs->first_hoisted = ins;
+
+    if (hoist_kind(ins->info->opcode) == HOIST_GUARD)
+        hs->loop_guards[ins->operands[0].reg.orig]--;
+    else
+        hs->loop_writes[ins->operands[0].reg.orig]--;
+}
+
+/* Hoists what we can from the blocks of the loop, visiting them in dominator
+ * tree order so we see where a register is written before where it is
+ * read. */
+static void hoist_from_bb(MVMThreadContext *tc, MVMSpeshGraph *g, HoistState *hs,
+        MVMSpeshBB *bb) {
+    MVMSpeshIns *ins = bb->first_ins;
+    MVMint32     i;
+    while (ins) {
+        MVMSpeshIns *next = ins->next;
+        if (can_hoist(tc, g, hs, ins, 0))
+            hoist(tc, g, hs, bb, ins);
+        ins = next;
+    }
+    for (i = 0; i < bb->num_children; i++)
+        if (hs->in_loop[bb->children[i]->idx])
+            hoist_from_bb(tc, g, hs, bb->children[i]);
+}
+
+/* Hoists loop invariant instructions from the loop with the specified
+ * header. */
+static void hoist_from_loop(MVMThreadContext *tc, MVMSpeshGraph *g, HoistState *hs,
+        MVMSpeshBB *header) {
+    MVMSpeshAnn  *osr_ann;
+    MVMSpeshIns  *osr_ins;
+    MVMSpeshIns  *ins;
+    MVMSpeshBB   *cur_bb;
+
+    /* Find the loop and its preheader. */
+    hs->header        = header;
+    hs->first_hoisted = NULL;
+    find_loop(tc, g, hs, header);
+    if (!find_preheader(tc, g, hs))
+        return;
+
+    /* Count writes and guards in the loop, and see if it may store. */
+    memset(hs->loop_writes, 0, g->num_locals * sizeof(MVMuint32));
+    memset(hs->loop_guards, 0, g->num_locals * sizeof(MVMuint32));
+    hs->may_store = 0;
+    cur_bb = g->entry;
+    while (cur_bb) {
+        if (hs->in_loop[cur_bb->idx]) {
+            ins = cur_bb->first_ins;
+            while (ins) {
+                count_writes(ins, hs->loop_writes);
+                if (hoist_kind(ins->info->opcode) == HOIST_GUARD)
+                    hs->loop_guards[ins->operands[0].reg.orig]++;
+                if (may_store(ins))
+                    hs->may_store = 1;
+                ins = ins->next;
+            }
+        }
+        cur_bb = cur_bb->linear_next;
+    }
+
+    /* Take the OSR annotation off the loop head while we hoist. */
+    osr_ins = first_non_phi(header);
+    osr_ann = find_osr_ann(osr_ins);
+    if (osr_ann) {
+        MVMSpeshAnn **prev = &(osr_ins->annotations);
+        while (*prev != osr_ann)
+            prev = &((*prev)->next);
+        *prev = osr_ann->next;
+    }
+
+    /* Hoist from the start of the header, then from anywhere. */
+    ins = osr_ins;
+    while (ins && can_hoist(tc, g, hs, ins, 1)) {
+        MVMSpeshIns *next = ins->next;
+        hoist(tc, g, hs, header, ins);
+        ins = next;
+    }
+    hoist_from_bb(tc, g, hs, header);
+
+    /* Put the OSR annotation on the first hoisted instruction, or back where
+     * it was if we hoisted nothing. */
+    if (osr_ann) {
+        MVMSpeshIns *target = hs->first_hoisted ? hs->first_hoisted : osr_ins;
+        osr_ann->next       = target->annotations;
+        target->annotations = osr_ann;
+    }
+}
+
+/* Visits the dominator tree in post-order, so inner loops are done before
+ * the loops they are in, looking for loop headers (blocks that dominate one
+ * of their predecessors). */
+static void visit_bb(MVMThreadContext *tc, MVMSpeshGraph *g, HoistState *hs, MVMSpeshBB *bb) {
+    MVMint32 i;
+    for (i = 0; i < bb->num_children; i++)
+        visit_bb(tc, g, hs, bb->children[i]);
+    for (i = 0; i < bb->num_pred; i++) {
+        if (dominates(hs, bb, bb->pred[i])) {
+            hoist_from_loop(tc, g, hs, bb);
+            break;
+        }
+    }
+}
+
+/* Hoists loop invariant instructions out of the loops in a graph, whose
+ * dominator tree must be up to date. */
+void MVM_spesh_hoist_loop_invariants(MVMThreadContext *tc, MVMSpeshGraph *g) {
+    HoistState  hs;
+    MVMSpeshBB *cur_bb;
+
+    /* Record immediate dominators. */
+    hs.idom = MVM_calloc(g->num_bbs, sizeof(MVMSpeshBB *));
+    record_idoms(&hs, g->entry);
+
+    /* Count writes in the whole graph. */
+    hs.graph_writes = MVM_calloc(g->num_locals, sizeof(MVMuint32));
+    cur_bb = g->entry;
+    while (cur_bb) {
+        MVMSpeshIns *ins = cur_bb->first_ins;
+        while (ins) {
+            count_writes(ins, hs.graph_writes);
+            ins = ins->next;
+        }
+        cur_bb = cur_bb->linear_next;
+    }
+
+    /* Look for loops. */
+    hs.in_loop     = MVM_malloc(g->num_bbs);
+    hs.loop_writes = MVM_malloc(g->num_locals * sizeof(MVMuint32));
+    hs.loop_guards = MVM_malloc(g->num_locals * sizeof(MVMuint32));
+    visit_bb(tc, g, &hs, g->entry);
+
+    MVM_free(hs.idom);
+    MVM_free(hs.graph_writes);
+    MVM_free(hs.in_loop);
+    MVM_free(hs.loop_writes);
+    MVM_free(hs.loop_guards);
+}
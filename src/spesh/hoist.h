@@ -0,0 +1 @@
+void MVM_spesh_hoist_loop_invariants(MVMThreadContext *tc, MVMSpeshGraph *g);
@@ -207,3 +207,103 @@ void MVM_spesh_log_return_type(MVMThreadContext *tc, MVMObject *value) {
     entry->type.bytecode_offset = 0; /* Not relevant for this case. */
     commit_entry(tc, sl);
 }
+
+/* Moves allocation samples whose survival the GC has since resolved into the
+ * spesh log. If there's no log to write them to, they're just dropped. Takes
+ * care to keep the sample buffer consistent over committing an entry, since
+ * that may trigger GC. */
+static void flush_alloc_samples(MVMThreadContext *tc) {
+    MVMuint32 i = 0;
+    while (i < tc->num_spesh_alloc_samples) {
+        MVMSpeshAllocSample *sample = &(tc->spesh_alloc_samples[i]);
+        if (sample->survived >= 0) {
+            MVMSpeshLog *sl = tc->spesh_log;
+            if (sl) {
+                MVMSpeshLogEntry *entry = &(sl->body.entries[sl->body.used]);
+                entry->kind = MVM_SPESH_LOG_ALLOC;
+                entry->id = 0;
+                MVM_ASSIGN_REF(tc, &(sl->common.header), entry->alloc.sf, sample->sf);
+                entry->alloc.bytecode_offset = sample->bytecode_offset;
+                entry->alloc.survived = (MVMuint8)sample->survived;
+                entry->alloc.pretenured = sample->pretenured;
+            }
+            *sample = tc->spesh_alloc_samples[--tc->num_spesh_alloc_samples];
+            if (sl)
+                commit_entry(tc, sl);
+        }
+        else {
+            i++;
+        }
+    }
+}
+
+/* Samples an allocation, provided we've space to track another one. */
+static void sample_allocation(MVMThreadContext *tc, MVMObject *obj, MVMStaticFrame *sf,
+                              MVMint32 bytecode_offset, MVMuint8 pretenured) {
+    /* Only nursery objects can tell us anything about survival. */
+    if (obj->header.flags & MVM_CF_SECOND_GEN)
+        return;
+    MVMROOT(tc, obj, {
+        MVMROOT(tc, sf, {
+            flush_alloc_samples(tc);
+        });
+    });
+    if (tc->num_spesh_alloc_samples < MVM_SPESH_LOG_ALLOC_SAMPLES) {
+        MVMSpeshAllocSample *sample;
+        if (!tc->spesh_alloc_samples)
+            tc->spesh_alloc_samples = MVM_malloc(MVM_SPESH_LOG_ALLOC_SAMPLES *
+                sizeof(MVMSpeshAllocSample));
+        sample = &(tc->spesh_alloc_samples[tc->num_spesh_alloc_samples++]);
+        sample->obj = (MVMCollectable *)obj;
+        sample->sf = sf;
+        sample->bytecode_offset = bytecode_offset;
+        sample->survived = -1;
+        sample->pretenured = pretenured;
+    }
+}
+
+/* Log an allocation made by the current instruction, so we can find out if
+ * objects allocated there are long-lived. */
+void MVM_spesh_log_allocation(MVMThreadContext *tc, MVMObject *obj) {
+    sample_allocation(tc, obj, tc->cur_frame->static_info,
+        (*(tc->interp_cur_op) - *(tc->interp_bytecode_start)) - 2, 0);
+}
+
+/* Log an allocation made at a site that was already pretenured; these are
+ * made in the nursery, so we see if the site is still long-lived. */
+void MVM_spesh_log_pretenured_allocation(MVMThreadContext *tc, MVMObject *obj,
+                                         MVMStaticFrame *sf, MVMint32 bytecode_offset) {
+    sample_allocation(tc, obj, sf, bytecode_offset, 1);
+}
+
+/* Called by the GC after it has collected the thread's nursery, to find out
+ * what became of the sampled objects. An object copied into the second
+ * generation survived; one that was not copied at all did not; one that was
+ * copied within the nursery must wait for a further collection. */
+void MVM_spesh_log_gc_allocations(MVMThreadContext *tc) {
+    MVMuint32 i;
+    for (i = 0; i < tc->num_spesh_alloc_samples; i++) {
+        MVMSpeshAllocSample *sample = &(tc->spesh_alloc_samples[i]);
+        if (sample->survived < 0) {
+            MVMCollectable *obj = sample->obj;
+            if (obj->flags & MVM_CF_FORWARDER_VALID) {
+                obj = obj->sc_forward_u.forwarder;
+                if (obj->flags & MVM_CF_SECOND_GEN)
+                    sample->survived = 1;
+                else
+                    sample->obj = obj;
+            }
+            else {
+                sample->survived = 0;
+            }
+        }
+    }
+}
+
+/* Marks the static frames of allocation samples. The sampled objects are not
+ * marked, since that would make them all survive. */
+void MVM_spesh_log_gc_mark_allocations(MVMThreadContext *tc, MVMGCWorklist *worklist) {
+    MVMuint32 i;
+    for (i = 0; i < tc->num_spesh_alloc_samples; i++)
+        MVM_gc_worklist_add(tc, worklist, &(tc->spesh_alloc_samples[i].sf));
+}
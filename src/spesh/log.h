@@ -24,6 +24,32 @@ struct MVMSpeshLogGuard {
  * thresholds.c, but we set it higher to allow more data collection. */
 #define MVM_SPESH_LOG_LOGGED_ENOUGH 1000
 
+/* An allocation that was sampled so as to find out whether objects allocated
+ * at its site tend to survive to the second generation. The object pointer
+ * is weak; it is updated or resolved by the GC after each collection. */
+struct MVMSpeshAllocSample {
+    /* The sampled object. */
+    MVMCollectable *obj;
+
+    /* The static frame and bytecode offset of the allocation site. */
+    MVMStaticFrame *sf;
+    MVMint32 bytecode_offset;
+
+    /* Whether the object survived: -1 if not yet known, otherwise 0 or 1. */
+    MVMint8 survived;
+
+    /* Whether it was sampled at a site that was already pretenured. */
+    MVMuint8 pretenured;
+};
+
+/* The maximum number of allocation samples a thread has awaiting the GC at
+ * any one time; further allocations are not sampled until some resolve. */
+#define MVM_SPESH_LOG_ALLOC_SAMPLES 256
+
+/* One in how many allocations at a pretenured site are still made in the
+ * nursery and sampled, so we notice if the site stops being long-lived. */
+#define MVM_SPESH_PRETENURE_SAMPLE_INTERVAL 64
+
 /* Quick check if we are logging, to save function call overhead. */
 MVM_STATIC_INLINE MVMint32 MVM_spesh_log_is_logging(MVMThreadContext *tc) {
     return tc->spesh_log && tc->cur_frame->spesh_correlation_id;
@@ -41,3 +67,8 @@ void MVM_spesh_log_decont(MVMThreadContext *tc, MVMuint8 *prev_op, MVMObject *va
 void MVM_spesh_log_invoke_target(MVMThreadContext *tc, MVMObject *invoke_target,
     MVMint16 was_multi);
 void MVM_spesh_log_return_type(MVMThreadContext *tc, MVMObject *value);
+void MVM_spesh_log_allocation(MVMThreadContext *tc, MVMObject *obj);
+void MVM_spesh_log_pretenured_allocation(MVMThreadContext *tc, MVMObject *obj,
+    MVMStaticFrame *sf, MVMint32 bytecode_offset);
+void MVM_spesh_log_gc_allocations(MVMThreadContext *tc);
+void MVM_spesh_log_gc_mark_allocations(MVMThreadContext *tc, MVMGCWorklist *worklist);
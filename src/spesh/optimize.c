@@ -97,9 +97,131 @@ static void optimize_findmeth_s_perhaps_constant(MVMThreadContext *tc, MVMSpeshG
     }
 }
 
+/* Given an invoke instruction, find its logging bytecode offset. Returns 0
+ * if not found. */
+MVMuint32 find_invoke_offset(MVMThreadContext *tc, MVMSpeshIns *ins) {
+    MVMSpeshAnn *ann = ins->annotations;
+    while (ann) {
+        if (ann->type == MVM_SPESH_ANN_LOGGED)
+            return ann->data.bytecode_offset;
+        ann = ann->next;
+    }
+    return 0;
+}
+
+/* Looks at the invocant types that were logged at the call the method being
+ * looked up is used for. If there are a handful of them that cover almost
+ * all of the calls, and we can resolve the method on each of them, rewrite
+ * to a lookup that checks those types in turn before falling back to a
+ * cached lookup. Returns non-zero if it did so. */
+static MVMint32 optimize_method_lookup_poly(MVMThreadContext *tc, MVMSpeshGraph *g,
+                                            MVMSpeshIns *ins, MVMSpeshPlanned *p) {
+    MVMObject   *types[MVM_SPESH_POLY_MAX_TYPES];
+    MVMObject   *meths[MVM_SPESH_POLY_MAX_TYPES];
+    MVMuint32    type_hits[MVM_SPESH_POLY_MAX_TYPES];
+    MVMuint32    num_types = 0;
+    MVMuint32    total_hits = 0;
+    MVMuint32    poly_hits = 0;
+    MVMuint32    invoke_offset, i;
+    MVMint32     invocant_matches = 0;
+    MVMSpeshIns *invoke = ins->next;
+    MVMSpeshOperand *orig_o;
+    MVMString   *name;
+
+    /* Find the invocation the method is looked up for, checking the object
+     * that we look the method up on is passed as the invocant. */
+    while (invoke) {
+        MVMuint16 opcode = invoke->info->opcode;
+        if (opcode == MVM_OP_invoke_v || opcode == MVM_OP_invoke_i ||
+                opcode == MVM_OP_invoke_n || opcode == MVM_OP_invoke_s ||
+                opcode == MVM_OP_invoke_o)
+            break;
+        if (opcode == MVM_OP_arg_o && invoke->operands[0].lit_i16 == 0)
+            invocant_matches = invoke->operands[1].reg.orig == ins->operands[1].reg.orig
+                && invoke->operands[1].reg.i == ins->operands[1].reg.i;
+        invoke = invoke->next;
+    }
+    if (!invoke || !invocant_matches)
+        return 0;
+    {
+        MVMSpeshOperand code = invoke->operands[invoke->info->opcode == MVM_OP_invoke_v ? 0 : 1];
+        if (code.reg.orig != ins->operands[0].reg.orig || code.reg.i != ins->operands[0].reg.i)
+            return 0;
+    }
+    invoke_offset = find_invoke_offset(tc, invoke);
+    if (!invoke_offset)
+        return 0;
+
+    /* Tally up the invocant types seen at the callsite. */
+    for (i = 0; i < p->num_type_stats; i++) {
+        MVMSpeshStatsByType *ts = p->type_stats[i];
+        MVMuint32 j;
+        for (j = 0; j < ts->num_by_offset; j++) {
+            MVMSpeshStatsByOffset *by_offset = &(ts->by_offset[j]);
+            MVMuint32 k;
+            if (by_offset->bytecode_offset != invoke_offset)
+                continue;
+            for (k = 0; k < by_offset->num_type_tuples; k++) {
+                MVMSpeshStatsTypeTupleCount *tt = &(by_offset->type_tuples[k]);
+                MVMObject *type;
+                MVMuint32 l;
+                total_hits += tt->count;
+                if (tt->cs->flag_count == 0 ||
+                        (tt->cs->arg_flags[0] & MVM_CALLSITE_ARG_MASK) != MVM_CALLSITE_ARG_OBJ)
+                    continue;
+                type = tt->arg_types[0].type;
+                if (!type)
+                    continue;
+                for (l = 0; l < num_types; l++)
+                    if (STABLE(types[l]) == STABLE(type))
+                        break;
+                if (l < num_types) {
+                    type_hits[l] += tt->count;
+                }
+                else if (num_types < MVM_SPESH_POLY_MAX_TYPES) {
+                    types[num_types] = type;
+                    type_hits[num_types] = tt->count;
+                    num_types++;
+                }
+            }
+        }
+    }
+    for (i = 0; i < num_types; i++)
+        poly_hits += type_hits[i];
+    if (num_types < 2 || !total_hits ||
+            (100 * poly_hits) / total_hits < MVM_SPESH_POLY_COVERED_PERCENT)
+        return 0;
+
+    /* Resolve the method on each of the types. */
+    name = MVM_spesh_get_string(tc, g, ins->operands[2]);
+    for (i = 0; i < num_types; i++) {
+        meths[i] = MVM_spesh_try_find_method(tc, types[i], name);
+        if (MVM_is_null(tc, meths[i]))
+            return 0;
+    }
+
+    /* Rewrite the instruction, placing the type/method pairs followed by a
+     * pair for the cache into consecutive spesh slots. */
+    orig_o = ins->operands;
+    ins->info = MVM_op_get_op(MVM_OP_sp_findmeth_poly);
+    ins->operands = MVM_spesh_alloc(tc, g, 5 * sizeof(MVMSpeshOperand));
+    memcpy(ins->operands, orig_o, 3 * sizeof(MVMSpeshOperand));
+    for (i = 0; i < num_types; i++) {
+        MVMint16 ss = MVM_spesh_add_spesh_slot(tc, g, (MVMCollectable *)STABLE(types[i]));
+        MVM_spesh_add_spesh_slot(tc, g, (MVMCollectable *)meths[i]);
+        if (i == 0)
+            ins->operands[3].lit_i16 = ss;
+    }
+    MVM_spesh_add_spesh_slot(tc, g, NULL);
+    MVM_spesh_add_spesh_slot(tc, g, NULL);
+    ins->operands[4].lit_i16 = num_types;
+    return 1;
+}
+
 /* Performs optimization on a method lookup. If we know the type that we'll
  * be dispatching on, resolve it right off. If not, add a cache. */
-static void optimize_method_lookup(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpeshIns *ins) {
+static void optimize_method_lookup(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpeshIns *ins,
+                                   MVMSpeshPlanned *p) {
     /* See if we can resolve the method right off due to knowing the type. */
     MVMSpeshFacts *obj_facts = MVM_spesh_get_facts(tc, g, ins->operands[1]);
     MVMint32 resolved = 0;
@@ -127,10 +249,11 @@ static void optimize_method_lookup(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSp
         }
     }
 
-    /* If not, add space to cache a single type/method pair, to save hash
-     * lookups in the (common) monomorphic case, and rewrite to caching
-     * version of the instruction. */
-    if (!resolved) {
+    /* If not, see if the callsite has been polymorphic over a few types we
+     * can resolve it for up front. Failing that, add space to cache a single
+     * type/method pair, to save hash lookups in the (common) monomorphic
+     * case, and rewrite to caching version of the instruction. */
+    if (!resolved && !optimize_method_lookup_poly(tc, g, ins, p)) {
         MVMSpeshOperand *orig_o = ins->operands;
         ins->info = MVM_op_get_op(MVM_OP_sp_findmeth);
         ins->operands = MVM_spesh_alloc(tc, g, 4 * sizeof(MVMSpeshOperand));
@@ -1052,6 +1175,43 @@ static void optimize_getlex_known(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpe
     }
 }
 
+/* Turns a fast object creation into one straight in the second generation
+ * if the logged allocation site was seen to produce objects that nearly all
+ * survive to there, saving copying them out of the nursery twice. */
+static void optimize_pretenure(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpeshIns *ins) {
+    MVMStaticFrameSpesh *spesh = g->sf->body.spesh;
+    MVMSpeshStats *ss = spesh->body.spesh_stats;
+    MVMSpeshAnn *ann = ins->annotations;
+    MVMuint32 i;
+    if (!ss || spesh->body.pretenure_revoked)
+        return;
+    while (ann) {
+        if (ann->type == MVM_SPESH_ANN_LOGGED)
+            break;
+        ann = ann->next;
+    }
+    if (!ann)
+        return;
+    for (i = 0; i < ss->num_alloc_sites; i++) {
+        MVMSpeshStatsAllocSite *site = &(ss->alloc_sites[i]);
+        if (site->bytecode_offset == ann->data.bytecode_offset) {
+            if (site->samples >= MVM_SPESH_PRETENURE_MIN_SAMPLES &&
+                    site->survivors * 100 >= site->samples * MVM_SPESH_PRETENURE_SURVIVAL_PERCENT) {
+                MVMSpeshOperand *operands = MVM_spesh_alloc(tc, g, 5 * sizeof(MVMSpeshOperand));
+                operands[0] = ins->operands[0];
+                operands[1] = ins->operands[1];
+                operands[2] = ins->operands[2];
+                operands[3].lit_i16 = MVM_spesh_add_spesh_slot_try_reuse(tc, g,
+                    (MVMCollectable *)g->sf);
+                operands[4].lit_i32 = ann->data.bytecode_offset;
+                ins->info = MVM_op_get_op(MVM_OP_sp_fastcreate_gen2);
+                ins->operands = operands;
+            }
+            return;
+        }
+    }
+}
+
 /* Optimizes away a lexical lookup when we know the value won't change for a
  * given invocant type (this relies on us being in a typed specialization). */
 static void optimize_getlex_per_invocant(MVMThreadContext *tc, MVMSpeshGraph *g,
@@ -1101,18 +1261,6 @@ static MVMint32 try_find_spesh_candidate(MVMThreadContext *tc, MVMStaticFrame *s
         : MVM_spesh_arg_guard_run_callinfo(tc, ag, arg_info);
 }
 
-/* Given an invoke instruction, find its logging bytecode offset. Returns 0
- * if not found. */
-MVMuint32 find_invoke_offset(MVMThreadContext *tc, MVMSpeshIns *ins) {
-    MVMSpeshAnn *ann = ins->annotations;
-    while (ann) {
-        if (ann->type == MVM_SPESH_ANN_LOGGED)
-            return ann->data.bytecode_offset;
-        ann = ann->next;
-    }
-    return 0;
-}
-
 /* Given an instruction, finds the deopt target on it. Panics if there is not
  * one there. */
 MVMuint32 find_deopt_target(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpeshIns *ins) {
@@ -1989,7 +2137,7 @@ static void optimize_bb(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpeshBB *bb,
             if (ins->info->opcode == MVM_OP_findmeth_s)
                 break;
         case MVM_OP_findmeth:
-            optimize_method_lookup(tc, g, ins);
+            optimize_method_lookup(tc, g, ins, p);
             break;
         case MVM_OP_can:
         case MVM_OP_can_s:
@@ -2073,8 +2221,12 @@ static void optimize_bb(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpeshBB *bb,
         case MVM_OP_decont_n:
         case MVM_OP_decont_s:
         case MVM_OP_decont_u:
+            optimize_repr_op(tc, g, bb, ins, 1);
+            break;
         case MVM_OP_create:
             optimize_repr_op(tc, g, bb, ins, 1);
+            if (ins->info->opcode == MVM_OP_sp_fastcreate && !bb->inlined)
+                optimize_pretenure(tc, g, ins);
             break;
         case MVM_OP_box_i:
         case MVM_OP_box_n:
@@ -2289,6 +2441,10 @@ void MVM_spesh_optimize(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpeshPlanned
     MVM_spesh_eliminate_dead_bbs(tc, g, 1);
     eliminate_unused_log_guards(tc, g);
     eliminate_pointless_gotos(tc, g);
+    MVM_spesh_escape_eliminate_allocations(tc, g);
+    MVM_spesh_graph_recompute_dominance(tc, g);
+    MVM_spesh_gvn_eliminate_redundancy(tc, g);
     eliminate_dead_ins(tc, g);
+    MVM_spesh_hoist_loop_invariants(tc, g);
     second_pass(tc, g, g->entry);
 }
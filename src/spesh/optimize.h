@@ -6,6 +6,12 @@
  * So if this is 99, then we expect 1% of calls may deopt. */
 #define MVM_SPESH_CALLSITE_STABLE_PERCENT 99
 
+/* Maximum number of invocant types a method lookup will check for before it
+ * falls back to its cache, and the percentage of the calls logged at the
+ * callsite that those types must account for. */
+#define MVM_SPESH_POLY_MAX_TYPES        4
+#define MVM_SPESH_POLY_COVERED_PERCENT  90
+
 /* Information we've gathered about the current call we're optimizing, and the
  * arguments it will take. */
 struct MVMSpeshCallInfo {
@@ -85,6 +85,7 @@ void perform_osr(MVMThreadContext *tc, MVMSpeshCandidate *specialized) {
     /* Set up frame to point to spesh candidate/slots. */
     tc->cur_frame->effective_spesh_slots = specialized->spesh_slots;
     tc->cur_frame->spesh_cand            = specialized;
+    specialized->entry_count++;
 
     /* Move into the optimized (and maybe JIT-compiled) code. */
     jc = specialized->jitcode;
@@ -61,8 +61,8 @@ void plan_for_cs(MVMThreadContext *tc, MVMSpeshPlan *plan, MVMStaticFrame *sf,
         MVMuint32 osr_hit_percent = by_cs->osr_hits
             ? (100 * by_type->osr_hits) / by_cs->osr_hits
             : 0;
-        if (by_cs->cs && (hit_percent >= MVM_SPESH_PLAN_TT_OBS_PERCENT ||
-                osr_hit_percent >= MVM_SPESH_PLAN_TT_OBS_PERCENT_OSR)) {
+        if (by_cs->cs && (hit_percent >= tc->instance->spesh_type_tuple_percent ||
+                osr_hit_percent >= tc->instance->spesh_type_tuple_percent)) {
             MVMSpeshStatsByType **evidence = MVM_malloc(sizeof(MVMSpeshStatsByType *));
             evidence[0] = by_type;
             add_planned(tc, plan, MVM_SPESH_PLANNED_OBSERVED_TYPES, sf, by_cs,
@@ -78,7 +78,7 @@ void plan_for_cs(MVMThreadContext *tc, MVMSpeshPlan *plan, MVMStaticFrame *sf,
     /* If there are enough unaccounted for hits by type specializations, then
      * plan a certain specialization. */
     if (unaccounted_hits && unaccounted_hits >= MVM_spesh_threshold(tc, sf) ||
-            unaccounted_osr_hits >= MVM_SPESH_PLAN_CS_MIN_OSR)
+            unaccounted_osr_hits >= MVM_spesh_threshold_osr(tc))
         add_planned(tc, plan, MVM_SPESH_PLANNED_CERTAIN, sf, by_cs, NULL, NULL, 0);
 }
 
@@ -87,18 +87,32 @@ void plan_for_cs(MVMThreadContext *tc, MVMSpeshPlan *plan, MVMStaticFrame *sf,
 void plan_for_sf(MVMThreadContext *tc, MVMSpeshPlan *plan, MVMStaticFrame *sf) {
     MVMSpeshStats *ss = sf->body.spesh->body.spesh_stats;
     MVMuint32 threshold = MVM_spesh_threshold(tc, sf);
-    if (ss->hits >= threshold || ss->osr_hits >= MVM_SPESH_PLAN_SF_MIN_OSR) {
+    MVMuint32 osr_threshold = MVM_spesh_threshold_osr(tc);
+    if (ss->hits >= threshold || ss->osr_hits >= osr_threshold) {
         /* The frame is hot enough; look through its callsites to see if any
          * of those are. */
         MVMuint32 i;
         for (i = 0; i < ss->num_by_callsite; i++) {
             MVMSpeshStatsByCallsite *by_cs = &(ss->by_callsite[i]);
-            if (by_cs->hits >= threshold || by_cs->osr_hits >= MVM_SPESH_PLAN_CS_MIN_OSR)
+            if (by_cs->hits >= threshold || by_cs->osr_hits >= osr_threshold)
                 plan_for_cs(tc, plan, sf, by_cs);
         }
     }
 }
 
+/* Plans the specializations recorded for a static frame in the persistent
+ * specialization cache that can be resolved now. Returns how many. */
+MVMuint32 plan_from_cache(MVMThreadContext *tc, MVMSpeshPlan *plan, MVMStaticFrame *sf) {
+    MVMSpeshCacheResolved *resolved;
+    MVMuint32 n = MVM_spesh_cache_resolve(tc, sf, &resolved);
+    MVMuint32 i;
+    for (i = 0; i < n; i++)
+        add_planned(tc, plan, MVM_SPESH_PLANNED_CACHED, sf, resolved[i].cs_stats,
+            resolved[i].type_tuple, NULL, 0);
+    MVM_free(resolved);
+    return n;
+}
+
 /* Sorts the plan in descending order of maximum call depth. */
 void sort_plan(MVMThreadContext *tc, MVMSpeshPlanned *planned, MVMuint32 n) {
     if (n >= 2) {
@@ -132,9 +146,15 @@ MVMSpeshPlan * MVM_spesh_plan(MVMThreadContext *tc, MVMObject *updated_static_fr
 #endif
     for (i = 0; i < updated; i++) {
         MVMObject *sf = MVM_repr_at_pos_o(tc, updated_static_frames, i);
-        plan_for_sf(tc, plan, (MVMStaticFrame *)sf);
+
+        /* If we have specializations of the frame from the cache, produce
+         * them first; the statistics will be considered next time. */
+        if (!tc->instance->spesh_cache || !plan_from_cache(tc, plan, (MVMStaticFrame *)sf))
+            plan_for_sf(tc, plan, (MVMStaticFrame *)sf);
     }
     sort_plan(tc, plan->planned, plan->num_planned);
+    if (tc->instance->spesh_cache)
+        MVM_spesh_cache_record(tc, plan);
 #if MVM_GC_DEBUG
     tc->in_spesh = 0;
 #endif
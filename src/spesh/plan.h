@@ -1,17 +1,14 @@
-/* The minimum number OSR hits a static frame as a whole has to receive
- * (across all callsites and type tuples) before it is hot enough to further
- * consider. */
-#define MVM_SPESH_PLAN_SF_MIN_OSR   100
-
-/* The minimum number of hits or OSR hits a given static frame and interned
- * callsite combination have to have before it is hot enough to further
- * consider. */
-#define MVM_SPESH_PLAN_CS_MIN_OSR   100
-
-/* The percentage of hits or OSR hits that a type tuple should receive, out of
- * the total callsite hits, to receive an "observed types" specialization. */
-#define MVM_SPESH_PLAN_TT_OBS_PERCENT       25
-#define MVM_SPESH_PLAN_TT_OBS_PERCENT_OSR   25
+/* The default minimum number of OSR hits a static frame as a whole has to
+ * receive (across all callsites and type tuples), and that a given static
+ * frame and interned callsite combination have to have, before it is hot
+ * enough to further consider. Scaled in the same way as the hit thresholds;
+ * set by MVM_SPESH_OSR_THRESHOLD. */
+#define MVM_SPESH_PLAN_MIN_OSR  100
+
+/* The default percentage of hits or OSR hits that a type tuple should
+ * receive, out of the total callsite hits, to receive an "observed types"
+ * specialization; set by MVM_SPESH_TYPE_TUPLE_PERCENT. */
+#define MVM_SPESH_PLAN_TT_OBS_PERCENT   25
 
 /* The plan of what specializations to produce. */
 struct MVMSpeshPlan {
@@ -36,7 +33,11 @@ typedef enum {
     /* A specialization based on analysis of various argument types that
      * showed up. This may happen when one argument type is predcitable, but
      * others are not. */
-    MVM_SPESH_PLANNED_DERIVED_TYPES
+    MVM_SPESH_PLANNED_DERIVED_TYPES,
+
+    /* A specialization recorded in the persistent specialization cache by
+     * an earlier run. */
+    MVM_SPESH_PLANNED_CACHED
 } MVMSpeshPlannedKind;
 
 /* An planned specialization that should be produced. */
@@ -443,6 +443,44 @@ void add_static_value(MVMThreadContext *tc, MVMSpeshSimStackFrame *simf, MVMint3
     MVM_ASSIGN_REF(tc, &(simf->sf->body.spesh->common.header), ss->static_values[id].value, value);
 }
 
+/* Records whether a sampled allocation survived. Should a site we already
+ * pretenure no longer be producing long-lived objects, pretenuring in its
+ * frame is revoked. */
+void add_alloc_sample(MVMThreadContext *tc, MVMSpeshLogEntry *e, MVMObject *sf_updated) {
+    MVMStaticFrame *sf = e->alloc.sf;
+    MVMSpeshStats *ss = stats_for(tc, sf);
+    MVMSpeshStatsAllocSite *site = NULL;
+    MVMuint32 i;
+    if (ss->last_update != tc->instance->spesh_stats_version) {
+        ss->last_update = tc->instance->spesh_stats_version;
+        MVM_repr_push_o(tc, sf_updated, (MVMObject *)sf);
+    }
+    for (i = 0; i < ss->num_alloc_sites; i++) {
+        if (ss->alloc_sites[i].bytecode_offset == e->alloc.bytecode_offset) {
+            site = &(ss->alloc_sites[i]);
+            break;
+        }
+    }
+    if (!site) {
+        ss->alloc_sites = MVM_realloc(ss->alloc_sites,
+            (ss->num_alloc_sites + 1) * sizeof(MVMSpeshStatsAllocSite));
+        site = &(ss->alloc_sites[ss->num_alloc_sites++]);
+        site->bytecode_offset = e->alloc.bytecode_offset;
+        site->samples = 0;
+        site->survivors = 0;
+    }
+    if (site->samples == MVM_SPESH_STATS_ALLOC_SITE_WINDOW) {
+        site->samples /= 2;
+        site->survivors /= 2;
+    }
+    site->samples++;
+    if (e->alloc.survived)
+        site->survivors++;
+    if (e->alloc.pretenured && site->samples >= MVM_SPESH_PRETENURE_MIN_SAMPLES &&
+            site->survivors * 100 < site->samples * MVM_SPESH_PRETENURE_REVOKE_PERCENT)
+        sf->body.spesh->body.pretenure_revoked = 1;
+}
+
 /* Decides whether to save or free the simulation stack. */
 static void save_or_free_sim_stack(MVMThreadContext *tc, MVMSpeshSimStack *sims,
                                    MVMThreadContext *save_on_tc, MVMObject *sf_updated) {
@@ -615,6 +653,12 @@ void MVM_spesh_stats_update(MVMThreadContext *tc, MVMSpeshLog *sl, MVMObject *sf
                 }
                 break;
             }
+            case MVM_SPESH_LOG_ALLOC: {
+                /* Resolved after the allocating frame may have returned, so
+                 * attributed by static frame rather than the sim stack. */
+                add_alloc_sample(tc, e, sf_updated);
+                break;
+            }
         }
     }
     save_or_free_sim_stack(tc, sims, log_from_tc, sf_updated);
@@ -623,12 +667,105 @@ void MVM_spesh_stats_update(MVMThreadContext *tc, MVMSpeshLog *sl, MVMObject *sf
 #endif
 }
 
+/* Works out roughly how much memory a set of statistics takes up. */
+static size_t stats_size(MVMSpeshStats *ss) {
+    size_t size = sizeof(MVMSpeshStats)
+        + ss->num_by_callsite * sizeof(MVMSpeshStatsByCallsite)
+        + ss->num_static_values * sizeof(MVMSpeshStatsStatic)
+        + ss->num_alloc_sites * sizeof(MVMSpeshStatsAllocSite);
+    MVMuint32 i, j, k, l;
+    for (i = 0; i < ss->num_by_callsite; i++) {
+        MVMSpeshStatsByCallsite *by_cs = &(ss->by_callsite[i]);
+        size_t tt_size = by_cs->cs ? by_cs->cs->flag_count * sizeof(MVMSpeshStatsType) : 0;
+        size += by_cs->num_by_type * (sizeof(MVMSpeshStatsByType) + tt_size);
+        for (j = 0; j < by_cs->num_by_type; j++) {
+            MVMSpeshStatsByType *by_type = &(by_cs->by_type[j]);
+            size += by_type->num_by_offset * sizeof(MVMSpeshStatsByOffset);
+            for (k = 0; k < by_type->num_by_offset; k++) {
+                MVMSpeshStatsByOffset *by_offset = &(by_type->by_offset[k]);
+                size += by_offset->num_types * sizeof(MVMSpeshStatsTypeCount)
+                    + by_offset->num_invokes * sizeof(MVMSpeshStatsInvokeCount)
+                    + by_offset->num_type_tuples * sizeof(MVMSpeshStatsTypeTupleCount);
+                for (l = 0; l < by_offset->num_type_tuples; l++)
+                    size += by_offset->type_tuples[l].cs->flag_count * sizeof(MVMSpeshStatsType);
+            }
+        }
+    }
+    return size;
+}
+
+/* A frame with statistics that we may evict to stay within budget. */
+typedef struct {
+    MVMStaticFrame *sf;
+    size_t size;
+    MVMuint32 last_update;
+} EvictionCandidate;
+static int compare_last_update(const void *a, const void *b) {
+    MVMuint32 ua = ((const EvictionCandidate *)a)->last_update;
+    MVMuint32 ub = ((const EvictionCandidate *)b)->last_update;
+    return ua < ub ? -1 : ua > ub ? 1 : 0;
+}
+
+/* Throws out the statistics of the frames that were updated least recently
+ * until those that remain fit into the budget. */
+static size_t evict_to_budget(MVMThreadContext *tc, MVMObject *check_frames, size_t total) {
+    MVMInstance *instance = tc->instance;
+    MVMint64 elems = MVM_repr_elems(tc, check_frames);
+    EvictionCandidate *cands = MVM_malloc(elems * sizeof(EvictionCandidate));
+    MVMint64 i;
+    for (i = 0; i < elems; i++) {
+        MVMStaticFrame *sf = (MVMStaticFrame *)MVM_repr_at_pos_o(tc, check_frames, i);
+        MVMSpeshStats *ss = sf->body.spesh->body.spesh_stats;
+        cands[i].sf = sf;
+        cands[i].size = stats_size(ss);
+        cands[i].last_update = ss->last_update;
+    }
+    qsort(cands, elems, sizeof(EvictionCandidate), compare_last_update);
+    for (i = 0; i < elems && total > instance->spesh_stats_budget; i++) {
+        MVMStaticFrameSpesh *spesh = cands[i].sf->body.spesh;
+        MVM_spesh_stats_destroy(tc, spesh->body.spesh_stats);
+        spesh->body.spesh_stats = NULL;
+        total -= cands[i].size;
+        instance->spesh_stats_evicted++;
+    }
+    MVM_free(cands);
+    return total;
+}
+
+#if MVM_GC_DEBUG
+/* Checks that the totals we're about to report are those of the statistics
+ * still alive, with each frame counted once. */
+static void check_totals(MVMThreadContext *tc, MVMObject *check_frames, size_t total) {
+    MVMint64 elems = MVM_repr_elems(tc, check_frames);
+    MVMint64 i, j;
+    size_t actual = 0;
+    for (i = 0; i < elems; i++) {
+        MVMObject *sf = MVM_repr_at_pos_o(tc, check_frames, i);
+        MVMSpeshStats *ss = ((MVMStaticFrame *)sf)->body.spesh->body.spesh_stats;
+        if (!ss)
+            MVM_oops(tc, "Spesh stats cleanup kept a frame without statistics");
+        for (j = 0; j < i; j++)
+            if (MVM_repr_at_pos_o(tc, check_frames, j) == sf)
+                MVM_oops(tc, "Spesh stats cleanup kept a frame twice");
+        actual += stats_size(ss);
+    }
+    if (actual != total)
+        MVM_oops(tc, "Spesh stats cleanup counted %"MVM_PRSz" bytes, but %"MVM_PRSz" are live",
+            total, actual);
+}
+#endif
+
 /* Takes an array of frames we recently updated the stats in. If they weren't
- * updated in a while, clears them out. */
+ * updated in a while, clears them out. If the statistics that remain are over
+ * the memory budget, clears out those of the frames updated least recently
+ * too. A frame may be in the array more than once, if it was updated in more
+ * than one round; only the first is kept. */
 void MVM_spesh_stats_cleanup(MVMThreadContext *tc, MVMObject *check_frames) {
     MVMint64 elems = MVM_repr_elems(tc, check_frames);
     MVMint64 insert_pos = 0;
     MVMint64 i;
+    MVMuint32 version = tc->instance->spesh_stats_version;
+    size_t total = 0;
     for (i = 0; i < elems; i++) {
         MVMStaticFrame *sf = (MVMStaticFrame *)MVM_repr_at_pos_o(tc, check_frames, i);
         MVMStaticFrameSpesh *spesh = sf->body.spesh;
@@ -637,15 +774,60 @@ void MVM_spesh_stats_cleanup(MVMThreadContext *tc, MVMObject *check_frames) {
             /* No stats; already destroyed, don't keep this frame under
              * consideration. */
         }
-        else if (tc->instance->spesh_stats_version - ss->last_update > MVM_SPESH_STATS_MAX_AGE) {
+        else if (ss->last_cleanup == version) {
+            /* Already seen this time around. */
+        }
+        else if (spesh->body.spesh_stats_stale ||
+                tc->instance->spesh_stats_version - ss->last_update > MVM_SPESH_STATS_MAX_AGE) {
+            /* Too old, or a specialization made from them was retired. */
             MVM_spesh_stats_destroy(tc, ss);
             spesh->body.spesh_stats = NULL;
+            spesh->body.spesh_stats_stale = 0;
         }
         else {
+            ss->last_cleanup = version;
             MVM_repr_bind_pos_o(tc, check_frames, insert_pos++, (MVMObject *)sf);
+            total += stats_size(ss);
         }
     }
     MVM_repr_pos_set_elems(tc, check_frames, insert_pos);
+
+    /* Enforce the memory budget, if there is one. */
+    if (tc->instance->spesh_stats_budget && total > tc->instance->spesh_stats_budget) {
+        total = evict_to_budget(tc, check_frames, total);
+        elems = insert_pos;
+        insert_pos = 0;
+        for (i = 0; i < elems; i++) {
+            MVMObject *sf = MVM_repr_at_pos_o(tc, check_frames, i);
+            if (((MVMStaticFrame *)sf)->body.spesh->body.spesh_stats)
+                MVM_repr_bind_pos_o(tc, check_frames, insert_pos++, sf);
+        }
+        MVM_repr_pos_set_elems(tc, check_frames, insert_pos);
+    }
+#if MVM_GC_DEBUG
+    check_totals(tc, check_frames, total);
+#endif
+    tc->instance->spesh_stats_bytes = total;
+    tc->instance->spesh_stats_frames = (MVMuint32)insert_pos;
+}
+
+/* Gets a hash describing the memory used by the specializer: its statistics
+ * (as of the last time the worker cleaned them up), and the region allocator
+ * blocks used for spesh graphs. */
+MVMObject * MVM_spesh_stats_memory(MVMThreadContext *tc) {
+    MVMInstance  *instance = tc->instance;
+    MVMHLLConfig *hll      = MVM_hll_current(tc);
+    MVMObject    *result;
+    MVM_gc_allocate_gen2_default_set(tc);
+    result = MVM_repr_alloc_init(tc, hll->slurpy_hash_type);
+    MVM_repr_bind_stat(tc, result, "stats_bytes", instance->spesh_stats_bytes);
+    MVM_repr_bind_stat(tc, result, "stats_frames", instance->spesh_stats_frames);
+    MVM_repr_bind_stat(tc, result, "stats_budget", instance->spesh_stats_budget);
+    MVM_repr_bind_stat(tc, result, "stats_evicted", instance->spesh_stats_evicted);
+    MVM_repr_bind_stat(tc, result, "graph_bytes", MVM_load(&instance->region_bytes));
+    MVM_repr_bind_stat(tc, result, "graph_blocks_reused", MVM_load(&instance->region_blocks_reused));
+    MVM_gc_allocate_gen2_default_clear(tc);
+    return result;
 }
 
 void MVM_spesh_stats_gc_mark(MVMThreadContext *tc, MVMSpeshStats *ss, MVMGCWorklist *worklist) {
@@ -704,6 +886,7 @@ void MVM_spesh_stats_destroy(MVMThreadContext *tc, MVMSpeshStats *ss) {
         }
         MVM_free(ss->by_callsite);
         MVM_free(ss->static_values);
+        MVM_free(ss->alloc_sites);
     }
 }
 
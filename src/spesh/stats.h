@@ -15,6 +15,11 @@ struct MVMSpeshStats {
     /* The number of entries in static_values. */
     MVMuint32 num_static_values;
 
+    /* Survival statistics for sampled allocation sites, used to decide on
+     * pretenuring, and the number of entries in it. */
+    MVMSpeshStatsAllocSite *alloc_sites;
+    MVMuint32 num_alloc_sites;
+
     /* Total calls across all callsites. */
     MVMuint32 hits;
 
@@ -25,6 +30,11 @@ struct MVMSpeshStats {
      * help decide when to throw out data that is no longer evolving, to
      * reduce memory use. */
     MVMuint32 last_update;
+
+    /* The version of the statistics when the frame was last seen by the
+     * cleanup, so a frame that is in its list more than once is only
+     * counted once. */
+    MVMuint32 last_cleanup;
 };
 
 /* Statistics by callsite. */
@@ -154,10 +164,37 @@ struct MVMSpeshStatsStatic {
     MVMint32 bytecode_offset;
 };
 
+/* Allocation site survival statistics. */
+struct MVMSpeshStatsAllocSite {
+    /* The bytecode offset of the allocating instruction. */
+    MVMint32 bytecode_offset;
+
+    /* The number of sampled allocations, and how many of them survived to
+     * the second generation. */
+    MVMuint32 samples;
+    MVMuint32 survivors;
+};
+
+/* Once an allocation site has this many samples, the counts are halved, so
+ * that the survival rate follows changes in program behavior. */
+#define MVM_SPESH_STATS_ALLOC_SITE_WINDOW 1024
+
+/* The number of samples an allocation site needs before we will pretenure
+ * it, and the percentage of them that must have survived. */
+#define MVM_SPESH_PRETENURE_MIN_SAMPLES 32
+#define MVM_SPESH_PRETENURE_SURVIVAL_PERCENT 90
+
+/* If the survival rate of a pretenured site drops below this percentage, we
+ * stop pretenuring in its frame. */
+#define MVM_SPESH_PRETENURE_REVOKE_PERCENT 50
+
 /* The maximum number of spesh stats updates before we consider a frame's
  * stats out of date and throw them out. */
 #define MVM_SPESH_STATS_MAX_AGE 10
 
+/* The default memory budget for statistics, in bytes. */
+#define MVM_SPESH_STATS_DEFAULT_BUDGET (64 * 1024 * 1024)
+
 /* Logs are linear recordings marked with frame correlation IDs. We need to
  * simulate the call stack as part of the analysis. This is the model for the
  * stack simulation. */
@@ -226,6 +263,7 @@ struct MVMSpeshSimCallType {
 
 void MVM_spesh_stats_update(MVMThreadContext *tc, MVMSpeshLog *sl, MVMObject *sf_updated);
 void MVM_spesh_stats_cleanup(MVMThreadContext *tc, MVMObject *check_frames);
+MVMObject * MVM_spesh_stats_memory(MVMThreadContext *tc);
 void MVM_spesh_stats_gc_mark(MVMThreadContext *tc, MVMSpeshStats *ss, MVMGCWorklist *worklist);
 void MVM_spesh_stats_destroy(MVMThreadContext *tc, MVMSpeshStats *ss);
 void MVM_spesh_sim_stack_gc_mark(MVMThreadContext *tc, MVMSpeshSimStack *sims,
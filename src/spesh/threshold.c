@@ -1,5 +1,18 @@
 #include "moar.h"
 
+/* Applies the configured threshold scale, and the adaptive adjustment to it
+ * if that's enabled, to a threshold. Never goes below 1, nor above the most
+ * a frame can be logged. */
+static MVMuint32 scale_threshold(MVMThreadContext *tc, MVMuint32 threshold) {
+    MVMInstance *instance = tc->instance;
+    MVMuint64 scaled = (MVMuint64)threshold * instance->spesh_threshold_scale / 100;
+    if (instance->spesh_threshold_adaptive)
+        scaled = scaled * MVM_load(&(instance->spesh_threshold_adapt)) / 100;
+    if (scaled > MVM_SPESH_THRESHOLD_MAX)
+        return MVM_SPESH_THRESHOLD_MAX;
+    return scaled > 1 ? (MVMuint32)scaled : 1;
+}
+
 /* Choose the threshold for a given static frame before we start applying
  * specialization to it. */
 MVMuint32 MVM_spesh_threshold(MVMThreadContext *tc, MVMStaticFrame *sf) {
@@ -7,13 +20,42 @@ MVMuint32 MVM_spesh_threshold(MVMThreadContext *tc, MVMStaticFrame *sf) {
     if (tc->instance->spesh_nodelay)
         return 1;
     if (bs <= 256)
-        return 100;
+        return scale_threshold(tc, 100);
     else if (bs <= 512)
-        return 150;
+        return scale_threshold(tc, 150);
     else if (bs <= 2048)
-        return 200;
+        return scale_threshold(tc, 200);
     else if (bs <= 8192)
-        return 250;
+        return scale_threshold(tc, 250);
     else
-        return 300;
+        return scale_threshold(tc, 300);
+}
+
+/* Choose the number of OSR hits a static frame, or a callsite of it, must
+ * get before we consider specializing it. */
+MVMuint32 MVM_spesh_threshold_osr(MVMThreadContext *tc) {
+    return scale_threshold(tc, tc->instance->spesh_osr_threshold);
+}
+
+/* Adjusts the thresholds in adaptive mode, given the number of logs still
+ * waiting in the queue after the worker took one. If none are waiting then
+ * the worker is keeping up, and so can afford to specialize more eagerly; if
+ * a backlog has built up then we raise the thresholds so it can catch up. */
+void MVM_spesh_threshold_adapt(MVMThreadContext *tc, MVMuint64 waiting) {
+    MVMInstance *instance = tc->instance;
+    AO_t old_adapt, adapt;
+    do {
+        old_adapt = adapt = MVM_load(&(instance->spesh_threshold_adapt));
+        if (waiting == 0) {
+            adapt -= adapt / 16;
+            if (adapt < MVM_SPESH_THRESHOLD_ADAPT_MIN)
+                adapt = MVM_SPESH_THRESHOLD_ADAPT_MIN;
+        }
+        else if (waiting >= MVM_SPESH_THRESHOLD_BACKLOG) {
+            adapt += adapt / 4;
+            if (adapt > MVM_SPESH_THRESHOLD_ADAPT_MAX)
+                adapt = MVM_SPESH_THRESHOLD_ADAPT_MAX;
+        }
+    } while (adapt != old_adapt &&
+             MVM_cas(&(instance->spesh_threshold_adapt), old_adapt, adapt) != old_adapt);
 }
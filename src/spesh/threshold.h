@@ -1,4 +1,19 @@
 /* The maximum size of bytecode we'll ever attempt to optimize. */
 #define MVM_SPESH_MAX_BYTECODE_SIZE 65536
 
+/* The bounds, as percentages, that adaptive mode may move the thresholds
+ * within, and the number of logs waiting for the worker at which we consider
+ * it to be backed up. */
+#define MVM_SPESH_THRESHOLD_ADAPT_MIN   25
+#define MVM_SPESH_THRESHOLD_ADAPT_MAX   400
+#define MVM_SPESH_THRESHOLD_BACKLOG     4
+
+/* The most calls or OSR hits we'll ever require, however the thresholds are
+ * scaled. A frame stops being logged after MVM_SPESH_LOG_LOGGED_ENOUGH
+ * entries, so a threshold near or above that could never be reached; we
+ * leave room for the entries being spread over callsites and types. */
+#define MVM_SPESH_THRESHOLD_MAX (MVM_SPESH_LOG_LOGGED_ENOUGH * 3 / 4)
+
 MVMuint32 MVM_spesh_threshold(MVMThreadContext *tc, MVMStaticFrame *sf);
+MVMuint32 MVM_spesh_threshold_osr(MVMThreadContext *tc);
+void MVM_spesh_threshold_adapt(MVMThreadContext *tc, MVMuint64 waiting);
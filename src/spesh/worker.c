@@ -4,6 +4,99 @@
  * calls and types that showed up at runtime. It uses this to produce
  * specialized versions of code. */
 
+/* Implements entries of the current wave of the specialization plan, until
+ * there are none left to take. May be run by the worker and any helpers at
+ * the same time, each taking the next entry not yet claimed. */
+static void implement_plan(MVMThreadContext *tc) {
+    MVMSpeshPlan *plan = tc->instance->spesh_plan;
+    MVMuint32 end = tc->instance->spesh_plan_wave_end;
+    MVMuint32 i;
+    while ((i = (MVMuint32)MVM_incr(&(tc->instance->spesh_plan_next))) < end) {
+        MVM_spesh_candidate_add(tc, &(plan->planned[i]));
+        GC_SYNC_POINT(tc);
+    }
+}
+
+/* Takes the plan mutex, marking the thread blocked while waiting for it so
+ * that we don't hold up GC. */
+static void lock_plan(MVMThreadContext *tc) {
+    MVM_gc_mark_thread_blocked(tc);
+    uv_mutex_lock(&(tc->instance->mutex_spesh_plan));
+    MVM_gc_mark_thread_unblocked(tc);
+}
+
+/* Waits on the plan condition variable; must hold the plan mutex. */
+static void wait_plan(MVMThreadContext *tc) {
+    MVM_gc_mark_thread_blocked(tc);
+    uv_cond_wait(&(tc->instance->cond_spesh_plan), &(tc->instance->mutex_spesh_plan));
+    MVM_gc_mark_thread_unblocked(tc);
+}
+
+/* Implements the plan entries from start up to end, with the help of any
+ * helper workers if there is more than one, and waits for them all to
+ * finish. */
+static void implement_wave(MVMThreadContext *tc, MVMuint32 start, MVMuint32 end) {
+    MVMInstance *instance = tc->instance;
+    MVMuint32 helpers = end - start > 1
+        ? instance->spesh_workers - 1
+        : 0;
+    MVM_store(&(instance->spesh_plan_next), start);
+    instance->spesh_plan_wave_end = end;
+    if (helpers) {
+        lock_plan(tc);
+        instance->spesh_plan_seq++;
+        instance->spesh_plan_helpers_busy = helpers;
+        uv_cond_broadcast(&(instance->cond_spesh_plan));
+        uv_mutex_unlock(&(instance->mutex_spesh_plan));
+    }
+    implement_plan(tc);
+    if (helpers) {
+        lock_plan(tc);
+        while (instance->spesh_plan_helpers_busy)
+            wait_plan(tc);
+        uv_mutex_unlock(&(instance->mutex_spesh_plan));
+    }
+}
+
+/* Implements the current plan. It is sorted deepest call depth first, so
+ * callees come before their callers; we keep that order by doing each run
+ * of entries with the same depth as a wave, and only starting the next one
+ * once it is complete. That way, inlining sees the same installed callee
+ * candidates no matter how the work was shared out. */
+static void implement_plan_with_helpers(MVMThreadContext *tc) {
+    MVMSpeshPlan *plan = tc->instance->spesh_plan;
+    MVMuint32 start = 0;
+    while (start < plan->num_planned) {
+        MVMuint32 end = start + 1;
+        while (end < plan->num_planned &&
+                plan->planned[end].max_depth == plan->planned[start].max_depth)
+            end++;
+        implement_wave(tc, start, end);
+        start = end;
+    }
+}
+
+/* Enters the work loop of a helper worker, which waits for a new plan to be
+ * made and then helps implement it. */
+static void helper(MVMThreadContext *tc, MVMCallsite *callsite, MVMRegister *args) {
+    MVMInstance *instance = tc->instance;
+    MVMuint32 seen_seq = 0;
+    while (1) {
+        lock_plan(tc);
+        while (instance->spesh_plan_seq == seen_seq)
+            wait_plan(tc);
+        seen_seq = instance->spesh_plan_seq;
+        uv_mutex_unlock(&(instance->mutex_spesh_plan));
+
+        implement_plan(tc);
+
+        lock_plan(tc);
+        instance->spesh_plan_helpers_busy--;
+        uv_cond_broadcast(&(instance->cond_spesh_plan));
+        uv_mutex_unlock(&(instance->mutex_spesh_plan));
+    }
+}
+
 /* Enters the work loop. */
 static void worker(MVMThreadContext *tc, MVMCallsite *callsite, MVMRegister *args) {
     MVMObject *updated_static_frames = MVM_repr_alloc_init(tc,
@@ -19,6 +112,8 @@ static void worker(MVMThreadContext *tc, MVMCallsite *callsite, MVMRegister *arg
             if (tc->instance->spesh_log_fh)
                 start_time = uv_hrtime();
             log_obj = MVM_repr_shift_o(tc, tc->instance->spesh_queue);
+            if (tc->instance->spesh_threshold_adaptive)
+                MVM_spesh_threshold_adapt(tc, MVM_repr_elems(tc, tc->instance->spesh_queue));
             if (tc->instance->spesh_log_fh) {
                 fprintf(tc->instance->spesh_log_fh,
                     "Received Logs\n"
@@ -87,11 +182,7 @@ static void worker(MVMThreadContext *tc, MVMCallsite *callsite, MVMRegister *arg
                     GC_SYNC_POINT(tc);
 
                     /* Implement the plan and then discard it. */
-                    n = tc->instance->spesh_plan->num_planned;
-                    for (i = 0; i < n; i++) {
-                        MVM_spesh_candidate_add(tc, &(tc->instance->spesh_plan->planned[i]));
-                        GC_SYNC_POINT(tc);
-                    }
+                    implement_plan_with_helpers(tc);
                     MVM_spesh_plan_destroy(tc, tc->instance->spesh_plan);
                     tc->instance->spesh_plan = NULL;
 
@@ -140,12 +231,20 @@ static void worker(MVMThreadContext *tc, MVMCallsite *callsite, MVMRegister *arg
     });
 }
 
+/* Starts the specialization worker, along with any helper workers. */
 void MVM_spesh_worker_setup(MVMThreadContext *tc) {
     if (tc->instance->spesh_enabled) {
         MVMObject *worker_entry_point;
+        MVMuint32 i;
         tc->instance->spesh_queue = MVM_repr_alloc_init(tc, tc->instance->boot_types.BOOTQueue);
         worker_entry_point = MVM_repr_alloc_init(tc, tc->instance->boot_types.BOOTCCode);
         ((MVMCFunction *)worker_entry_point)->body.func = worker;
         MVM_thread_run(tc, MVM_thread_new(tc, worker_entry_point, 1));
+        for (i = 1; i < tc->instance->spesh_workers; i++) {
+            MVMObject *helper_entry_point = MVM_repr_alloc_init(tc,
+                tc->instance->boot_types.BOOTCCode);
+            ((MVMCFunction *)helper_entry_point)->body.func = helper;
+            MVM_thread_run(tc, MVM_thread_new(tc, helper_entry_point, 1));
+        }
     }
 }
@@ -56,6 +56,7 @@ typedef struct MVMFrameHandler MVMFrameHandler;
 typedef struct MVMGen2Allocator MVMGen2Allocator;
 typedef struct MVMGen2SizeClass MVMGen2SizeClass;
 typedef struct MVMGCPassedWork MVMGCPassedWork;
+typedef struct MVMGCStats MVMGCStats;
 typedef struct MVMGCWorklist MVMGCWorklist;
 typedef struct MVMHash MVMHash;
 typedef struct MVMHashAttrStore MVMHashAttrStore;
@@ -72,6 +73,7 @@ typedef struct MVMKnowHOWAttributeREPR MVMKnowHOWAttributeREPR;
 typedef struct MVMKnowHOWAttributeREPRBody MVMKnowHOWAttributeREPRBody;
 typedef struct MVMKnowHOWREPR MVMKnowHOWREPR;
 typedef struct MVMKnowHOWREPRBody MVMKnowHOWREPRBody;
+typedef struct MVMLargeObject MVMLargeObject;
 typedef struct MVMLexicalRegistry MVMLexicalRegistry;
 typedef struct MVMLoadedCompUnitName MVMLoadedCompUnitName;
 typedef struct MVMNFA MVMNFA;
@@ -170,6 +172,7 @@ typedef struct MVMSpeshAnn MVMSpeshAnn;
 typedef struct MVMSpeshFacts MVMSpeshFacts;
 typedef struct MVMSpeshCode MVMSpeshCode;
 typedef struct MVMSpeshCandidate MVMSpeshCandidate;
+typedef struct MVMSpeshAllocSample MVMSpeshAllocSample;
 typedef struct MVMSpeshLogGuard MVMSpeshLogGuard;
 typedef struct MVMSpeshCallInfo MVMSpeshCallInfo;
 typedef struct MVMSpeshInline MVMSpeshInline;
@@ -177,6 +180,7 @@ typedef struct MVMSpeshLog MVMSpeshLog;
 typedef struct MVMSpeshLogBody MVMSpeshLogBody;
 typedef struct MVMSpeshLogEntry MVMSpeshLogEntry;
 typedef struct MVMSpeshStats MVMSpeshStats;
+typedef struct MVMSpeshStatsAllocSite MVMSpeshStatsAllocSite;
 typedef struct MVMSpeshStatsByCallsite MVMSpeshStatsByCallsite;
 typedef struct MVMSpeshStatsByType MVMSpeshStatsByType;
 typedef struct MVMSpeshStatsType MVMSpeshStatsType;
@@ -192,6 +196,10 @@ typedef struct MVMSpeshPlan MVMSpeshPlan;
 typedef struct MVMSpeshPlanned MVMSpeshPlanned;
 typedef struct MVMSpeshArgGuard MVMSpeshArgGuard;
 typedef struct MVMSpeshArgGuardNode MVMSpeshArgGuardNode;
+typedef struct MVMSpeshCache MVMSpeshCache;
+typedef struct MVMSpeshCacheRecord MVMSpeshCacheRecord;
+typedef struct MVMSpeshCacheHandle MVMSpeshCacheHandle;
+typedef struct MVMSpeshCacheResolved MVMSpeshCacheResolved;
 typedef struct MVMSTable MVMSTable;
 typedef struct MVMStaticFrame MVMStaticFrame;
 typedef struct MVMStaticFrameBody MVMStaticFrameBody;
@@ -246,6 +254,12 @@ typedef struct MVMJitJumpList MVMJitJumpList;
 typedef struct MVMJitControl MVMJitControl;
 typedef struct MVMJitData MVMJitData;
 typedef struct MVMJitCode MVMJitCode;
+typedef struct MVMJitExprNode MVMJitExprNode;
+typedef struct MVMJitExprValue MVMJitExprValue;
+typedef struct MVMJitExprTree MVMJitExprTree;
+typedef struct MVMJitHeap MVMJitHeap;
+typedef struct MVMJitHeapChunk MVMJitHeapChunk;
+typedef struct MVMJitHeapBlock MVMJitHeapBlock;
 typedef struct MVMProfileThreadData MVMProfileThreadData;
 typedef struct MVMProfileGC MVMProfileGC;
 typedef struct MVMProfileCallNode MVMProfileCallNode;